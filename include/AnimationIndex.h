@@ -0,0 +1,86 @@
+#ifndef CLASS_ANIMATIONINDEX
+#define CLASS_ANIMATIONINDEX
+
+#include <nctl/Array.h>
+#include <nctl/HashMap.h>
+
+class CurveAnimation;
+
+/// The index from an object to the animations that refer to it
+template <class K>
+class AnimationIndex
+{
+  public:
+	explicit AnimationIndex(unsigned int capacity)
+	    : hashMap_(capacity)
+	{
+	}
+
+	void add(const K *key, CurveAnimation *anim)
+	{
+		unsigned int *listIndex = hashMap_.find(key);
+		if (listIndex == nullptr)
+		{
+			// Lists of objects without animations are recycled
+			unsigned int newIndex = lists_.size();
+			if (freeLists_.isEmpty() == false)
+			{
+				newIndex = freeLists_.back();
+				freeLists_.popBack();
+			}
+			else
+				lists_.pushBack(nctl::Array<CurveAnimation *>());
+
+			if ((hashMap_.size() + 1) * 2 > hashMap_.capacity())
+				hashMap_.rehash(hashMap_.capacity() * 2);
+			hashMap_.insert(key, newIndex);
+			listIndex = hashMap_.find(key);
+		}
+
+		lists_[*listIndex].pushBack(anim);
+	}
+
+	void remove(const K *key, CurveAnimation *anim)
+	{
+		const unsigned int *listIndex = hashMap_.find(key);
+		if (listIndex == nullptr)
+			return;
+
+		nctl::Array<CurveAnimation *> &list = lists_[*listIndex];
+		for (unsigned int i = 0; i < list.size(); i++)
+		{
+			if (list[i] == anim)
+			{
+				list[i] = list.back();
+				list.popBack();
+				break;
+			}
+		}
+
+		if (list.isEmpty())
+		{
+			freeLists_.pushBack(*listIndex);
+			hashMap_.remove(key);
+		}
+	}
+
+	/// Copies the animations that refer to the object, as the index can change while they are being modified
+	void find(const K *key, nctl::Array<CurveAnimation *> &anims) const
+	{
+		anims.clear();
+		const unsigned int *listIndex = hashMap_.find(key);
+		if (listIndex == nullptr)
+			return;
+
+		const nctl::Array<CurveAnimation *> &list = lists_[*listIndex];
+		for (unsigned int i = 0; i < list.size(); i++)
+			anims.pushBack(list[i]);
+	}
+
+  private:
+	nctl::HashMap<const K *, unsigned int> hashMap_;
+	nctl::Array<nctl::Array<CurveAnimation *>> lists_;
+	nctl::Array<unsigned int> freeLists_;
+};
+
+#endif
@@ -3,9 +3,11 @@
 
 #include <nctl/UniquePtr.h>
 #include "AnimationGroup.h"
+#include "AnimationIndex.h"
 
 class Sprite;
 class Script;
+class CurveAnimation;
 
 /// The animation manager class
 class AnimationManager
@@ -41,8 +43,16 @@ class AnimationManager
 	void overrideSprite(AnimationGroup &animGroup, Sprite *sprite);
 	void cloneSpriteAnimations(const Sprite *fromSprite, Sprite *toSprite);
 
+	/// Called by an animation when it changes sprite
+	void updateSpriteIndex(CurveAnimation *anim, const Sprite *prevSprite, const Sprite *sprite);
+	/// Called by a script animation when it changes script
+	void updateScriptIndex(CurveAnimation *anim, const Script *prevScript, const Script *script);
+
   private:
 	float speedMultiplier_;
+	/// Declared before the root group so that they outlive the animations unregistering themselves
+	AnimationIndex<Sprite> spriteIndex_;
+	AnimationIndex<Script> scriptIndex_;
 	nctl::UniquePtr<AnimationGroup> animGroup_;
 };
 
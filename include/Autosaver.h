@@ -0,0 +1,59 @@
+#ifndef CLASS_AUTOSAVER
+#define CLASS_AUTOSAVER
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <nctl/String.h>
+#include <nctl/UniquePtr.h>
+#include <ncine/TimeStamp.h>
+#include "LuaSaver.h"
+
+namespace nc = ncine;
+
+/// The class that periodically saves a snapshot of the project without blocking the user interface
+/*! The snapshot is a binary encoding of the whole project, produced on the main thread.
+ *  A background thread writes it to a temporary file that is then renamed over the destination.
+ *  Nothing is written until the project differs from the one passed to `reset()`. */
+class Autosaver
+{
+  public:
+	enum class Result
+	{
+		NONE,
+		SAVED,
+		FAILED
+	};
+
+	Autosaver();
+	~Autosaver();
+
+	/// Sets the file for the snapshots of a newly opened or saved project, whose current state is not written
+	void reset(const char *filename, const LuaSaver::Data &data);
+	/// Takes a snapshot of the project if the interval in seconds has elapsed and the project has changed
+	void update(float interval, const LuaSaver::Data &data);
+	/// Returns the result of the last write, only once
+	Result consumeResult();
+
+	inline const nctl::String &filename() const { return filename_; }
+
+  private:
+	nc::TimeStamp lastSnapshot_;
+
+	/// The last snapshot, owned by the writer thread while `isWriting_` is true
+	nctl::UniquePtr<unsigned char[]> buffer_;
+	unsigned long int bufferSize_;
+	nctl::String filename_;
+
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	bool isWriting_;
+	bool shouldQuit_;
+	Result result_;
+
+	void writerLoop();
+	bool write();
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef CLASS_BINARYSAVER
+#define CLASS_BINARYSAVER
+
+#include "LuaSaver.h"
+
+/// The class that saves and loads projects in a flat binary format that can be memory-mapped
+class BinarySaver
+{
+  public:
+	/// The file extension of binary projects
+	static const char *Extension;
+
+	/// Returns true if the file name has the binary project extension
+	static bool isBinaryProject(const char *filename);
+
+	bool load(const char *filename, LuaSaver::Data &data);
+	bool save(const char *filename, const LuaSaver::Data &data);
+
+	/// Encodes the project in memory, returns the number of bytes of the encoded buffer
+	static unsigned long int encode(const LuaSaver::Data &data, nctl::UniquePtr<unsigned char[]> &buffer);
+	/// Decodes a project from memory, leaving the managers untouched if the buffer is not valid
+	static bool decode(const unsigned char *buffer, unsigned long int size, LuaSaver::Data &data);
+};
+
+#endif
@@ -12,7 +12,7 @@ namespace nc = ncine;
 /// The configuration to be loaded or saved
 struct Configuration
 {
-	const int version = 6;
+	const int version = 11;
 
 	int width = 1280;
 	int height = 720;
@@ -43,6 +43,15 @@ struct Configuration
 
 	bool showTipsOnStart = true; // Added in version 4
 	nctl::Array<nctl::String> pinnedDirectories; // Added in version 5
+
+	bool parallelScripts = false; // Added in version 7
+	int numScriptWorkers = 0; // Added in version 7
+	int scriptInstructionBudget = 100; // In millions of instructions per call, added in version 8
+	int scriptTimeBudget = 2000; // In milliseconds per call, added in version 8
+
+	int autosaveInterval = 60; // In seconds, zero disables autosave, added in version 9
+	bool watchFiles = true; // Added in version 10
+	bool compactVertices = true; // Added in version 11
 };
 
 #endif
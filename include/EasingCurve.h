@@ -18,6 +18,8 @@ class EasingCurve
 		EXPO,
 		CIRC,
 	};
+	/// Number of values in the `Type` enumeration
+	static const unsigned int NumTypes = static_cast<unsigned int>(Type::CIRC) + 1;
 
 	EasingCurve(Type type, Loop::Mode loopMode);
 
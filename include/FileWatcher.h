@@ -0,0 +1,71 @@
+#ifndef CLASS_FILEWATCHER
+#define CLASS_FILEWATCHER
+
+#include <thread>
+#include <mutex>
+#include <nctl/Array.h>
+#include <nctl/String.h>
+#include <ncine/TimeStamp.h>
+
+namespace nc = ncine;
+
+/// A thread waiting for changes to a set of files, the changes are collected on the main thread
+class FileWatcher
+{
+  public:
+#if defined(__linux__)
+	static const bool IsSupported = true;
+#else
+	static const bool IsSupported = false;
+#endif
+	/// Seconds without new events before a change is reported
+	static const float DebounceTime;
+
+	FileWatcher();
+	~FileWatcher();
+
+	/// Replaces the set of watched files, nothing is done if it has not changed
+	void setFiles(const nctl::Array<const char *> &filenames);
+	/// Retrieves the files that have not changed again for at least `DebounceTime` seconds
+	void poll(nctl::Array<nctl::String> &changedFiles);
+
+  private:
+	struct WatchedFile
+	{
+		nctl::String filename;
+		/// The name reported by the events on the directory
+		nctl::String baseName;
+		int watchDescriptor;
+	};
+
+	struct Directory
+	{
+		nctl::String path;
+		int watchDescriptor;
+	};
+
+	struct Change
+	{
+		nctl::String filename;
+		nc::TimeStamp lastEvent;
+	};
+
+	int inotifyFd_;
+	/// Signaled by the destructor to wake up the watcher thread
+	int wakeUpFd_;
+
+	std::thread thread_;
+	/// Protects the files and the changes, shared with the watcher thread
+	std::mutex mutex_;
+	/// The files passed to the last call to `setFiles()`, including the ones that could not be watched
+	nctl::Array<nctl::String> requestedFiles_;
+	nctl::Array<WatchedFile> files_;
+	nctl::Array<Directory> directories_;
+	nctl::Array<Change> changes_;
+
+	void watcherLoop();
+	/// Records an event for a file in a watched directory, must be called with the mutex locked
+	void recordEvent(int watchDescriptor, const char *name);
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef CLASS_FRAMEPROFILER
+#define CLASS_FRAMEPROFILER
+
+#include <thread>
+#include <nctl/Array.h>
+#include <ncine/TimeStamp.h>
+
+namespace nc = ncine;
+
+/// The class that collects the nested timings of the last frames, scopes opened outside of the main thread are ignored
+class FrameProfiler
+{
+  public:
+	static const unsigned int HistoryLength = 120;
+	static const unsigned int MaxNameLength = 32;
+	/// Scopes opened after this number in a single frame are not recorded
+	static const unsigned int MaxScopesPerFrame = 1024;
+
+	struct Scope
+	{
+		char name[MaxNameLength];
+		unsigned int depth;
+		/// In milliseconds since the start of the frame
+		float start;
+		float duration;
+	};
+
+	struct Frame
+	{
+		nctl::Array<Scope> scopes;
+		/// In seconds since the first profiled frame
+		double startTime = 0.0;
+		/// In milliseconds
+		float cpuTime = 0.0f;
+		/// Milliseconds spent by the GPU on the canvas pass, zero if not available
+		float gpuTime = 0.0f;
+	};
+
+	static void beginFrame();
+	static void endFrame();
+
+	static void beginScope(const char *name);
+	static void endScope();
+
+	/// Times the commands issued to the GPU between the two calls, results are read some frames later
+	static void beginGpuTimer();
+	static void endGpuTimer();
+
+	/// The last complete frame
+	static const Frame &lastFrame();
+	/// The frame that was completed a number of frames before the last one
+	static const Frame &frame(unsigned int age);
+	/// The number of complete frames available, one slot is used by the frame being recorded
+	inline static unsigned int numFrames() { return (numFrames_ < HistoryLength - 1) ? numFrames_ : HistoryLength - 1; }
+
+	/// Writes the recorded frames in the Trace Event Format read by Chrome and Perfetto
+	static bool saveChromeTrace(const char *filename);
+
+	/// Deletes the GPU queries, must be called while the OpenGL context is still alive
+	static void dispose();
+
+  private:
+	static Frame frames_[HistoryLength];
+	/// The slot of the frame currently being recorded
+	static unsigned int frameIndex_;
+	static unsigned int numFrames_;
+	static bool isInFrame_;
+	static nc::TimeStamp frameStart_;
+	static double elapsedTime_;
+	static std::thread::id mainThreadId_;
+	/// Indices of the scopes still open, or -1 for scopes that have not been recorded
+	static nctl::Array<int> openScopes_;
+
+	/// Static class, deleted constructor
+	FrameProfiler() = delete;
+	/// Static class, deleted copy constructor
+	FrameProfiler(const FrameProfiler &other) = delete;
+	/// Static class, deleted assignement operator
+	FrameProfiler &operator=(const FrameProfiler &other) = delete;
+
+	static void readGpuTimers();
+};
+
+/// Times the enclosing block
+class ProfileScope
+{
+  public:
+	explicit ProfileScope(const char *name) { FrameProfiler::beginScope(name); }
+	~ProfileScope() { FrameProfiler::endScope(); }
+};
+
+#endif
@@ -15,6 +15,10 @@ class GridAnimation : public CurveAnimation
   public:
 	GridAnimation();
 	GridAnimation(Sprite *sprite);
+	~GridAnimation() override;
+
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr, size_t size);
 
 	nctl::UniquePtr<IAnimation> clone() const override;
 
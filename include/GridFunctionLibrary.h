@@ -5,12 +5,27 @@
 
 namespace nc = ncine;
 
+class Sprite;
+
 class GridFunctionLibrary
 {
   public:
 	static void init();
 	static const nctl::Array<GridFunction> &gridFunctions() { return gridFunctions_; }
 
+	/// Grid deformation kernels shared by the grid functions and the scripting API
+	static void applyWaveX(Sprite &sprite, float value, float amplitude, float frequency, float py);
+	static void applyWaveY(Sprite &sprite, float value, float amplitude, float frequency, float px);
+	static void applySkewX(Sprite &sprite, float value, float py);
+	static void applySkewY(Sprite &sprite, float value, float px);
+	static void applyZoom(Sprite &sprite, float value, float px, float py);
+	/// Displaces every vertex by a deterministic pseudo-random offset
+	static void applyNoise(Sprite &sprite, float amount, unsigned int seed);
+	/// Transforms every vertex by the `{ a, b, c, d, tx, ty }` affine matrix
+	static void applyAffine(Sprite &sprite, const float matrix[6]);
+	/// Moves every vertex toward its rest position by the specified factor
+	static void lerpToRest(Sprite &sprite, float factor);
+
   private:
 	static nctl::Array<GridFunction> gridFunctions_;
 };
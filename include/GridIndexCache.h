@@ -0,0 +1,49 @@
+#ifndef CLASS_GRIDINDEXCACHE
+#define CLASS_GRIDINDEXCACHE
+
+#include <cstdint>
+#include <nctl/Array.h>
+#include <nctl/HashMap.h>
+#include <nctl/UniquePtr.h>
+
+namespace ncine {
+
+class GLBufferObject;
+
+}
+
+namespace nc = ncine;
+
+/// The index buffers of grid meshes, shared by all the sprites with the same size
+class GridIndexCache
+{
+  public:
+	/// A triangle strip index buffer, reference counted by the sprites using it
+	struct Entry
+	{
+		Entry();
+		~Entry();
+
+		nctl::UniquePtr<nc::GLBufferObject> ibo;
+		int width;
+		int height;
+		unsigned int numIndices;
+		/// Indices are 16 bits wide when they all fit
+		bool shortIndices;
+		unsigned int refCount;
+	};
+
+	GridIndexCache();
+
+	/// Returns the buffer for a grid of this size, uploading a new one if there is none
+	Entry *acquire(int width, int height);
+	void release(Entry *entry);
+
+	inline unsigned int numEntries() const { return entries_.size(); }
+
+  private:
+	nctl::Array<nctl::UniquePtr<Entry>> entries_;
+	nctl::HashMap<uint64_t, Entry *> hashMap_;
+};
+
+#endif
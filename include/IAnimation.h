@@ -1,6 +1,7 @@
 #ifndef CLASS_IANIMATION
 #define CLASS_IANIMATION
 
+#include <cstddef>
 #include <nctl/String.h>
 
 class AnimationGroup;
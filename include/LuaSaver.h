@@ -3,8 +3,12 @@
 
 #include <nctl/UniquePtr.h>
 #include <nctl/String.h>
+#include <nctl/Array.h>
 
 class LuaSerializer;
+class BinarySaver;
+class SpriteEntry;
+class IAnimation;
 class UserInterface;
 class Canvas;
 class SpriteManager;
@@ -28,9 +32,11 @@ class LuaSaver
 	};
 
 	LuaSaver(unsigned int bufferSize);
+	~LuaSaver();
 
 	bool load(const char *filename, Data &data);
-	void save(const char *filename, const Data &data);
+	/// Returns false if the file cannot be written, an existing file is then left untouched
+	bool save(const char *filename, const Data &data);
 
 	bool loadCfg(const char *filename, Configuration &cfg);
 	void saveCfg(const char *filename, const Configuration &cfg);
@@ -45,8 +51,15 @@ class LuaSaver
 	/// Saves the configuration using the default file
 	inline void saveCfg(const Configuration &cfg) { saveCfg(defaultCfgFile_.data(), cfg); }
 
+	/// Appends the sprite entry and all of its descendants in the order used by the project files
+	static void visitSpriteEntries(const SpriteEntry *spriteEntry, nctl::Array<const SpriteEntry *> &spriteEntries);
+	/// Appends the animation and all of its descendants in the order used by the project files
+	static void visitAnimations(const IAnimation *anim, nctl::Array<const IAnimation *> &anims);
+
   private:
 	nctl::UniquePtr<LuaSerializer> serializer_;
+	/// Projects with the binary extension are delegated to the binary saver
+	nctl::UniquePtr<BinarySaver> binarySaver_;
 	static nctl::String defaultCfgFile_;
 };
 
@@ -4,6 +4,7 @@
 #include <nctl/String.h>
 #include <nctl/Array.h>
 #include <nctl/HashMap.h>
+#include <nctl/UniquePtr.h>
 #include <ncine/LuaStateManager.h>
 #include <ncine/LuaUtils.h>
 
@@ -26,6 +27,8 @@ using Vector3f = Vector3<float>;
 class Color;
 class Colorf;
 
+class IFile;
+
 #ifdef __EMSCRIPTEN__
 class EmscriptenLocalFile;
 #endif
@@ -39,14 +42,20 @@ class LuaSerializer
 {
   public:
 	LuaSerializer(unsigned int bufferSize);
+	~LuaSerializer();
 
 	void reset();
+	/// Writes the buffer in chunks while serializing, instead of holding the whole text in memory
+	/*! The chunks go to a temporary file that only replaces the destination once it is complete.
+	 *  \returns False if the file cannot be opened or streaming is not supported */
+	bool openStream(const char *filename);
 
 	bool load(const char *filename);
 #ifdef __EMSCRIPTEN__
 	bool load(const char *filename, const nc::EmscriptenLocalFile *localFile);
 #endif
-	void save(const char *filename);
+	/// Saves the buffer to the file, or flushes the stream if one is open, returns false if the file cannot be written
+	bool save(const char *filename);
 
 	inline void setContext(void *context) { context_ = context; }
 	inline void *context() const { return context_; }
@@ -61,8 +70,16 @@ class LuaSerializer
   private:
 	nc::LuaStateManager luaState_;
 	nctl::String bufferString_;
+	/// The buffer is flushed to the stream when its length reaches this threshold
+	unsigned int flushThreshold_;
+	nctl::UniquePtr<nc::IFile> streamFile_;
+	nctl::String tempFilename_;
+	/// Set when a chunk could not be completely written to the stream
+	bool streamFailed_;
 	int indentAmount_;
 	void *context_;
+
+	void flushStream();
 };
 
 namespace Serializers {
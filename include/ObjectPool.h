@@ -0,0 +1,109 @@
+#ifndef CLASS_OBJECTPOOL
+#define CLASS_OBJECTPOOL
+
+#include <cstddef>
+#include <new>
+
+/// A free list allocator that stores the objects of a class contiguously in chunks
+/*! Classes use it through their own `operator new` and `operator delete`.
+ *  Objects of derived classes with a different size are allocated on the heap.
+ *  It is not thread-safe, objects should be created and destroyed on the main thread only. */
+template <class T>
+class ObjectPool
+{
+  public:
+	static const unsigned int ObjectsPerChunk = 128;
+
+	static void *allocate(size_t size)
+	{
+		if (size != sizeof(T))
+			return ::operator new(size);
+
+		if (state_.freeList == nullptr)
+			addChunk();
+
+		FreeBlock *block = state_.freeList;
+		state_.freeList = block->next;
+		state_.numObjects++;
+		return block;
+	}
+
+	static void deallocate(void *ptr, size_t size)
+	{
+		if (ptr == nullptr)
+			return;
+		if (size != sizeof(T))
+		{
+			::operator delete(ptr);
+			return;
+		}
+
+		FreeBlock *block = static_cast<FreeBlock *>(ptr);
+		block->next = state_.freeList;
+		state_.freeList = block;
+		state_.numObjects--;
+	}
+
+	/// Frees all chunks at once if no objects are left, like resetting an arena
+	static void release()
+	{
+		if (state_.numObjects > 0)
+			return;
+
+		Chunk *chunk = state_.chunks;
+		while (chunk != nullptr)
+		{
+			Chunk *next = chunk->next;
+			::operator delete(chunk);
+			chunk = next;
+		}
+		state_.chunks = nullptr;
+		state_.freeList = nullptr;
+	}
+
+	inline static unsigned int numObjects() { return state_.numObjects; }
+
+  private:
+	struct FreeBlock
+	{
+		FreeBlock *next;
+	};
+
+	struct Chunk
+	{
+		Chunk *next;
+	};
+
+	static const size_t BlockSize = (sizeof(T) > sizeof(FreeBlock)) ? sizeof(T) : sizeof(FreeBlock);
+	static const size_t HeaderSize = ((sizeof(Chunk) + alignof(T) - 1) / alignof(T)) * alignof(T);
+
+	/// Plain data without a destructor, objects can still be freed while static objects are destroyed
+	struct State
+	{
+		Chunk *chunks;
+		FreeBlock *freeList;
+		unsigned int numObjects;
+	};
+	static State state_;
+
+	static void addChunk()
+	{
+		unsigned char *memory = static_cast<unsigned char *>(::operator new(HeaderSize + BlockSize * ObjectsPerChunk));
+		Chunk *chunk = reinterpret_cast<Chunk *>(memory);
+		chunk->next = state_.chunks;
+		state_.chunks = chunk;
+
+		// Blocks are linked in address order, so that consecutive allocations are contiguous
+		for (int i = ObjectsPerChunk - 1; i >= 0; i--)
+		{
+			FreeBlock *block = reinterpret_cast<FreeBlock *>(memory + HeaderSize + i * BlockSize);
+			block->next = state_.freeList;
+			state_.freeList = block;
+		}
+	}
+};
+
+template <class T>
+typename ObjectPool<T>::State ObjectPool<T>::state_ = { nullptr, nullptr, 0 };
+
+#endif
@@ -7,6 +7,9 @@
 class ParallelAnimationGroup : public AnimationGroup
 {
   public:
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr, size_t size);
+
 	nctl::UniquePtr<IAnimation> clone() const override;
 
 	inline Type type() const override { return Type::PARALLEL_GROUP; }
@@ -37,6 +37,10 @@ class PropertyAnimation : public CurveAnimation
   public:
 	PropertyAnimation();
 	PropertyAnimation(Sprite *sprite);
+	~PropertyAnimation() override;
+
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr, size_t size);
 
 	nctl::UniquePtr<IAnimation> clone() const override;
 
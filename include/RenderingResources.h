@@ -18,6 +18,7 @@ class RenderingResources
   public:
 	static inline nc::GLShaderProgram *spriteShaderProgram() { return spriteShaderProgram_.get(); }
 	static inline nc::GLShaderProgram *meshSpriteShaderProgram() { return meshSpriteShaderProgram_.get(); }
+	static inline nc::GLShaderProgram *compactMeshSpriteShaderProgram() { return compactMeshSpriteShaderProgram_.get(); }
 	static inline const nc::Matrix4x4f &projectionMatrix() { return projectionMatrix_; }
 
 	static inline const nc::Vector2f &canvasSize() { return canvasSize_; }
@@ -29,6 +30,7 @@ class RenderingResources
   private:
 	static nctl::UniquePtr<nc::GLShaderProgram> spriteShaderProgram_;
 	static nctl::UniquePtr<nc::GLShaderProgram> meshSpriteShaderProgram_;
+	static nctl::UniquePtr<nc::GLShaderProgram> compactMeshSpriteShaderProgram_;
 
 	static nc::Vector2f canvasSize_;
 	static nc::Matrix4x4f projectionMatrix_;
@@ -2,7 +2,8 @@
 #define CLASS_SCRIPT
 
 #include <nctl/String.h>
-#include <ncine/LuaStateManager.h>
+#include <nctl/UniquePtr.h>
+#include <ncine/TimeStamp.h>
 
 struct lua_State;
 
@@ -10,32 +11,166 @@ class Sprite;
 
 namespace nc = ncine;
 
-/// The class representing a single Lua script
+/// The class representing a single Lua script, running in its own environment inside the shared state
 class Script
 {
   public:
+	/// The functions a script can define to be called by a script animation
+	enum class Function
+	{
+		INIT,
+		UPDATE
+	};
+
+	/// Execution statistics shown in the profiler window
+	struct Statistics
+	{
+		static const unsigned int HistoryLength = 120;
+
+		/// Milliseconds spent in the last `init` call
+		float initTime = 0.0f;
+		/// Milliseconds spent in all the `update` calls of each of the last frames
+		float updateTimes[HistoryLength] = {};
+		unsigned int historyIndex = 0;
+		float worstUpdateTime = 0.0f;
+
+		/// Number of calls made during the last frame
+		unsigned int numUpdateCalls = 0;
+		unsigned int numVertexGetterCalls = 0;
+		unsigned int numVertexSetterCalls = 0;
+		/// Number of writes to the shared globals made by the script while running on a worker
+		unsigned int numGlobalWrites = 0;
+
+		/// Bytes allocated in the shared Lua state when the script was last loaded
+		unsigned long int loadMemory = 0;
+
+		float lastUpdateTime() const;
+		float averageUpdateTime() const;
+	};
+
 	Script();
 	Script(const char *filename);
+	~Script();
 
 	inline bool canRun() const { return canRun_; }
 
 	inline const nctl::String &name() const { return name_; }
 	inline void setName(const nctl::String &name) { name_ = name; }
+	/// The file the script has been loaded from, the name can be relative to the scripts directory
+	inline const nctl::String &path() const { return path_; }
 
 	inline const char *errorMsg() const { return errorMessage_.data(); }
+	/// Returns true if the script has opted to keep running its `update` function while the sprite is culled
+	inline bool updateWhenCulled() const { return updateWhenCulled_; }
 
 	bool load(const char *filename);
+	/// Reloads the script only if its source code has changed
 	bool reload();
 
+	inline const Statistics &statistics() const { return statistics_; }
+	void resetStatistics();
+	/// Stores the counters of the current frame in the statistics history
+	void updateStatistics();
+
+	void recordCall(Function function, float milliseconds);
+	inline void countVertexGetterCall() { frameCounters_.numVertexGetterCalls++; }
+	inline void countVertexSetterCall() { frameCounters_.numVertexSetterCalls++; }
+	inline void countGlobalWrite() { statistics_.numGlobalWrites++; }
+
+	/// Returns true only once after the script has been disabled for exceeding its budget
+	bool consumeDisabledNotice();
+	/// Subtracts a cost in instructions from the budget of the running call, returns false if it has been exceeded
+	bool chargeBudget(unsigned int cost);
+
+	/// Sets the directory for the compiled bytecode cache, an empty string disables it
+	/*! Files left by interrupted writes are removed, and the whole cache is cleared if it has grown too much */
+	static void setCacheDirectory(const char *directory);
+	/// Sets the limits for a single call, zero disables a limit
+	static void setBudget(unsigned long int maxInstructions, float maxMilliseconds);
+	inline static unsigned long int maxInstructions() { return maxInstructions_; }
+	inline static float maxMilliseconds() { return maxMilliseconds_; }
+
+	/// The instruction cost of reading or writing a vertex with the bulk functions
+	static const unsigned int VertexCost = 8;
+
   private:
+	/// A Lua state where the script chunk has been run, with the references to what it defined
+	struct Context
+	{
+		Context();
+
+		lua_State *luaState;
+		/// The hash of the source code that has been run in this state
+		uint64_t sourceHash;
+		/// Registry reference to the environment table of the script
+		int envRef;
+		/// Registry references to the functions defined by the script
+		int functionRefs[2];
+	};
+
 	bool canRun_;
 	nctl::String name_;
+	nctl::String path_;
 	nctl::String errorMessage_;
-	nc::LuaStateManager luaState_;
+	/// The hash of the source code that has been loaded
+	uint64_t sourceHash_;
+	/// The compiled bytecode of the current source code, empty if the cache is disabled
+	nctl::String cacheFilename_;
+	/// A copy of the source code, to run the chunk again in a worker state
+	nctl::UniquePtr<char[]> source_;
+	unsigned long int sourceSize_;
+	nctl::String chunkName_;
+
+	/// The context in the Lua state shared by all scripts, owned by the script manager
+	Context context_;
+	/// The context in the state of the worker the script is bound to in parallel execution mode
+	Context workerContext_;
+	/// The index of the worker the script is bound to, or -1 if it has not been bound yet
+	int workerIndex_;
+	bool updateWhenCulled_;
+
+	Statistics statistics_;
+	struct FrameCounters
+	{
+		float updateTime = 0.0f;
+		unsigned int numUpdateCalls = 0;
+		unsigned int numVertexGetterCalls = 0;
+		unsigned int numVertexSetterCalls = 0;
+	} frameCounters_;
+
+	/// The budget of the call that is currently running
+	struct Budget
+	{
+		long long int instructionsLeft = 0;
+		nc::TimeStamp startTime;
+		bool isActive = false;
+		bool isExceeded = false;
+	} budget_;
+	bool disabledNotice_;
+
+	static nctl::String cacheDirectory_;
+	static unsigned long int maxInstructions_;
+	static float maxMilliseconds_;
 
-	bool run(const char *filename, const char *chunkName);
+	bool run(const char *source, unsigned long int size, const char *chunkName);
+	bool runInContext(Context &context, nctl::String &errorMessage);
+	/// Releases the registry references to the environment and to the functions
+	void releaseContext(Context &context);
+	/// Loads the cached bytecode if it is intact, or compiles the source code and caches the result
+	bool loadChunk(lua_State *L, const char *source, unsigned long int size, const char *chunkName, nctl::String &errorMessage);
+	/// Calls a function of the script for the sprite, returns false and formats the error message on failure
+	bool callFunction(Context &context, Function function, Sprite *sprite, float value, nctl::String &errorMessage);
+	/// Calls a function of the script in the state of a worker thread, running the chunk there first if needed
+	bool callFunctionInWorker(lua_State *workerState, Function function, Sprite *sprite, float value, nctl::String &errorMessage);
+	void beginBudget();
+	/// Ends the budget of the call, disabling the script if it has been exceeded
+	void endBudget(const nctl::String &errorMessage);
+	/// Forgets the worker context when the worker states are destroyed
+	void resetWorkerContext();
 
 	friend class ScriptAnimation;
+	friend class ScriptManager;
+	friend class ScriptWorkers;
 };
 
 #endif
@@ -2,9 +2,9 @@
 #define CLASS_SCRIPTANIMATION
 
 #include "CurveAnimation.h"
+#include "Script.h"
 
 class Sprite;
-class Script;
 
 /// The script animation class
 class ScriptAnimation : public CurveAnimation
@@ -12,6 +12,10 @@ class ScriptAnimation : public CurveAnimation
   public:
 	ScriptAnimation();
 	ScriptAnimation(Sprite *sprite, Script *script);
+	~ScriptAnimation() override;
+
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr, size_t size);
 
 	nctl::UniquePtr<IAnimation> clone() const override;
 
@@ -32,7 +36,7 @@ class ScriptAnimation : public CurveAnimation
 	Sprite *sprite_;
 	Script *script_;
 
-	bool runScript(const char *functionName, float value);
+	bool runScript(Script::Function function, float value);
 };
 
 #endif
@@ -2,11 +2,15 @@
 #define CLASS_SCRIPTMANAGER
 
 #include <nctl/Array.h>
+#include <nctl/UniquePtr.h>
+#include <ncine/LuaStateManager.h>
 
 struct lua_State;
+struct lua_Debug;
 
 class Sprite;
 class Script;
+class ScriptWorkers;
 
 namespace nc = ncine;
 
@@ -14,7 +18,14 @@ namespace nc = ncine;
 class ScriptManager
 {
   public:
-	ScriptManager() {}
+	ScriptManager();
+	~ScriptManager();
+
+	/// Returns the Lua state shared by all scripts
+	inline lua_State *luaState() { return luaState_.state(); }
+	/// Returns the number of bytes allocated by the shared Lua state
+	static unsigned long int heapSize(lua_State *L);
+	inline unsigned long int heapSize() { return heapSize(luaState_.state()); }
 
 	inline nctl::Array<nctl::UniquePtr<Script>> &scripts() { return scripts_; }
 	inline const nctl::Array<nctl::UniquePtr<Script>> &scripts() const { return scripts_; }
@@ -23,15 +34,62 @@ class ScriptManager
 
 	int scriptIndex(const Script *script) const;
 
-	static void pushSprite(lua_State *L, Sprite *sprite);
+	/// Closes the profiling frame of every script
+	void updateStatistics();
+
+	/// Runs independent script calls on worker threads, each one with its own Lua state
+	/*! Changing the mode runs the scripts and their `init` functions again in the Lua states that will call them.
+	 *  \param numWorkers The number of worker threads, zero to use one less than the available cores */
+	void setParallelExecution(bool enabled, unsigned int numWorkers);
+	/// Returns the worker pool, or `nullptr` if scripts run on the main thread
+	inline ScriptWorkers *workers() { return workers_.get(); }
+	/// Script calls made between the beginning and the end of a batch can be deferred and run concurrently
+	void beginBatch();
+	void endBatch();
+	inline bool isBatching() const { return isBatching_; }
+
+	/// Sets the sprite seen by the script functions, returning the previous one so that a nested call can restore it
+	static Sprite *pushSprite(lua_State *L, Sprite *sprite);
+	/// Sets the script charged for the running code, returning the previous one so that a nested call can restore it
+	static Script *pushScript(lua_State *L, Script *script);
+	/// Charges a cost in instructions to the running script, raising a Lua error if its budget has been exceeded
+	static void chargeBudget(lua_State *L, unsigned int cost);
+#if defined(WITH_LUAJIT)
+	/// Turns the JIT compiler off in every Lua state while a script budget is set, and back on when there is none
+	void updateJitMode();
+#endif
 
   private:
+	/// The state is declared before the scripts so that it outlives their registry references
+	nc::LuaStateManager luaState_;
+	/// Declared before the scripts for the same reason, their worker contexts reference the worker states
+	nctl::UniquePtr<ScriptWorkers> workers_;
+	bool isBatching_;
 	nctl::Array<nctl::UniquePtr<Script>> scripts_;
 
 	static Sprite *retrieveSprite(lua_State *L);
+	static Script *retrieveScript(lua_State *L);
+	static void countVertexGetterCall(lua_State *L);
+	static void countVertexSetterCall(lua_State *L);
+
+	/// Number of instructions between two calls of the budget hook
+	static const int BudgetHookInterval = 1000;
+	static void installBudgetHook(lua_State *L);
+	static void budgetHook(lua_State *L, lua_Debug *);
+	static void raiseBudgetError(lua_State *L);
+#if defined(WITH_LUAJIT)
+	static void setJitMode(lua_State *L);
+#endif
 
 	static void exposeConstants(lua_State *L);
 	static void exposeFunctions(lua_State *L);
+	static void exposeVertexView(lua_State *L);
+	static void exposeGridModule(lua_State *L);
+#if defined(WITH_LUAJIT)
+	static void exposeFfiHelpers(lua_State *L);
+	/// Returns the address of the vertices of the sprite to be cast by the FFI, followed by their number
+	static int verticesPointer(lua_State *L);
+#endif
 
 	static int canvasWidth(lua_State *L);
 	static int canvasHeight(lua_State *L);
@@ -66,6 +124,26 @@ class ScriptManager
 	static int verticesU(lua_State *L);
 	static int verticesV(lua_State *L);
 
+	/// Returns a userdata view to read and write the vertices of the sprite in place
+	static int vertexView(lua_State *L);
+	static int vertexViewSize(lua_State *L);
+	static int vertexViewGet(lua_State *L);
+	static int vertexViewGetXY(lua_State *L);
+	static int vertexViewGetUV(lua_State *L);
+	static int vertexViewSet(lua_State *L);
+	static int vertexViewSetXY(lua_State *L);
+	static int vertexViewSetUV(lua_State *L);
+
+	/// Functions of the `grid` module, they deform the vertices of the sprite natively
+	static int gridAddWaveX(lua_State *L);
+	static int gridAddWaveY(lua_State *L);
+	static int gridAddSkewX(lua_State *L);
+	static int gridAddSkewY(lua_State *L);
+	static int gridAddZoom(lua_State *L);
+	static int gridDisplaceByNoise(lua_State *L);
+	static int gridApplyAffine(lua_State *L);
+	static int gridLerpToRest(lua_State *L);
+
 	static int setPosition(lua_State *L);
 	static int setPositionX(lua_State *L);
 	static int setPositionY(lua_State *L);
@@ -92,6 +170,7 @@ class ScriptManager
 	static int setVerticesV(lua_State *L);
 
 	friend class Script;
+	friend class ScriptWorkers;
 };
 
 #endif
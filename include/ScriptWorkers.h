@@ -0,0 +1,87 @@
+#ifndef CLASS_SCRIPTWORKERS
+#define CLASS_SCRIPTWORKERS
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <nctl/Array.h>
+#include <nctl/String.h>
+#include <nctl/UniquePtr.h>
+#include <ncine/Rect.h>
+#include <ncine/LuaStateManager.h>
+#include "Script.h"
+
+class Sprite;
+
+namespace nc = ncine;
+
+/// A pool of threads, each one with its own Lua state, running independent script calls concurrently
+class ScriptWorkers
+{
+  public:
+	/// A call to a script function for a sprite
+	struct Job
+	{
+		Script *script;
+		Sprite *sprite;
+		Script::Function function;
+		float value;
+	};
+
+	explicit ScriptWorkers(unsigned int numWorkers);
+	~ScriptWorkers();
+
+	inline unsigned int numWorkers() const { return workers_.size(); }
+	inline lua_State *luaState(unsigned int index) { return workers_[index]->luaState->state(); }
+
+	/// Queues a call on the worker the script is bound to, it will run at the next flush
+	void submit(const Job &job);
+	/// Runs all queued calls and waits for their completion, then reports errors and new shared globals
+	void flush();
+
+	/// Records a texture rectangle change requested by a script running on a worker thread
+	/*! \returns False if the calling thread is not a worker, meaning the change can be applied immediately */
+	static bool deferTexRect(Sprite *sprite, const nc::Recti &texRect);
+
+  private:
+	struct DeferredTexRect
+	{
+		Sprite *sprite;
+		nc::Recti texRect;
+	};
+
+	struct Worker
+	{
+		ScriptWorkers *workers = nullptr;
+		nctl::UniquePtr<nc::LuaStateManager> luaState;
+		nctl::Array<Job> jobs;
+		/// Errors and new shared globals are reported by the main thread after a flush
+		nctl::Array<nctl::String> errors;
+		nctl::Array<nctl::String> warnings;
+		nctl::Array<DeferredTexRect> deferredTexRects;
+		/// The script that is currently running on the worker
+		Script *currentScript = nullptr;
+		std::thread thread;
+	};
+
+	nctl::Array<nctl::UniquePtr<Worker>> workers_;
+	/// Round-robin index used to bind new scripts to workers
+	unsigned int nextWorkerIndex_;
+
+	std::mutex mutex_;
+	std::condition_variable startCondition_;
+	std::condition_variable doneCondition_;
+	/// Incremented at each flush to wake up the workers
+	unsigned int generation_;
+	unsigned int numBusyWorkers_;
+	bool shouldQuit_;
+
+	static thread_local Worker *currentWorker_;
+
+	void workerLoop(Worker &worker);
+	void runJobs(Worker &worker);
+	void installGlobalsWatcher(Worker &worker);
+	static int globalWrite(lua_State *L);
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define CLASS_SERIALIZERS
 
 #include <nctl/UniquePtr.h>
+#include <nctl/String.h>
 
 class LuaSerializer;
 class Canvas;
@@ -45,6 +46,11 @@ void serialize(LuaSerializer &ls, const Configuration &cf);
 
 namespace Deserializers {
 
+/// Returns the path of a texture saved in a project, relative to the configuration or to the data directory if it exists there
+nctl::String resolveTexturePath(const char *textureName);
+/// Returns the path of a script saved in a project, relative to the configuration or to the data directory if it exists there
+nctl::String resolveScriptPath(const char *scriptName);
+
 bool deserialize(LuaSerializer &ls, const char *name, Canvas &canvas);
 void deserialize(LuaSerializer &ls, nctl::UniquePtr<Texture> &texture);
 void deserialize(LuaSerializer &ls, nctl::UniquePtr<SpriteEntry> &spriteEntry);
@@ -7,6 +7,7 @@
 #include <ncine/Matrix4x4.h>
 #include <ncine/Colorf.h>
 #include "SpriteEntry.h"
+#include "GridIndexCache.h"
 
 namespace ncine {
 
@@ -54,10 +55,20 @@ class Sprite : public SpriteEntry
 	nc::Vector2f gridAnchorPoint;
 
 	Sprite(Texture *texture);
+	~Sprite() override;
+
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr, size_t size);
 
 	nctl::UniquePtr<Sprite> clone() const;
 
-	void transform();
+	/// Marks the transformation to be computed again at the next update, together with the ones of the children
+	inline void markDirty() { dirty_ = true; }
+	inline bool isDirty() const { return dirty_; }
+	/// True when the sprite cannot contribute any pixel to the canvas in the current frame
+	inline bool isCulled() const { return culled_; }
+	/// True when the sprite is too far from the canvas for its grid functions to be evaluated
+	inline bool isGridCulled() const { return gridCulled_; }
 	void updateRender();
 	void render();
 	void resetGrid();
@@ -68,6 +79,8 @@ class Sprite : public SpriteEntry
 	inline nc::Recti texRect() const { return texRect_; }
 	void setTexRect(const nc::Recti &texRect);
 	inline nc::Recti flippingTexRect() const { return flippingTexRect_; }
+	/// True if the texture rectangle still covers the placeholder of a texture that is loading
+	inline bool hasPlaceholderTexRect() const { return hasPlaceholderTexRect_; }
 
 	inline const Texture &texture() const { return *texture_; }
 	inline Texture &texture() { return *texture_; }
@@ -92,13 +105,16 @@ class Sprite : public SpriteEntry
 
 	void *imguiTexId();
 
+	inline int gridAnimationsCounter() const { return gridAnimationsCounter_; }
 	void incrementGridAnimCounter();
 	void decrementGridAnimCounter();
 
-	inline const nctl::Array<Sprite *> children() const { return children_; }
+	inline const nctl::Array<Sprite *> &children() const { return children_; }
 	inline const Sprite *parent() const { return parent_; }
 	inline Sprite *parent() { return parent_; }
 	void setParent(Sprite *parent);
+	/// Incremented every time a sprite changes its parent
+	inline static unsigned int hierarchyVersion() { return hierarchyVersion_; }
 
 	inline int absWidth() const { return static_cast<int>(width_ * absScaleFactor_.x); }
 	inline int absHeight() const { return static_cast<int>(height_ * absScaleFactor_.y); }
@@ -115,9 +131,16 @@ class Sprite : public SpriteEntry
 	int width_;
 	int height_;
 
-	nc::Matrix4x4f localMatrix_;
+	/// Set when a property used by the transformation changes
+	bool dirty_;
+	/// Computed by the sprite manager, in the form expected by the shaders
 	nc::Matrix4x4f worldMatrix_;
 
+	bool culled_;
+	bool gridCulled_;
+	/// Bounds of the grid vertices the last time the grid functions were evaluated, in normalized coordinates
+	nc::Rectf gridBounds_;
+
 	nc::Vector2f absPosition_;
 	nc::Vector2f absScaleFactor_;
 	float absRotation_;
@@ -127,6 +150,8 @@ class Sprite : public SpriteEntry
 	nc::Recti texRect_;
 	/// Texture rectangle that takes flipping into account
 	nc::Recti flippingTexRect_;
+	/// Set when the texture is assigned while loading, cleared when a rectangle is set explicitly
+	bool hasPlaceholderTexRect_;
 
 	bool flippedX_;
 	bool flippedY_;
@@ -138,8 +163,8 @@ class Sprite : public SpriteEntry
 
 	nctl::Array<Vertex> interleavedVertices_;
 	nctl::Array<Vertex> restPositions_;
-	nctl::Array<unsigned int> indices_;
-	nctl::Array<unsigned short> shortIndices_;
+	/// Shared with the other sprites of the same size
+	GridIndexCache::Entry *gridIndices_;
 
 	Sprite *parent_;
 	nctl::Array<Sprite *> children_;
@@ -153,16 +178,24 @@ class Sprite : public SpriteEntry
 	nc::GLShaderProgram *meshSpriteShaderProgram_;
 	nctl::UniquePtr<nc::GLShaderUniforms> meshSpriteShaderUniforms_;
 
+	nc::GLShaderProgram *compactMeshSpriteShaderProgram_;
+	nctl::UniquePtr<nc::GLShaderUniforms> compactMeshSpriteShaderUniforms_;
+	/// Set when the last upload used the compact vertex format
+	bool compactVertices_;
+
 	nctl::UniquePtr<nc::GLBufferObject> vbo_;
-	nctl::UniquePtr<nc::GLBufferObject> ibo_;
+
+	static unsigned int hierarchyVersion_;
 
 	void setSize(int width, int height);
 	void initGrid(int width, int height);
 	void resetVertices();
-	void resetIndices();
+	bool packCompactVertices(float &deltaScale) const;
 
 	bool addChild(Sprite *sprite);
 	bool removeChild(Sprite *sprite);
+
+	friend class SpriteManager;
 };
 
 #endif
@@ -1,6 +1,7 @@
 #ifndef CLASS_SPRITEENTRY
 #define CLASS_SPRITEENTRY
 
+#include <cstddef>
 #include <nctl/Array.h>
 #include <nctl/String.h>
 #include <ncine/Colorf.h>
@@ -22,6 +23,8 @@ class SpriteEntry
 
 	SpriteEntry(Type type);
 	SpriteEntry(Type type, nc::Colorf entryColor);
+	/// Entries are destroyed through pointers to this class
+	virtual ~SpriteEntry() {}
 
 	inline Type type() const { return type_; }
 
@@ -60,6 +63,9 @@ class SpriteGroup : public SpriteEntry
 	SpriteGroup(const char *name);
 	SpriteGroup(nc::Colorf entryColor, const char *name);
 
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr, size_t size);
+
 	nctl::UniquePtr<SpriteGroup> clone() const;
 
 	inline const nctl::String &name() const { return name_; }
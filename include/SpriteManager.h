@@ -2,6 +2,8 @@
 #define CLASS_SPRITEMANAGER
 
 #include <nctl/Array.h>
+#include <nctl/HashMap.h>
+#include "GridIndexCache.h"
 
 class SpriteEntry;
 class SpriteGroup;
@@ -17,6 +19,8 @@ class SpriteManager
 	inline nctl::Array<nctl::UniquePtr<Texture>> &textures() { return textures_; }
 	inline const nctl::Array<nctl::UniquePtr<Texture>> &textures() const { return textures_; }
 
+	inline GridIndexCache &gridIndexCache() { return gridIndexCache_; }
+
 	inline SpriteGroup &root() { return *root_; }
 	inline const SpriteGroup &root() const { return *root_; }
 
@@ -30,6 +34,8 @@ class SpriteManager
 	void update();
 
 	int textureIndex(const Texture *texture) const;
+	/// Resets the texture rectangle of sprites that were created while their texture was a placeholder
+	void updateSpritesWithTexture(Texture &texture);
 
 	SpriteGroup *addGroup(SpriteEntry *selected);
 	Sprite *addSprite(SpriteEntry *selected, Texture *texture);
@@ -37,12 +43,40 @@ class SpriteManager
 
   private:
 	nctl::Array<nctl::UniquePtr<Texture>> textures_;
+	/// Declared before the root group, so that it is destroyed after the sprites
+	GridIndexCache gridIndexCache_;
 	nctl::UniquePtr<SpriteGroup> root_;
 
-	nctl::Array<Sprite *> spritesWithoutParent_;
 	nctl::Array<Sprite *> spritesArray_;
 
-	void transform(Sprite *sprite);
+	/// A 2D affine transformation, the two columns of the linear part followed by the translation
+	struct Affine2D
+	{
+		float a, b, c, d;
+		float tx, ty;
+	};
+
+	/// The sprites sorted so that every parent comes before its children, rebuilt when the hierarchy changes
+	nctl::Array<Sprite *> transformOrder_;
+	/// Index in the transform order of the parent of each sprite, or -1
+	nctl::Array<int> parentIndices_;
+	/// The world transformations in the transform order, read by the children and by culling without touching the sprites
+	nctl::Array<Affine2D> worldTransforms_;
+	nctl::Array<bool> changedFlags_;
+	/// The value of `Sprite::hierarchyVersion()` when the transform order was last built
+	unsigned int hierarchyVersion_;
+
+	/// Lazily rebuilt when it no longer matches the textures array, which can be modified from outside
+	mutable nctl::HashMap<const Texture *, unsigned int> textureIndices_;
+
+	void rebuildTextureIndices() const;
+	void updateTransformOrder();
+	/// Transforms, in a single pass, the sprites that are dirty or whose parent has changed
+	void transform();
+	/// Finds the sprites that cannot contribute pixels to the canvas, after they have been transformed
+	void cull();
+	/// Tests the bounds of a sprite, in pixels relative to its center, against the canvas
+	static bool intersectsCanvas(const Affine2D &world, float minX, float minY, float maxX, float maxY);
 	void draw(Sprite *sprite);
 };
 
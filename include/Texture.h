@@ -4,14 +4,16 @@
 #include <nctl/UniquePtr.h>
 #include <nctl/String.h>
 #include <ncine/Vector2.h>
+#include "TextureRegistry.h"
 
 namespace ncine {
 
-class GLTexture;
 class ITextureLoader;
 
 }
 
+class TextureLoader;
+
 namespace nc = ncine;
 
 /// The texture wrapper class
@@ -20,18 +22,30 @@ class Texture
   public:
 	static const unsigned int MaxNameLength = 64;
 
+	/// Creates a texture showing the placeholder pixel, meant to be filled later by the `TextureLoader`
+	Texture();
 	Texture(const char *filename);
 	Texture(const char *bufferName, const unsigned char *bufferPtr, unsigned long int bufferSize);
+	~Texture();
 
 	inline const nctl::String &name() const { return name_; }
 	inline void setName(const nctl::String &name) { name_ = name; }
 
-	inline nc::Vector2i size() const { return nc::Vector2i(width_, height_); }
-	inline int width() const { return width_; }
-	inline int height() const { return height_; }
+	inline nc::Vector2i size() const { return nc::Vector2i(entry_->width, entry_->height); }
+	inline int width() const { return entry_->width; }
+	inline int height() const { return entry_->height; }
+
+	inline unsigned int numChannels() const { return entry_->numChannels; }
+	/// Returns zero if the texture has no data yet
+	inline unsigned int dataSize() const { return entry_->dataSize; }
+
+	/// The file the data comes from, empty if the texture has been loaded from memory
+	inline const nctl::String &path() const { return path_; }
+	/// Returns true if this texture shares its OpenGL texture with another one
+	inline bool isShared() const { return entry_->refCount > 1; }
 
-	inline unsigned int numChannels() const { return numChannels_; }
-	inline unsigned int dataSize() const { return dataSize_; }
+	/// Returns true if the texture is still a placeholder waiting for its data to be uploaded
+	inline bool isLoading() const { return loader_ != nullptr; }
 
 	bool loadFromFile(const char *filename);
 	bool loadFromMemory(const char *bufferName, const unsigned char *bufferPtr, unsigned long int bufferSize);
@@ -40,17 +54,19 @@ class Texture
 	void *imguiTexId();
 
   private:
-	nctl::UniquePtr<nc::GLTexture> glTexture_;
 	nctl::String name_;
-	int width_;
-	int height_;
-	unsigned int numChannels_;
-	unsigned long dataSize_;
+	/// Kept here and not in the registry entry, as files with the same pixels share the entry
+	nctl::String path_;
+	/// The OpenGL texture, shared with the other textures with the same content
+	TextureRegistry::Entry *entry_;
+	/// The loader that will upload the texture data, if any
+	TextureLoader *loader_;
 
-	void initialize(const nc::ITextureLoader &texLoader);
-	void load(const nc::ITextureLoader &texLoader);
+	/// Releases the current entry and takes ownership of a reference to the new one
+	void setEntry(TextureRegistry::Entry *entry);
 
 	friend class Sprite;
+	friend class TextureLoader;
 };
 
 #endif
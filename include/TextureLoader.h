@@ -0,0 +1,82 @@
+#ifndef CLASS_TEXTURELOADER
+#define CLASS_TEXTURELOADER
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <nctl/Array.h>
+#include <nctl/String.h>
+#include <nctl/UniquePtr.h>
+#include "TextureRegistry.h"
+
+namespace ncine {
+
+class ITextureLoader;
+
+}
+
+class Texture;
+
+namespace nc = ncine;
+
+/// A pool of threads decoding image files, with the uploads happening later on the rendering thread
+class TextureLoader
+{
+  public:
+	/// Uploads stop for the current frame once this many bytes have been transferred
+	static const unsigned long int MaxUploadBytesPerFrame = 16 * 1024 * 1024;
+
+	/// A number of threads equal to zero means one less than the number of cores
+	explicit TextureLoader(unsigned int numThreads);
+	~TextureLoader();
+
+	/// Decodes the file in the background, the texture stays a placeholder until its data is uploaded
+	void request(Texture &texture, const char *filename);
+	/// Decodes the file of the texture again, the current data is shown until the new one is uploaded
+	void reload(Texture &texture);
+	/// Forgets about a texture that has not been uploaded yet
+	void cancel(Texture &texture);
+	/// Uploads the decoded textures, must be called from the rendering thread
+	void update();
+
+	inline unsigned int numPending() const { return pending_.size(); }
+
+  private:
+	struct Job
+	{
+		unsigned int id;
+		nctl::String filename;
+	};
+
+	struct Result
+	{
+		unsigned int id;
+		nctl::String filename;
+		nctl::UniquePtr<nc::ITextureLoader> texLoader;
+		TextureRegistry::ContentHash contentHash;
+	};
+
+	/// Only accessed by the rendering thread
+	struct Pending
+	{
+		Texture *texture;
+		unsigned int id;
+	};
+
+	nctl::Array<Pending> pending_;
+	/// Identifies requests, a texture allocated at the same address of a cancelled one gets a new identifier
+	unsigned int nextId_;
+
+	nctl::Array<nctl::UniquePtr<std::thread>> threads_;
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	nctl::Array<Job> jobs_;
+	unsigned int nextJob_;
+	nctl::Array<Result> results_;
+	bool shouldQuit_;
+
+	void enqueue(Texture &texture, const char *filename);
+	void threadLoop();
+};
+
+#endif
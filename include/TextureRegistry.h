@@ -0,0 +1,72 @@
+#ifndef CLASS_TEXTUREREGISTRY
+#define CLASS_TEXTUREREGISTRY
+
+#include <cstdint>
+#include <nctl/Array.h>
+#include <nctl/HashMap.h>
+#include <nctl/String.h>
+#include <nctl/UniquePtr.h>
+
+namespace ncine {
+
+class GLTexture;
+class ITextureLoader;
+
+}
+
+namespace nc = ncine;
+
+/// The registry of OpenGL textures, shared by all the textures with the same file or the same pixels
+class TextureRegistry
+{
+  public:
+	/// Two independent hashes of the decoded pixels, the first one is the key, the second one verifies a match
+	struct ContentHash
+	{
+		uint64_t key;
+		uint64_t check;
+	};
+
+	/// An uploaded texture, reference counted by the `Texture` objects using it
+	struct Entry
+	{
+		Entry();
+		~Entry();
+
+		nctl::UniquePtr<nc::GLTexture> glTexture;
+		/// The files whose most recent content is this entry, their keys are removed from the map when the entry is released
+		nctl::Array<nctl::String> paths;
+		ContentHash contentHash;
+		int width;
+		int height;
+		unsigned int numChannels;
+		unsigned long dataSize;
+		unsigned int refCount;
+	};
+
+	TextureRegistry();
+	~TextureRegistry();
+
+	/// Hashes the decoded pixels, it can be called from any thread
+	static ContentHash contentHash(const nc::ITextureLoader &texLoader);
+
+	/// Returns the entry already uploaded from this file, or `nullptr`
+	Entry *acquire(const char *path);
+	/// Returns the entry with the same pixels, uploading them to a new OpenGL texture if there is none
+	/*! The file is associated with the returned entry, the paths of the textures are stored in the textures themselves */
+	Entry *acquire(const nc::ITextureLoader &texLoader, const char *path, const ContentHash &contentHash);
+	/// Returns the transparent pixel shown by textures without data
+	Entry *acquirePlaceholder();
+	void release(Entry *entry);
+
+	inline unsigned int numEntries() const { return entries_.size(); }
+
+  private:
+	nctl::Array<nctl::UniquePtr<Entry>> entries_;
+	/// Different files with the same pixels point to the same entry
+	nctl::HashMap<nctl::String, Entry *> pathHash_;
+	nctl::HashMap<uint64_t, Entry *> contentHash_;
+	nctl::UniquePtr<Entry> placeholder_;
+};
+
+#endif
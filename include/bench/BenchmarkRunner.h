@@ -0,0 +1,74 @@
+#ifndef CLASS_BENCHMARKRUNNER
+#define CLASS_BENCHMARKRUNNER
+
+#include <nctl/Array.h>
+#include <nctl/String.h>
+#include <ncine/TimeStamp.h>
+
+namespace nc = ncine;
+
+/// The class that times the benchmarks and collects their results
+class BenchmarkRunner
+{
+  public:
+	static const unsigned int MaxNameLength = 64;
+
+	struct Result
+	{
+		Result()
+		    : suite(MaxNameLength), name(MaxNameLength), numItems(0), numIterations(0), meanTime(0.0), minTime(0.0) {}
+
+		nctl::String suite;
+		nctl::String name;
+		/// The number of processed items in one iteration, like vertices or animation nodes
+		unsigned int numItems;
+		unsigned int numIterations;
+		/// In milliseconds
+		double meanTime;
+		double minTime;
+	};
+
+	/// A benchmark runs until both the minimum time in seconds and the minimum number of iterations are reached
+	BenchmarkRunner(float minTime, unsigned int minIterations);
+
+	inline void setSuite(const char *suite) { suite_ = suite; }
+	inline const nctl::Array<Result> &results() const { return results_; }
+
+	/// Calls the body once to warm up the caches, then until enough samples have been collected
+	template <class Func>
+	void run(const char *name, unsigned int numItems, Func body)
+	{
+		body();
+
+		double totalTime = 0.0;
+		double minTime = 0.0;
+		unsigned int numIterations = 0;
+		while ((totalTime < minTime_ || numIterations < minIterations_) && numIterations < MaxIterations)
+		{
+			const nc::TimeStamp startTime = nc::TimeStamp::now();
+			body();
+			const double time = startTime.secondsSince();
+
+			totalTime += time;
+			if (numIterations == 0 || time < minTime)
+				minTime = time;
+			numIterations++;
+		}
+
+		addResult(name, numItems, numIterations, totalTime, minTime);
+	}
+
+	bool saveJson(const char *filename) const;
+
+  private:
+	static const unsigned int MaxIterations = 1000000;
+
+	double minTime_;
+	unsigned int minIterations_;
+	nctl::String suite_;
+	nctl::Array<Result> results_;
+
+	void addResult(const char *name, unsigned int numItems, unsigned int numIterations, double totalTime, double minTime);
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef CLASS_BENCHEVENTHANDLER
+#define CLASS_BENCHEVENTHANDLER
+
+#include <ncine/IAppEventHandler.h>
+#include <nctl/String.h>
+
+namespace ncine {
+
+class AppConfiguration;
+
+}
+
+namespace nc = ncine;
+
+/// The event handler of the benchmark application, it runs all suites in the first frame and then quits
+class BenchEventHandler : public nc::IAppEventHandler
+{
+  public:
+	BenchEventHandler();
+
+	void onPreInit(nc::AppConfiguration &config) override;
+	void onInit() override;
+	void onShutdown() override;
+	void onFrameStart() override;
+
+  private:
+	nctl::String outputFilename_;
+	nctl::String workingDir_;
+	bool hasRun_;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef BENCH_SUITES
+#define BENCH_SUITES
+
+class BenchmarkRunner;
+
+namespace bench {
+
+/// Creates the directory for the generated textures, projects and frames, and points the configuration to it
+bool init(const char *workingDir);
+
+void runGridFunctions(BenchmarkRunner &runner);
+void runEasingCurves(BenchmarkRunner &runner);
+void runAnimationTrees(BenchmarkRunner &runner);
+void runSpriteHierarchies(BenchmarkRunner &runner);
+void runProjectSaving(BenchmarkRunner &runner);
+void runFrameExport(BenchmarkRunner &runner);
+
+}
+
+#endif
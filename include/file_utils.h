@@ -0,0 +1,22 @@
+#ifndef FILE_UTILS_H
+#define FILE_UTILS_H
+
+namespace ncine {
+
+class IFile;
+
+}
+
+namespace nc = ncine;
+
+namespace fileUtils {
+
+/// Renames the source file over the destination in one step, a reader never sees a partially written file
+bool replaceFile(const char *source, const char *destination);
+
+/// Writes a string between quotes, escaping the characters that are not allowed inside a JSON string
+void writeJsonString(nc::IFile &file, const char *string);
+
+}
+
+#endif
@@ -8,6 +8,8 @@
 #include <ncine/TimeStamp.h>
 
 #include "LuaSaver.h"
+#include "Autosaver.h"
+#include "FileWatcher.h"
 #include "gui/CanvasGuiSection.h"
 #include "gui/RenderGuiWindow.h"
 
@@ -73,6 +75,7 @@ class UserInterface
 
   private:
 	static bool showConfigWindow;
+	static bool showProfilerWindow;
 
 	enum class MouseStatus
 	{
@@ -134,6 +137,11 @@ class UserInterface
 	CanvasGuiSection canvasGuiSection_;
 	RenderGuiWindow renderGuiWindow_;
 	LuaSaver::Data saverData_;
+	Autosaver autosaver_;
+	FileWatcher fileWatcher_;
+	/// Reused every frame to pass the paths of the loaded textures and scripts to the file watcher
+	nctl::Array<const char *> watchedFiles_;
+	nctl::Array<nctl::String> changedFiles_;
 
 #ifdef __EMSCRIPTEN__
 	nc::EmscriptenLocalFile loadTextureLocalFile_;
@@ -150,6 +158,7 @@ class UserInterface
 	nctl::UniquePtr<Texture> ncineLogo_;
 
 	bool openProject(const char *filename);
+	bool saveProject(const char *filename);
 	bool loadTexture(const char *filename);
 	bool reloadTexture(const char *filename);
 	bool loadScript(const char *filename);
@@ -193,10 +202,17 @@ class UserInterface
 	void createGridAnimationGui(GridAnimation &anim);
 	void createScriptAnimationGui(ScriptAnimation &anim);
 
+	/// Autosaves go to a file named after the project, a null name is used for a new project
+	void resetAutosave(const char *projectFilename);
+	void updateAutosave();
+	void updateFileWatcher();
+	/// Reports the scripts disabled for exceeding their budget, even when the scripts window is not visible
+	void updateScriptNotices();
 	void createFileDialog();
 	void createCanvasWindow();
 	void createTexRectWindow();
 	void createConfigWindow();
+	void createProfilerWindow();
 	void createTipsWindow();
 	void createAboutWindow();
 	void createQuitPopup();
@@ -19,6 +19,7 @@
 #define TEXT_MENU_FILE_QUICKOPEN "Quick Open"
 #define TEXT_MENU_FILE_QUICKSAVE "Quick Save"
 #define TEXT_MENU_FILE_CONFIGURATION "Configuration"
+#define TEXT_MENU_FILE_PROFILER "Profiler"
 #define TEXT_MENU_FILE_QUIT "Quit"
 #define TEXT_MENU_DOCUMENTATION "Documentation"
 #define TEXT_MENU_TIPS "Tips"
@@ -31,6 +32,7 @@
 #define TEXT_HEADER_SCRIPTS "Scripts"
 #define TEXT_HEADER_ANIMATIONS "Animations"
 #define TEXT_HEADER_RENDER "Render"
+#define TEXT_HEADER_FRAME_TIME "Frame Time"
 
 #define TEXT_HEADER_SPRITE "Sprite"
 #define TEXT_HEADER_ANIMATION "Animation"
@@ -42,6 +44,7 @@
 #define TEXT_RELOAD "Reload"
 #define TEXT_RESET "Reset"
 #define TEXT_CLEAR "Clear"
+#define TEXT_SAVE_TRACE "Save Trace"
 #define TEXT_APPLY "Apply"
 #define TEXT_CURRENT "Current"
 #define TEXT_LOCKED "Locked"
@@ -88,6 +91,7 @@ static const char *SaveAs = TEXT_MENU_FILE_SAVEAS;
 static const char *QuickOpen = TEXT_MENU_FILE_QUICKOPEN;
 static const char *QuickSave = TEXT_MENU_FILE_QUICKSAVE;
 static const char *Configuration = TEXT_MENU_FILE_CONFIGURATION;
+static const char *Profiler = TEXT_MENU_FILE_PROFILER;
 static const char *Quit = TEXT_MENU_FILE_QUIT;
 static const char *Documentation = TEXT_MENU_DOCUMENTATION;
 static const char *Tips = TEXT_MENU_TIPS;
@@ -100,6 +104,7 @@ static const char *Sprites = TEXT_HEADER_SPRITES;
 static const char *Scripts = TEXT_HEADER_SCRIPTS;
 static const char *Animations = TEXT_HEADER_ANIMATIONS;
 static const char *Render = TEXT_HEADER_RENDER;
+static const char *FrameTime = TEXT_HEADER_FRAME_TIME;
 
 static const char *Sprite = TEXT_HEADER_SPRITE;
 static const char *Animation = TEXT_HEADER_ANIMATION;
@@ -108,6 +113,7 @@ static const char *Load = TEXT_LOAD;
 static const char *Reload = TEXT_RELOAD;
 static const char *Reset = TEXT_RESET;
 static const char *Clear = TEXT_CLEAR;
+static const char *SaveTrace = TEXT_SAVE_TRACE;
 static const char *Apply = TEXT_APPLY;
 static const char *Current = TEXT_CURRENT;
 static const char *Locked = TEXT_LOCKED;
@@ -192,6 +198,7 @@ static const char *SaveAs = ICON_FA_SAVE FA5_SPACING TEXT_MENU_FILE_SAVEAS;
 static const char *QuickOpen = ICON_FA_FOLDER_OPEN FA5_SPACING TEXT_MENU_FILE_QUICKOPEN;
 static const char *QuickSave = ICON_FA_SAVE FA5_SPACING TEXT_MENU_FILE_QUICKSAVE;
 static const char *Configuration = ICON_FA_TOOLS FA5_SPACING TEXT_MENU_FILE_CONFIGURATION;
+static const char *Profiler = ICON_FA_TACHOMETER_ALT FA5_SPACING TEXT_MENU_FILE_PROFILER;
 static const char *Quit = ICON_FA_POWER_OFF FA5_SPACING TEXT_MENU_FILE_QUIT;
 static const char *Documentation = ICON_FA_QUESTION_CIRCLE FA5_SPACING TEXT_MENU_DOCUMENTATION;
 static const char *Tips = ICON_FA_LIGHTBULB FA5_SPACING TEXT_MENU_TIPS;
@@ -204,6 +211,7 @@ static const char *Sprites = ICON_FA_GHOST FA5_SPACING TEXT_HEADER_SPRITES;
 static const char *Scripts = ICON_FA_SCROLL FA5_SPACING TEXT_HEADER_SCRIPTS;
 static const char *Animations = ICON_FA_SLIDERS_H FA5_SPACING TEXT_HEADER_ANIMATIONS;
 static const char *Render = ICON_FA_IMAGE FA5_SPACING TEXT_HEADER_RENDER;
+static const char *FrameTime = ICON_FA_STOPWATCH FA5_SPACING TEXT_HEADER_FRAME_TIME;
 
 static const char *Sprite = ICON_FA_GHOST FA5_SPACING TEXT_HEADER_SPRITE;
 static const char *Animation = ICON_FA_SLIDERS_H FA5_SPACING TEXT_HEADER_ANIMATION;
@@ -212,6 +220,7 @@ static const char *Load = ICON_FA_FILE_UPLOAD FA5_SPACING TEXT_LOAD;
 static const char *Reload = ICON_FA_REDO FA5_SPACING TEXT_RELOAD;
 static const char *Reset = ICON_FA_BACKSPACE FA5_SPACING TEXT_RESET;
 static const char *Clear = ICON_FA_BACKSPACE FA5_SPACING TEXT_CLEAR;
+static const char *SaveTrace = ICON_FA_FILE_EXPORT FA5_SPACING TEXT_SAVE_TRACE;
 static const char *Apply = ICON_FA_CHECK_CIRCLE FA5_SPACING TEXT_APPLY;
 static const char *Current = ICON_FA_SYNC FA5_SPACING TEXT_CURRENT;
 static const char *Locked = ICON_FA_LOCK;
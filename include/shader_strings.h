@@ -6,5 +6,6 @@ struct ShaderStrings
 	static char const *const sprite_vs;
 	static char const *const sprite_fs;
 	static char const *const meshsprite_vs;
+	static char const *const meshsprite_compact_vs;
 	static char const *const meshsprite_snap_vs;
 };
@@ -10,8 +10,11 @@ class AnimationManager;
 class UserInterface;
 class LuaSaver;
 class ScriptManager;
+class TextureLoader;
+class TextureRegistry;
 
 extern Configuration theCfg;
+extern nctl::UniquePtr<TextureRegistry> theTextureRegistry;
 extern nctl::UniquePtr<Canvas> theCanvas;
 extern nctl::UniquePtr<Canvas> theResizedCanvas;
 extern nctl::UniquePtr<Canvas> theSpritesheet;
@@ -19,5 +22,6 @@ extern nctl::UniquePtr<SpriteManager> theSpriteMgr;
 extern nctl::UniquePtr<AnimationManager> theAnimMgr;
 extern nctl::UniquePtr<LuaSaver> theSaver;
 extern nctl::UniquePtr<ScriptManager> theScriptingMgr;
+extern nctl::UniquePtr<TextureLoader> theTextureLoader;
 
 #endif
@@ -0,0 +1,76 @@
+#ifndef CLASS_PROJECTGENERATOR
+#define CLASS_PROJECTGENERATOR
+
+#include <nctl/Array.h>
+#include <nctl/String.h>
+#include <ncine/Colorf.h>
+#include <ncine/Random.h>
+#include "LuaSaver.h"
+
+class Texture;
+class Script;
+class Sprite;
+class SpriteGroup;
+class AnimationGroup;
+
+namespace nc = ncine;
+
+/// The class that fills the managers with a synthetic project of configurable size, to be saved with `LuaSaver`
+/*! The same parameters always generate the same project.
+ *  Textures and scripts are written in the output directory, projects refer to them by their base names. */
+class ProjectGenerator
+{
+  public:
+	struct Parameters
+	{
+		unsigned int seed = 1;
+
+		unsigned int numTextures = 4;
+		int textureSize = 64;
+		unsigned int numScripts = 2;
+
+		unsigned int numSprites = 64;
+		/// Sprites are parented in chains of this length, one means no parenting
+		unsigned int hierarchyDepth = 4;
+		/// Sprite groups are nested up to this level, zero means that sprites are not grouped
+		unsigned int groupDepth = 2;
+		unsigned int spritesPerGroup = 8;
+
+		unsigned int numPropertyAnims = 64;
+		unsigned int numGridAnims = 16;
+		unsigned int numScriptAnims = 4;
+		/// Animation groups are nested up to this level, zero means that animations are not grouped
+		unsigned int animGroupDepth = 2;
+		unsigned int animsPerGroup = 8;
+
+		inline unsigned int numAnimations() const { return numPropertyAnims + numGridAnims + numScriptAnims; }
+		/// Multiplies the number of textures, scripts, sprites and animations, the nesting levels are not changed
+		void scale(unsigned int factor);
+	};
+
+	explicit ProjectGenerator(const char *outputDir);
+
+	/// Replaces the project in the managers with a generated one
+	void generate(const Parameters &params, LuaSaver::Data &data);
+
+	/// Writes a checkerboard image in the output directory and adds it to the textures of the sprite manager
+	Texture *addTexture(SpriteManager &spriteMgr, const char *name, int size, const nc::Colorf &color);
+
+  private:
+	nctl::String outputDir_;
+	nctl::String auxString_;
+	nc::Random random_;
+
+	Script *addScript(ScriptManager &scriptMgr, const char *name);
+	void addSprites(const Parameters &params, LuaSaver::Data &data, nctl::Array<Sprite *> &sprites);
+	void addAnimations(const Parameters &params, LuaSaver::Data &data, const nctl::Array<Sprite *> &sprites);
+
+	/// Opens a new sprite group at a random nesting level, the groups that are deeper than it are closed
+	SpriteGroup *openSpriteGroup(SpriteManager &spriteMgr, nctl::Array<SpriteGroup *> &openGroups, unsigned int maxDepth, unsigned int id);
+	/// Opens a new animation group at a random nesting level, the groups that are deeper than it are closed
+	AnimationGroup *openAnimationGroup(AnimationGroup &root, nctl::Array<AnimationGroup *> &openGroups, unsigned int maxDepth, unsigned int id);
+	unsigned int randomDepth(unsigned int numOpenGroups, unsigned int maxDepth);
+	nc::Colorf randomColor();
+};
+
+#endif
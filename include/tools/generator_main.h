@@ -0,0 +1,34 @@
+#ifndef CLASS_GENERATOREVENTHANDLER
+#define CLASS_GENERATOREVENTHANDLER
+
+#include <ncine/IAppEventHandler.h>
+#include <nctl/String.h>
+
+namespace ncine {
+
+class AppConfiguration;
+
+}
+
+namespace nc = ncine;
+
+/// The event handler of the project generator, it writes the projects in the first frame and then quits
+class GeneratorEventHandler : public nc::IAppEventHandler
+{
+  public:
+	GeneratorEventHandler();
+
+	void onPreInit(nc::AppConfiguration &config) override;
+	void onInit() override;
+	void onShutdown() override;
+	void onFrameStart() override;
+
+  private:
+	nctl::String outputDir_;
+	/// Zero generates the projects for all the default scale factors
+	unsigned int scaleFactor_;
+	unsigned int seed_;
+	bool hasRun_;
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+namespace ncine {
+
+class AppConfiguration;
+
+}
+
+namespace nc = ncine;
+
+/// The engine setup shared by the command line tools, which run their work in the first frame without a user interface
+namespace headless {
+
+/// Sets a small window without a frame limit or vertical sync, and disables the engine features the tools do not use
+void configure(nc::AppConfiguration &config, const char *windowTitle);
+/// Creates the singletons like the application does, including the script settings of the configuration
+void init();
+/// Joins the worker threads and releases the rendering resources
+void shutdown();
+
+}
+
+#endif
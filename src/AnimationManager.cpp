@@ -1,11 +1,16 @@
 #include "AnimationManager.h"
 #include "ParallelAnimationGroup.h"
+#include "SequentialAnimationGroup.h"
 #include "PropertyAnimation.h"
 #include "GridAnimation.h"
 #include "GridFunction.h"
 #include "ScriptAnimation.h"
 #include "Sprite.h"
 #include "Script.h"
+#include "ScriptManager.h"
+#include "ObjectPool.h"
+#include "FrameProfiler.h"
+#include "singletons.h"
 
 namespace {
 
@@ -41,18 +46,8 @@ void resetAnimation(IAnimation &anim)
 	}
 }
 
-void recursiveRemoveAnimation(IAnimation &anim)
+void removeFromParent(IAnimation &anim)
 {
-	if (anim.isGroup())
-	{
-		AnimationGroup &animGroup = static_cast<AnimationGroup &>(anim);
-		for (unsigned int i = 0; i < animGroup.anims().size(); i++)
-			resetAnimation(*animGroup.anims()[i]);
-		animGroup.anims().clear();
-	}
-	else
-		resetAnimation(anim);
-
 	if (anim.parent() != nullptr)
 	{
 		nctl::Array<nctl::UniquePtr<IAnimation>> &anims = anim.parent()->anims();
@@ -67,201 +62,64 @@ void recursiveRemoveAnimation(IAnimation &anim)
 	}
 }
 
-void recursiveRemoveSprite(AnimationGroup &animGroup, Sprite *sprite)
+void recursiveRemoveAnimation(IAnimation &anim)
 {
-	// Deleting backwards without iterators
-	for (int i = animGroup.anims().size() - 1; i >= 0; i--)
+	if (anim.isGroup())
 	{
-		IAnimation &anim = *animGroup.anims()[i];
-
-		switch (anim.type())
-		{
-			case IAnimation::Type::PARALLEL_GROUP:
-			case IAnimation::Type::SEQUENTIAL_GROUP:
-			{
-				AnimationGroup &innerGroup = static_cast<AnimationGroup &>(anim);
-				recursiveRemoveSprite(innerGroup, sprite);
-				break;
-			}
-			case IAnimation::Type::PROPERTY:
-			{
-				PropertyAnimation &propertyAnim = static_cast<PropertyAnimation &>(anim);
-				if (propertyAnim.sprite() == sprite)
-				{
-					propertyAnim.setProperty(Properties::Types::NONE);
-					propertyAnim.setSprite(nullptr);
-					propertyAnim.stop();
-					animGroup.anims().removeAt(i);
-				}
-				break;
-			}
-			case IAnimation::Type::GRID:
-			{
-				GridAnimation &gridAnim = static_cast<GridAnimation &>(anim);
-				if (gridAnim.sprite() == sprite)
-				{
-					gridAnim.setSprite(nullptr);
-					gridAnim.stop();
-					animGroup.anims().removeAt(i);
-				}
-				break;
-			}
-			case IAnimation::Type::SCRIPT:
-			{
-				ScriptAnimation &scriptAnim = static_cast<ScriptAnimation &>(anim);
-				if (scriptAnim.sprite() == sprite)
-				{
-					scriptAnim.setSprite(nullptr);
-					scriptAnim.stop();
-					animGroup.anims().removeAt(i);
-				}
-				break;
-			}
-		}
+		AnimationGroup &animGroup = static_cast<AnimationGroup &>(anim);
+		for (unsigned int i = 0; i < animGroup.anims().size(); i++)
+			resetAnimation(*animGroup.anims()[i]);
+		animGroup.anims().clear();
 	}
-}
-
-void recursiveAssignGridAnchorToParameters(AnimationGroup &animGroup, Sprite *sprite)
-{
-	for (unsigned int i = 0; i < animGroup.anims().size(); i++)
-	{
-		IAnimation &anim = *animGroup.anims()[i];
+	else
+		resetAnimation(anim);
 
-		switch (anim.type())
-		{
-			case IAnimation::Type::PARALLEL_GROUP:
-			case IAnimation::Type::SEQUENTIAL_GROUP:
-			{
-				AnimationGroup &innerGroup = static_cast<AnimationGroup &>(anim);
-				recursiveAssignGridAnchorToParameters(innerGroup, sprite);
-				break;
-			}
-			case IAnimation::Type::PROPERTY:
-			case IAnimation::Type::SCRIPT:
-				break;
-			case IAnimation::Type::GRID:
-			{
-				GridAnimation &gridAnim = static_cast<GridAnimation &>(anim);
-				if (gridAnim.sprite() == sprite && gridAnim.function() != nullptr)
-				{
-					const GridFunction &function = *gridAnim.function();
-					for (unsigned int paramIndex = 0; paramIndex < function.numParameters(); paramIndex++)
-					{
-						if (function.parameterInfo(paramIndex).anchorType == GridFunction::AnchorType::X)
-							gridAnim.parameters()[paramIndex].value0 = gridAnim.sprite()->gridAnchorPoint.x;
-						else if (function.parameterInfo(paramIndex).anchorType == GridFunction::AnchorType::Y)
-							gridAnim.parameters()[paramIndex].value0 = gridAnim.sprite()->gridAnchorPoint.y;
-						else if (function.parameterInfo(paramIndex).anchorType == GridFunction::AnchorType::XY)
-						{
-							gridAnim.parameters()[paramIndex].value0 = gridAnim.sprite()->gridAnchorPoint.x;
-							gridAnim.parameters()[paramIndex].value1 = gridAnim.sprite()->gridAnchorPoint.y;
-						}
-					}
-				}
-				break;
-			}
-		}
-	}
+	removeFromParent(anim);
 }
 
-void recursiveRemoveScript(AnimationGroup &animGroup, Script *script)
+const Sprite *animationSprite(const IAnimation &anim)
 {
-	// Deleting backwards without iterators
-	for (int i = animGroup.anims().size() - 1; i >= 0; i--)
+	switch (anim.type())
 	{
-		IAnimation &anim = *animGroup.anims()[i];
-
-		switch (anim.type())
-		{
-			case IAnimation::Type::PARALLEL_GROUP:
-			case IAnimation::Type::SEQUENTIAL_GROUP:
-			{
-				AnimationGroup &innerGroup = static_cast<AnimationGroup &>(anim);
-				recursiveRemoveScript(innerGroup, script);
-				break;
-			}
-			case IAnimation::Type::PROPERTY:
-			case IAnimation::Type::GRID:
-				break;
-			case IAnimation::Type::SCRIPT:
-			{
-				ScriptAnimation &scriptAnim = static_cast<ScriptAnimation &>(anim);
-				if (scriptAnim.script() == script)
-				{
-					scriptAnim.setSprite(nullptr);
-					scriptAnim.setScript(nullptr);
-					scriptAnim.stop();
-					animGroup.anims().removeAt(i);
-				}
-				break;
-			}
-		}
+		case IAnimation::Type::PARALLEL_GROUP:
+		case IAnimation::Type::SEQUENTIAL_GROUP:
+			return nullptr;
+		case IAnimation::Type::PROPERTY:
+			return static_cast<const PropertyAnimation &>(anim).sprite();
+		case IAnimation::Type::GRID:
+			return static_cast<const GridAnimation &>(anim).sprite();
+		case IAnimation::Type::SCRIPT:
+			return static_cast<const ScriptAnimation &>(anim).sprite();
 	}
+	return nullptr;
 }
 
-void recursiveReloadScript(AnimationGroup &animGroup, Script *script)
+void setAnimationSprite(IAnimation &anim, Sprite *sprite)
 {
-	for (unsigned int i = 0; i < animGroup.anims().size(); i++)
+	switch (anim.type())
 	{
-		IAnimation &anim = *animGroup.anims()[i];
-
-		switch (anim.type())
-		{
-			case IAnimation::Type::PARALLEL_GROUP:
-			case IAnimation::Type::SEQUENTIAL_GROUP:
-			{
-				AnimationGroup &innerGroup = static_cast<AnimationGroup &>(anim);
-				recursiveReloadScript(innerGroup, script);
-				break;
-			}
-			case IAnimation::Type::PROPERTY:
-			case IAnimation::Type::GRID:
-				break;
-			case IAnimation::Type::SCRIPT:
-			{
-				ScriptAnimation &scriptAnim = static_cast<ScriptAnimation &>(anim);
-				if (scriptAnim.script() == script)
-				{
-					const IAnimation::State prevState = scriptAnim.state();
-					// Call `play()` again to run the Lua init function
-					scriptAnim.play();
-					if (prevState != IAnimation::State::PLAYING)
-						scriptAnim.stop();
-				}
-				break;
-			}
-		}
+		case IAnimation::Type::PARALLEL_GROUP:
+		case IAnimation::Type::SEQUENTIAL_GROUP:
+			break;
+		case IAnimation::Type::PROPERTY:
+			static_cast<PropertyAnimation &>(anim).setSprite(sprite);
+			break;
+		case IAnimation::Type::GRID:
+			static_cast<GridAnimation &>(anim).setSprite(sprite);
+			break;
+		case IAnimation::Type::SCRIPT:
+			static_cast<ScriptAnimation &>(anim).setSprite(sprite);
+			break;
 	}
 }
 
-void recursiveInitScriptsForSprite(AnimationGroup &animGroup, Sprite *sprite)
+void runScriptInitAgain(ScriptAnimation &scriptAnim)
 {
-	for (unsigned int i = 0; i < animGroup.anims().size(); i++)
-	{
-		IAnimation &anim = *animGroup.anims()[i];
-
-		switch (anim.type())
-		{
-			case IAnimation::Type::PARALLEL_GROUP:
-			case IAnimation::Type::SEQUENTIAL_GROUP:
-			case IAnimation::Type::PROPERTY:
-			case IAnimation::Type::GRID:
-				break;
-			case IAnimation::Type::SCRIPT:
-			{
-				ScriptAnimation &scriptAnim = static_cast<ScriptAnimation &>(anim);
-				if (scriptAnim.sprite() == sprite)
-				{
-					const IAnimation::State prevState = scriptAnim.state();
-					// Call `play()` again to run the Lua init function
-					scriptAnim.play();
-					if (prevState != IAnimation::State::PLAYING)
-						scriptAnim.stop();
-				}
-				break;
-			}
-		}
-	}
+	const IAnimation::State prevState = scriptAnim.state();
+	// Call `play()` again to run the Lua init function
+	scriptAnim.play();
+	if (prevState != IAnimation::State::PLAYING)
+		scriptAnim.stop();
 }
 
 void recursiveOverrideSprite(AnimationGroup &animGroup, Sprite *sprite)
@@ -269,150 +127,37 @@ void recursiveOverrideSprite(AnimationGroup &animGroup, Sprite *sprite)
 	for (unsigned int i = 0; i < animGroup.anims().size(); i++)
 	{
 		IAnimation &anim = *animGroup.anims()[i];
-
-		switch (anim.type())
-		{
-			case IAnimation::Type::PARALLEL_GROUP:
-			case IAnimation::Type::SEQUENTIAL_GROUP:
-			{
-				AnimationGroup &innerGroup = static_cast<AnimationGroup &>(anim);
-				recursiveOverrideSprite(innerGroup, sprite);
-				break;
-			}
-			case IAnimation::Type::PROPERTY:
-			{
-				PropertyAnimation &propertyAnim = static_cast<PropertyAnimation &>(anim);
-				if (propertyAnim.sprite() != sprite)
-					propertyAnim.setSprite(sprite);
-				break;
-			}
-			case IAnimation::Type::GRID:
-			{
-				GridAnimation &gridAnim = static_cast<GridAnimation &>(anim);
-				if (gridAnim.sprite() != sprite)
-					gridAnim.setSprite(sprite);
-				break;
-			}
-			case IAnimation::Type::SCRIPT:
-			{
-				ScriptAnimation &scriptAnim = static_cast<ScriptAnimation &>(anim);
-				if (scriptAnim.sprite() != sprite)
-					scriptAnim.setSprite(sprite);
-				break;
-			}
-		}
+		if (anim.isGroup())
+			recursiveOverrideSprite(static_cast<AnimationGroup &>(anim), sprite);
+		else
+			setAnimationSprite(anim, sprite);
 	}
 }
 
-bool recursiveCheckAnimationSprite(AnimationGroup &animGroup, const Sprite *sprite)
+/// Returns true if all the animations inside the group are associated to the sprite, the result for every visited group is cached
+bool recursiveCheckAnimationSprite(const AnimationGroup &animGroup, const Sprite *sprite, nctl::HashMap<const AnimationGroup *, bool> &checkedGroups)
 {
-	for (int i = animGroup.anims().size() - 1; i >= 0; i--)
-	{
-		IAnimation &anim = *animGroup.anims()[i];
+	const bool *checked = checkedGroups.find(&animGroup);
+	if (checked)
+		return *checked;
 
-		switch (anim.type())
-		{
-			case IAnimation::Type::PARALLEL_GROUP:
-			case IAnimation::Type::SEQUENTIAL_GROUP:
-			{
-				AnimationGroup &innerGroup = static_cast<AnimationGroup &>(anim);
-				return recursiveCheckAnimationSprite(innerGroup, sprite);
-				break;
-			}
-			case IAnimation::Type::PROPERTY:
-			{
-				PropertyAnimation &propertyAnim = static_cast<PropertyAnimation &>(anim);
-				if (propertyAnim.sprite() != sprite)
-					return false;
-				break;
-			}
-			case IAnimation::Type::GRID:
-			{
-				GridAnimation &gridAnim = static_cast<GridAnimation &>(anim);
-				if (gridAnim.sprite() != sprite)
-					return false;
-				break;
-			}
-			case IAnimation::Type::SCRIPT:
-			{
-				ScriptAnimation &scriptAnim = static_cast<ScriptAnimation &>(anim);
-				if (scriptAnim.sprite() != sprite)
-					return false;
-				break;
-			}
-		}
-	}
-
-	return true;
-}
-
-void recursiveCloneSpriteAnimations(AnimationGroup &animGroup, const Sprite *fromSprite, Sprite *toSprite)
-{
-	// Reverse for loop to add cloned animations after the original ones
-	for (int i = animGroup.anims().size() - 1; i >= 0; i--)
+	bool allSameSprite = true;
+	for (unsigned int i = 0; i < animGroup.anims().size(); i++)
 	{
-		IAnimation &anim = *animGroup.anims()[i];
+		const IAnimation &anim = *animGroup.anims()[i];
+		if (anim.isGroup())
+			allSameSprite = recursiveCheckAnimationSprite(static_cast<const AnimationGroup &>(anim), sprite, checkedGroups);
+		else
+			allSameSprite = (animationSprite(anim) == sprite);
 
-		switch (anim.type())
-		{
-			case IAnimation::Type::PARALLEL_GROUP:
-			case IAnimation::Type::SEQUENTIAL_GROUP:
-			{
-				AnimationGroup &innerGroup = static_cast<AnimationGroup &>(anim);
-				// If the group only contains animations associated to the same sprite then create a new group
-				const bool createNewGroup = recursiveCheckAnimationSprite(innerGroup, fromSprite);
-				if (createNewGroup)
-				{
-					animGroup.anims().insertAt(i + 1, innerGroup.clone());
-					AnimationGroup &clonedGroup = static_cast<AnimationGroup &>(*animGroup.anims()[i + 1]);
-					recursiveOverrideSprite(clonedGroup, toSprite);
-				}
-				else
-					recursiveCloneSpriteAnimations(innerGroup, fromSprite, toSprite);
-
-				break;
-			}
-			case IAnimation::Type::PROPERTY:
-			{
-				PropertyAnimation &propertyAnim = static_cast<PropertyAnimation &>(anim);
-				if (propertyAnim.sprite() == fromSprite)
-				{
-					animGroup.anims().insertAt(i + 1, propertyAnim.clone());
-					PropertyAnimation &clonedAnim = static_cast<PropertyAnimation &>(*animGroup.anims()[i + 1]);
-					clonedAnim.setSprite(toSprite);
-					// Retain locked flag as the cloned animation has been assigned to a different sprite
-					clonedAnim.setLocked(propertyAnim.isLocked());
-				}
-				break;
-			}
-			case IAnimation::Type::GRID:
-			{
-				GridAnimation &gridAnim = static_cast<GridAnimation &>(anim);
-				if (gridAnim.sprite() == fromSprite)
-				{
-					animGroup.anims().insertAt(i + 1, gridAnim.clone());
-					GridAnimation &clonedAnim = static_cast<GridAnimation &>(*animGroup.anims()[i + 1]);
-					clonedAnim.setSprite(toSprite);
-					// Retain locked flag as the cloned animation has been assigned to a different sprite
-					clonedAnim.setLocked(gridAnim.isLocked());
-				}
-				break;
-			}
-			case IAnimation::Type::SCRIPT:
-			{
-				ScriptAnimation &scriptAnim = static_cast<ScriptAnimation &>(anim);
-				if (scriptAnim.sprite() == fromSprite)
-				{
-					animGroup.anims().insertAt(i + 1, scriptAnim.clone());
-					ScriptAnimation &clonedAnim = static_cast<ScriptAnimation &>(*animGroup.anims()[i + 1]);
-					clonedAnim.setSprite(toSprite);
-					// Retain locked flag as the cloned animation has been assigned to a different sprite
-					clonedAnim.setLocked(scriptAnim.isLocked());
-				}
-				break;
-			}
-		}
+		if (allSameSprite == false)
+			break;
 	}
+
+	if ((checkedGroups.size() + 1) * 2 > checkedGroups.capacity())
+		checkedGroups.rehash(checkedGroups.capacity() * 2);
+	checkedGroups.insert(&animGroup, allSameSprite);
+	return allSameSprite;
 }
 
 }
@@ -422,7 +167,7 @@ void recursiveCloneSpriteAnimations(AnimationGroup &animGroup, const Sprite *fro
 ///////////////////////////////////////////////////////////
 
 AnimationManager::AnimationManager()
-    : speedMultiplier_(1.0f), animGroup_(nctl::makeUnique<ParallelAnimationGroup>())
+    : speedMultiplier_(1.0f), spriteIndex_(64), scriptIndex_(16), animGroup_(nctl::makeUnique<ParallelAnimationGroup>())
 {
 	animGroup_->name = "Root";
 }
@@ -433,12 +178,22 @@ AnimationManager::AnimationManager()
 
 void AnimationManager::update(float deltaTime)
 {
+	ProfileScope profileScope("Animations");
+	theScriptingMgr->beginBatch();
 	animGroup_->update(deltaTime * speedMultiplier_);
+	theScriptingMgr->endBatch();
 }
 
 void AnimationManager::clear()
 {
 	animGroup_->anims().clear();
+
+	// The memory of the pools is freed if there are no animations left outside of this manager
+	ObjectPool<PropertyAnimation>::release();
+	ObjectPool<GridAnimation>::release();
+	ObjectPool<ScriptAnimation>::release();
+	ObjectPool<SequentialAnimationGroup>::release();
+	ObjectPool<ParallelAnimationGroup>::release();
 }
 
 void AnimationManager::removeAnimation(IAnimation *anim)
@@ -449,31 +204,87 @@ void AnimationManager::removeAnimation(IAnimation *anim)
 
 void AnimationManager::removeSprite(Sprite *sprite)
 {
-	if (sprite != nullptr)
-		recursiveRemoveSprite(*animGroup_, sprite);
+	if (sprite == nullptr)
+		return;
+
+	nctl::Array<CurveAnimation *> anims;
+	spriteIndex_.find(sprite, anims);
+	for (unsigned int i = 0; i < anims.size(); i++)
+	{
+		resetAnimation(*anims[i]);
+		removeFromParent(*anims[i]);
+	}
 }
 
 void AnimationManager::assignGridAnchorToParameters(Sprite *sprite)
 {
-	recursiveAssignGridAnchorToParameters(*animGroup_, sprite);
+	nctl::Array<CurveAnimation *> anims;
+	spriteIndex_.find(sprite, anims);
+	for (unsigned int i = 0; i < anims.size(); i++)
+	{
+		if (anims[i]->type() != IAnimation::Type::GRID)
+			continue;
+
+		GridAnimation &gridAnim = static_cast<GridAnimation &>(*anims[i]);
+		if (gridAnim.function() == nullptr)
+			continue;
+
+		const GridFunction &function = *gridAnim.function();
+		for (unsigned int paramIndex = 0; paramIndex < function.numParameters(); paramIndex++)
+		{
+			if (function.parameterInfo(paramIndex).anchorType == GridFunction::AnchorType::X)
+				gridAnim.parameters()[paramIndex].value0 = sprite->gridAnchorPoint.x;
+			else if (function.parameterInfo(paramIndex).anchorType == GridFunction::AnchorType::Y)
+				gridAnim.parameters()[paramIndex].value0 = sprite->gridAnchorPoint.y;
+			else if (function.parameterInfo(paramIndex).anchorType == GridFunction::AnchorType::XY)
+			{
+				gridAnim.parameters()[paramIndex].value0 = sprite->gridAnchorPoint.x;
+				gridAnim.parameters()[paramIndex].value1 = sprite->gridAnchorPoint.y;
+			}
+		}
+	}
 }
 
 void AnimationManager::removeScript(Script *script)
 {
-	if (script != nullptr)
-		recursiveRemoveScript(*animGroup_, script);
+	if (script == nullptr)
+		return;
+
+	nctl::Array<CurveAnimation *> anims;
+	scriptIndex_.find(script, anims);
+	for (unsigned int i = 0; i < anims.size(); i++)
+	{
+		ScriptAnimation &scriptAnim = static_cast<ScriptAnimation &>(*anims[i]);
+		scriptAnim.setSprite(nullptr);
+		scriptAnim.setScript(nullptr);
+		scriptAnim.stop();
+		removeFromParent(scriptAnim);
+	}
 }
 
 void AnimationManager::reloadScript(Script *script)
 {
-	if (script != nullptr)
-		recursiveReloadScript(*animGroup_, script);
+	if (script == nullptr)
+		return;
+
+	nctl::Array<CurveAnimation *> anims;
+	scriptIndex_.find(script, anims);
+	for (unsigned int i = 0; i < anims.size(); i++)
+		runScriptInitAgain(static_cast<ScriptAnimation &>(*anims[i]));
 }
 
 void AnimationManager::initScriptsForSprite(Sprite *sprite)
 {
-	if (sprite != nullptr)
-		recursiveInitScriptsForSprite(*animGroup_, sprite);
+	if (sprite == nullptr)
+		return;
+
+	nctl::Array<CurveAnimation *> anims;
+	spriteIndex_.find(sprite, anims);
+	for (unsigned int i = 0; i < anims.size(); i++)
+	{
+		if (anims[i]->type() == IAnimation::Type::SCRIPT)
+			runScriptInitAgain(static_cast<ScriptAnimation &>(*anims[i]));
+	}
 }
 
 void AnimationManager::overrideSprite(AnimationGroup &animGroup, Sprite *sprite)
@@ -484,6 +295,82 @@ void AnimationManager::overrideSprite(AnimationGroup &animGroup, Sprite *sprite)
 
 void AnimationManager::cloneSpriteAnimations(const Sprite *fromSprite, Sprite *toSprite)
 {
-	if (fromSprite != nullptr && toSprite != nullptr && fromSprite != toSprite)
-		recursiveCloneSpriteAnimations(*animGroup_, fromSprite, toSprite);
+	if (fromSprite == nullptr || toSprite == nullptr || fromSprite == toSprite)
+		return;
+
+	// The clones are added to the index while iterating, so a copy is needed
+	nctl::Array<CurveAnimation *> anims;
+	spriteIndex_.find(fromSprite, anims);
+	const unsigned int hashCapacity = anims.size() * 2 + 1;
+	nctl::HashMap<const AnimationGroup *, bool> checkedGroups(hashCapacity);
+	nctl::HashMap<const IAnimation *, bool> sources(hashCapacity);
+	nctl::HashMap<const AnimationGroup *, bool> parentsHash(hashCapacity);
+	nctl::Array<AnimationGroup *> parents;
+	for (unsigned int i = 0; i < anims.size(); i++)
+	{
+		// If a group only contains animations associated to the same sprite then the outermost one is cloned as a whole
+		IAnimation *source = anims[i];
+		for (AnimationGroup *group = source->parent(); group != nullptr && group != animGroup_.get(); group = group->parent())
+		{
+			if (recursiveCheckAnimationSprite(*group, fromSprite, checkedGroups) == false)
+				break;
+			source = group;
+		}
+
+		AnimationGroup *parent = source->parent();
+		if (parent == nullptr || sources.insert(source, true) == false)
+			continue;
+		if (parentsHash.insert(parent, true))
+			parents.pushBack(parent);
+	}
+
+	nctl::Array<IAnimation *> clonedSources;
+	nctl::Array<IAnimation *> clonedAnims;
+	for (unsigned int i = 0; i < parents.size(); i++)
+	{
+		// Every parent is rebuilt once, with each cloned animation added after the original one
+		nctl::Array<nctl::UniquePtr<IAnimation>> &siblings = parents[i]->anims();
+		nctl::Array<nctl::UniquePtr<IAnimation>> newSiblings(siblings.size() * 2);
+		for (unsigned int j = 0; j < siblings.size(); j++)
+		{
+			IAnimation *anim = siblings[j].get();
+			newSiblings.pushBack(nctl::move(siblings[j]));
+			if (sources.find(anim) == nullptr)
+				continue;
+
+			newSiblings.pushBack(anim->clone());
+			clonedSources.pushBack(anim);
+			clonedAnims.pushBack(newSiblings.back().get());
+		}
+		siblings = nctl::move(newSiblings);
+	}
+
+	for (unsigned int i = 0; i < clonedAnims.size(); i++)
+	{
+		IAnimation &clonedAnim = *clonedAnims[i];
+		if (clonedAnim.isGroup())
+			recursiveOverrideSprite(static_cast<AnimationGroup &>(clonedAnim), toSprite);
+		else
+		{
+			setAnimationSprite(clonedAnim, toSprite);
+			// Retain locked flag as the cloned animation has been assigned to a different sprite
+			static_cast<CurveAnimation &>(clonedAnim).setLocked(static_cast<CurveAnimation *>(clonedSources[i])->isLocked());
+		}
+	}
+}
+
+void AnimationManager::updateSpriteIndex(CurveAnimation *anim, const Sprite *prevSprite, const Sprite *sprite)
+{
+	if (prevSprite != nullptr)
+		spriteIndex_.remove(prevSprite, anim);
+	if (sprite != nullptr)
+		spriteIndex_.add(sprite, anim);
+}
+
+void AnimationManager::updateScriptIndex(CurveAnimation *anim, const Script *prevScript, const Script *script)
+{
+	if (prevScript != nullptr)
+		scriptIndex_.remove(prevScript, anim);
+	if (script != nullptr)
+		scriptIndex_.add(script, anim);
 }
@@ -0,0 +1,140 @@
+#include <cstring>
+#include <ncine/IFile.h>
+#include <ncine/FileSystem.h>
+
+#include "Autosaver.h"
+#include "BinarySaver.h"
+#include "file_utils.h"
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+Autosaver::Autosaver()
+    : lastSnapshot_(nc::TimeStamp::now()), bufferSize_(0), filename_(nc::fs::MaxPathLength),
+      isWriting_(false), shouldQuit_(false), result_(Result::NONE)
+{
+#ifndef __EMSCRIPTEN__
+	thread_ = std::thread([this]() { writerLoop(); });
+#endif
+}
+
+Autosaver::~Autosaver()
+{
+#ifndef __EMSCRIPTEN__
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		shouldQuit_ = true;
+	}
+	condition_.notify_one();
+	thread_.join();
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void Autosaver::reset(const char *filename, const LuaSaver::Data &data)
+{
+#ifndef __EMSCRIPTEN__
+	{
+		// The snapshot buffer belongs to the writer thread until the current write has finished
+		std::unique_lock<std::mutex> lock(mutex_);
+		condition_.wait(lock, [this]() { return isWriting_ == false; });
+	}
+
+	// The project as it has been opened or saved is the reference for the next snapshots
+	bufferSize_ = BinarySaver::encode(data, buffer_);
+	filename_ = filename;
+	lastSnapshot_ = nc::TimeStamp::now();
+#endif
+}
+
+void Autosaver::update(float interval, const LuaSaver::Data &data)
+{
+#ifndef __EMSCRIPTEN__
+	if (interval <= 0.0f || filename_.isEmpty() || lastSnapshot_.secondsSince() < interval)
+		return;
+	lastSnapshot_ = nc::TimeStamp::now();
+
+	{
+		// A slow write is never queued behind, the snapshot is just taken at the next interval
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (isWriting_)
+			return;
+	}
+
+	nctl::UniquePtr<unsigned char[]> buffer;
+	const unsigned long int size = BinarySaver::encode(data, buffer);
+
+	// Nothing has changed since the last snapshot, or since the project has been opened or saved
+	if (size == bufferSize_ && memcmp(buffer.get(), buffer_.get(), size) == 0)
+		return;
+
+	buffer_ = nctl::move(buffer);
+	bufferSize_ = size;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		isWriting_ = true;
+	}
+	condition_.notify_one();
+#endif
+}
+
+Autosaver::Result Autosaver::consumeResult()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const Result result = result_;
+	result_ = Result::NONE;
+	return result;
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void Autosaver::writerLoop()
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this]() { return shouldQuit_ || isWriting_; });
+			if (shouldQuit_)
+				break;
+		}
+
+		const bool written = write();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			// A failed snapshot should not prevent the same data from being written again
+			if (written == false)
+				bufferSize_ = 0;
+			result_ = written ? Result::SAVED : Result::FAILED;
+			isWriting_ = false;
+		}
+		condition_.notify_all();
+	}
+}
+
+bool Autosaver::write()
+{
+	nctl::String tempFilename(nc::fs::MaxPathLength);
+	tempFilename.format("%s.tmp", filename_.data());
+
+	nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(tempFilename.data());
+	fileHandle->open(nc::IFile::OpenMode::WRITE | nc::IFile::OpenMode::BINARY);
+	if (fileHandle->isOpened() == false)
+		return false;
+
+	const unsigned long int bytesWritten = fileHandle->write(buffer_.get(), bufferSize_);
+	fileHandle->close();
+	if (bytesWritten != bufferSize_)
+		return false;
+
+	// Renaming replaces the previous snapshot atomically, a crash never leaves a truncated file
+	return fileUtils::replaceFile(tempFilename.data(), filename_.data());
+}
@@ -0,0 +1,960 @@
+#include <cstdint>
+#include <cstring>
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#include <nctl/HashMap.h>
+#include <ncine/FileSystem.h>
+#include <ncine/IFile.h>
+#ifdef __EMSCRIPTEN__
+	#include <ncine/EmscriptenLocalFile.h>
+#endif
+
+#include "BinarySaver.h"
+#include "Canvas.h"
+#include "Texture.h"
+#include "Sprite.h"
+#include "SpriteManager.h"
+#include "Script.h"
+#include "ScriptManager.h"
+#include "ParallelAnimationGroup.h"
+#include "SequentialAnimationGroup.h"
+#include "PropertyAnimation.h"
+#include "GridAnimation.h"
+#include "GridFunction.h"
+#include "GridFunctionLibrary.h"
+#include "ScriptAnimation.h"
+#include "AnimationManager.h"
+#include "Serializers.h"
+#include "TextureLoader.h"
+#include "file_utils.h"
+
+#include "singletons.h"
+
+namespace {
+
+const char Magic[4] = { 'S', 'G', 'P', 'B' };
+/// Incremented every time a record layout or the meaning of an enumeration value changes
+const uint32_t FormatVersion = 1;
+const uint32_t NoString = 0xFFFFFFFF;
+const int32_t NoIndex = -1;
+
+enum Section : unsigned int
+{
+	STRINGS,
+	CANVAS,
+	TEXTURES,
+	SPRITE_ENTRIES,
+	SCRIPTS,
+	ANIMATIONS,
+	PARAMETERS,
+
+	NUM_SECTIONS
+};
+
+// All fields are four bytes wide so that records have no padding and sections stay aligned
+
+struct SectionRecord
+{
+	uint32_t offset;
+	/// Number of records, or of bytes for the string table
+	uint32_t count;
+};
+
+struct Header
+{
+	char magic[4];
+	uint32_t formatVersion;
+	uint32_t fileSize;
+	SectionRecord sections[NUM_SECTIONS];
+};
+
+struct CanvasRecord
+{
+	int32_t size[2];
+	float backgroundColor[4];
+};
+
+struct NameRecord
+{
+	uint32_t name;
+};
+
+struct SpriteEntryRecord
+{
+	uint32_t type;
+	int32_t parentGroup;
+	float entryColor[4];
+	uint32_t name;
+
+	int32_t texture;
+	int32_t parent;
+	uint32_t visible;
+	float position[2];
+	float rotation;
+	float scaleFactor[2];
+	float anchorPoint[2];
+	float color[4];
+	int32_t texRect[4];
+	uint32_t flipX;
+	uint32_t flipY;
+	uint32_t rgbBlending;
+	uint32_t alphaBlending;
+};
+
+struct LoopRecord
+{
+	uint32_t direction;
+	uint32_t mode;
+	float delay;
+};
+
+struct CurveRecord
+{
+	uint32_t type;
+	LoopRecord loop;
+	float initialValue;
+	uint32_t initialValueEnabled;
+	float start;
+	float end;
+	float scale;
+	float shift;
+};
+
+struct AnimationRecord
+{
+	uint32_t type;
+	uint32_t name;
+	uint32_t enabled;
+	int32_t parent;
+	float delay;
+
+	/// Used by animation groups
+	LoopRecord loop;
+
+	/// Used by curve animations
+	int32_t sprite;
+	float speed;
+	CurveRecord curve;
+
+	uint32_t propertyName;
+	uint32_t functionName;
+	uint32_t firstParameter;
+	uint32_t numParameters;
+	int32_t script;
+};
+
+struct ParameterRecord
+{
+	uint32_t name;
+	float value0;
+	float value1;
+};
+
+/// Collects null-terminated strings, records refer to them by offset
+class StringTable
+{
+  public:
+	uint32_t add(const char *string)
+	{
+		if (string == nullptr)
+			return NoString;
+
+		const uint32_t offset = chars_.size();
+		const unsigned int length = strlen(string);
+		for (unsigned int i = 0; i < length; i++)
+			chars_.pushBack(string[i]);
+		chars_.pushBack('\0');
+		return offset;
+	}
+
+	/// Pads the table so that the following section is aligned
+	void align()
+	{
+		while (chars_.size() % 4 != 0)
+			chars_.pushBack('\0');
+	}
+
+	inline const nctl::Array<char> &chars() const { return chars_; }
+
+  private:
+	nctl::Array<char> chars_;
+};
+
+/// A read-only view of a file, memory-mapped when the platform allows it
+class MappedFile
+{
+  public:
+	MappedFile()
+	    : data_(nullptr), size_(0), isMapped_(false) {}
+	~MappedFile() { close(); }
+
+	bool open(const char *filename)
+	{
+		close();
+		if (map(filename))
+			return true;
+
+		// Fall back to a regular read, for Android assets and platforms without memory mapping
+		nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(filename);
+		fileHandle->open(nc::IFile::OpenMode::READ | nc::IFile::OpenMode::BINARY);
+		if (fileHandle->isOpened() == false)
+			return false;
+
+		size_ = static_cast<unsigned long int>(fileHandle->size());
+		buffer_ = nctl::makeUnique<unsigned char[]>(size_ > 0 ? size_ : 1);
+		const unsigned long int bytesRead = fileHandle->read(buffer_.get(), size_);
+		fileHandle->close();
+		data_ = buffer_.get();
+
+		return (bytesRead == size_);
+	}
+
+	inline const unsigned char *data() const { return data_; }
+	inline unsigned long int size() const { return size_; }
+
+  private:
+	const unsigned char *data_;
+	unsigned long int size_;
+	bool isMapped_;
+	nctl::UniquePtr<unsigned char[]> buffer_;
+
+#if defined(_WIN32)
+	bool map(const char *filename)
+	{
+		HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize;
+		HANDLE mapping = nullptr;
+		if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (mapping == nullptr)
+			return false;
+
+		// The view keeps a reference to the mapping object
+		void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (view == nullptr)
+			return false;
+
+		data_ = static_cast<const unsigned char *>(view);
+		size_ = static_cast<unsigned long int>(fileSize.QuadPart);
+		isMapped_ = true;
+		return true;
+	}
+
+	void close()
+	{
+		if (isMapped_)
+			UnmapViewOfFile(data_);
+		buffer_.reset(nullptr);
+		data_ = nullptr;
+		size_ = 0;
+		isMapped_ = false;
+	}
+#elif !defined(__EMSCRIPTEN__)
+	bool map(const char *filename)
+	{
+		const int fd = ::open(filename, O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat fileStat;
+		void *address = MAP_FAILED;
+		if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+			address = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		// The mapping stays valid after the descriptor is closed
+		::close(fd);
+		if (address == MAP_FAILED)
+			return false;
+
+		data_ = static_cast<const unsigned char *>(address);
+		size_ = static_cast<unsigned long int>(fileStat.st_size);
+		isMapped_ = true;
+		return true;
+	}
+
+	void close()
+	{
+		if (isMapped_)
+			munmap(const_cast<unsigned char *>(data_), size_);
+		buffer_.reset(nullptr);
+		data_ = nullptr;
+		size_ = 0;
+		isMapped_ = false;
+	}
+#else
+	bool map(const char *) { return false; }
+
+	void close()
+	{
+		buffer_.reset(nullptr);
+		data_ = nullptr;
+		size_ = 0;
+	}
+#endif
+};
+
+void encodeColor(float *dest, const nc::Colorf &color)
+{
+	dest[0] = color.r();
+	dest[1] = color.g();
+	dest[2] = color.b();
+	dest[3] = color.a();
+}
+
+nc::Colorf decodeColor(const float *src)
+{
+	return nc::Colorf(src[0], src[1], src[2], src[3]);
+}
+
+void encodeLoop(LoopRecord &record, const LoopComponent &loop)
+{
+	record.direction = static_cast<uint32_t>(loop.direction());
+	record.mode = static_cast<uint32_t>(loop.mode());
+	record.delay = loop.delay();
+}
+
+void decodeLoop(const LoopRecord &record, LoopComponent &loop)
+{
+	loop.setDirection(static_cast<Loop::Direction>(record.direction));
+	loop.setMode(static_cast<Loop::Mode>(record.mode));
+	loop.setDelay(record.delay);
+}
+
+void encodeCurve(CurveRecord &record, const EasingCurve &curve)
+{
+	record.type = static_cast<uint32_t>(curve.type());
+	encodeLoop(record.loop, curve.loop());
+	record.initialValue = curve.initialValue();
+	record.initialValueEnabled = curve.hasInitialValue();
+	record.start = curve.start();
+	record.end = curve.end();
+	record.scale = curve.scale();
+	record.shift = curve.shift();
+}
+
+void decodeCurve(const CurveRecord &record, EasingCurve &curve)
+{
+	curve.setType(static_cast<EasingCurve::Type>(record.type));
+	decodeLoop(record.loop, curve.loop());
+	curve.setInitialValue(record.initialValue);
+	curve.enableInitialValue(record.initialValueEnabled != 0);
+	curve.setStart(record.start);
+	curve.setEnd(record.end);
+	curve.setScale(record.scale);
+	curve.setShift(record.shift);
+}
+
+template <class T>
+int32_t indexOf(const T *ptr, const nctl::HashMap<const T *, unsigned int> &hash)
+{
+	const unsigned int *indexFind = ptr ? hash.find(ptr) : nullptr;
+	return indexFind ? static_cast<int32_t>(*indexFind) : NoIndex;
+}
+
+template <class T>
+T *pointerAt(int32_t index, nctl::Array<nctl::UniquePtr<T>> &array)
+{
+	return (index >= 0 && static_cast<unsigned int>(index) < array.size()) ? array[index].get() : nullptr;
+}
+
+/// Bounds-checked access to the sections of an encoded project
+class Reader
+{
+  public:
+	Reader(const unsigned char *buffer, unsigned long int size)
+	    : buffer_(buffer), size_(size), strings_(nullptr), stringsSize_(0)
+	{
+		memset(&header_, 0, sizeof(Header));
+	}
+
+	bool validate()
+	{
+		if (size_ < sizeof(Header))
+			return false;
+		memcpy(&header_, buffer_, sizeof(Header));
+
+		if (memcmp(header_.magic, Magic, sizeof(Magic)) != 0 ||
+		    header_.formatVersion == 0 || header_.formatVersion > FormatVersion || header_.fileSize != size_)
+		{
+			return false;
+		}
+
+		const unsigned int recordSizes[NUM_SECTIONS] = { 1, sizeof(CanvasRecord), sizeof(NameRecord), sizeof(SpriteEntryRecord),
+			                                             sizeof(NameRecord), sizeof(AnimationRecord), sizeof(ParameterRecord) };
+		for (unsigned int i = 0; i < NUM_SECTIONS; i++)
+		{
+			const uint64_t sectionEnd = uint64_t(header_.sections[i].offset) + uint64_t(header_.sections[i].count) * recordSizes[i];
+			if (sectionEnd > size_)
+				return false;
+		}
+
+		strings_ = reinterpret_cast<const char *>(buffer_ + header_.sections[STRINGS].offset);
+		stringsSize_ = header_.sections[STRINGS].count;
+		// Every offset inside the table is then guaranteed to point to a terminated string
+		if (stringsSize_ > 0 && strings_[stringsSize_ - 1] != '\0')
+			return false;
+
+		return (header_.sections[CANVAS].count == 1);
+	}
+
+	/// Checks every index and enumeration value in the records, so that decoding cannot fail halfway
+	bool validateRecords() const
+	{
+		for (unsigned int i = 0; i < count(SPRITE_ENTRIES); i++)
+		{
+			SpriteEntryRecord record;
+			read(SPRITE_ENTRIES, i, record);
+
+			if (record.type > static_cast<uint32_t>(SpriteEntry::Type::SPRITE) ||
+			    isValidEntry(record.parentGroup, SpriteEntry::Type::GROUP) == false)
+			{
+				return false;
+			}
+
+			if (record.type == static_cast<uint32_t>(SpriteEntry::Type::SPRITE))
+			{
+				if (record.texture < 0 || static_cast<uint32_t>(record.texture) >= count(TEXTURES) ||
+				    isValidEntry(record.parent, SpriteEntry::Type::SPRITE) == false ||
+				    record.rgbBlending > static_cast<uint32_t>(Sprite::BlendingPreset::MULTIPLY) ||
+				    record.alphaBlending > static_cast<uint32_t>(Sprite::BlendingPreset::MULTIPLY))
+				{
+					return false;
+				}
+			}
+		}
+
+		for (unsigned int i = 0; i < count(ANIMATIONS); i++)
+		{
+			AnimationRecord record;
+			read(ANIMATIONS, i, record);
+
+			if (record.type > static_cast<uint32_t>(IAnimation::Type::PARALLEL_GROUP) || isValidAnimationGroup(record.parent) == false)
+				return false;
+
+			if (isGroupType(record.type))
+			{
+				if (isValidLoop(record.loop) == false)
+					return false;
+			}
+			else
+			{
+				if (record.curve.type > static_cast<uint32_t>(EasingCurve::Type::CIRC) || isValidLoop(record.curve.loop) == false ||
+				    isValidEntry(record.sprite, SpriteEntry::Type::SPRITE) == false)
+				{
+					return false;
+				}
+				if (record.type == static_cast<uint32_t>(IAnimation::Type::SCRIPT) &&
+				    record.script != NoIndex && (record.script < 0 || static_cast<uint32_t>(record.script) >= count(SCRIPTS)))
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	inline unsigned int count(Section section) const { return header_.sections[section].count; }
+
+	template <class T>
+	void read(Section section, unsigned int index, T &record) const
+	{
+		memcpy(&record, buffer_ + header_.sections[section].offset + index * sizeof(T), sizeof(T));
+	}
+
+	/// Returns `nullptr` for a missing string, and an empty one for an invalid offset
+	const char *string(uint32_t offset) const
+	{
+		if (offset == NoString)
+			return nullptr;
+		return (offset < stringsSize_) ? strings_ + offset : "";
+	}
+
+	/// Like `string()` but never returns `nullptr`
+	inline const char *name(uint32_t offset) const
+	{
+		const char *str = string(offset);
+		return str ? str : "";
+	}
+
+  private:
+	const unsigned char *buffer_;
+	unsigned long int size_;
+	Header header_;
+	const char *strings_;
+	unsigned int stringsSize_;
+
+	static bool isGroupType(uint32_t type)
+	{
+		return (type == static_cast<uint32_t>(IAnimation::Type::SEQUENTIAL_GROUP) ||
+		        type == static_cast<uint32_t>(IAnimation::Type::PARALLEL_GROUP));
+	}
+
+	static bool isValidLoop(const LoopRecord &record)
+	{
+		return (record.direction <= static_cast<uint32_t>(Loop::Direction::BACKWARD) &&
+		        record.mode <= static_cast<uint32_t>(Loop::Mode::PING_PONG));
+	}
+
+	/// Returns true for a missing entry or for an existing one of the specified type
+	bool isValidEntry(int32_t index, SpriteEntry::Type type) const
+	{
+		if (index == NoIndex)
+			return true;
+		if (index < 0 || static_cast<uint32_t>(index) >= count(SPRITE_ENTRIES))
+			return false;
+
+		SpriteEntryRecord record;
+		read(SPRITE_ENTRIES, index, record);
+		return (record.type == static_cast<uint32_t>(type));
+	}
+
+	/// Returns true for a missing parent or for an existing animation group
+	bool isValidAnimationGroup(int32_t index) const
+	{
+		if (index == NoIndex)
+			return true;
+		if (index < 0 || static_cast<uint32_t>(index) >= count(ANIMATIONS))
+			return false;
+
+		AnimationRecord record;
+		read(ANIMATIONS, index, record);
+		return isGroupType(record.type);
+	}
+};
+
+}
+
+///////////////////////////////////////////////////////////
+// STATIC DEFINITIONS
+///////////////////////////////////////////////////////////
+
+const char *BinarySaver::Extension = "sgb";
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool BinarySaver::isBinaryProject(const char *filename)
+{
+	return (filename != nullptr && nc::fs::hasExtension(filename, Extension));
+}
+
+bool BinarySaver::load(const char *filename, LuaSaver::Data &data)
+{
+	MappedFile file;
+	if (file.open(filename) == false)
+		return false;
+
+	return decode(file.data(), file.size(), data);
+}
+
+bool BinarySaver::save(const char *filename, const LuaSaver::Data &data)
+{
+	nctl::UniquePtr<unsigned char[]> buffer;
+	const unsigned long int size = encode(data, buffer);
+
+#ifdef __EMSCRIPTEN__
+	nc::EmscriptenLocalFile localFileSave;
+	localFileSave.write(reinterpret_cast<const char *>(buffer.get()), size);
+	localFileSave.save(filename);
+	return true;
+#else
+	// Like Lua projects, the file is written under a temporary name and then renamed over the destination
+	nctl::String tempFilename(nc::fs::MaxPathLength);
+	tempFilename.format("%s.tmp", filename);
+	nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(tempFilename.data());
+	fileHandle->open(nc::IFile::OpenMode::WRITE | nc::IFile::OpenMode::BINARY);
+	if (fileHandle->isOpened() == false)
+		return false;
+
+	const unsigned long int bytesWritten = fileHandle->write(buffer.get(), size);
+	fileHandle->close();
+
+	if (bytesWritten == size && fileUtils::replaceFile(tempFilename.data(), filename))
+		return true;
+	nc::fs::deleteFile(tempFilename.data());
+	return false;
+#endif
+}
+
+unsigned long int BinarySaver::encode(const LuaSaver::Data &data, nctl::UniquePtr<unsigned char[]> &buffer)
+{
+	StringTable strings;
+
+	CanvasRecord canvasRecord;
+	canvasRecord.size[0] = data.canvas.size().x;
+	canvasRecord.size[1] = data.canvas.size().y;
+	encodeColor(canvasRecord.backgroundColor, data.canvas.backgroundColor);
+
+	const nctl::Array<nctl::UniquePtr<Texture>> &textures = data.spriteMgr.textures();
+	nctl::HashMap<const Texture *, unsigned int> textureHash(textures.size() * 2 + 1);
+	nctl::Array<NameRecord> textureRecords;
+	for (unsigned int i = 0; i < textures.size(); i++)
+	{
+		textureHash.insert(textures[i].get(), i);
+		textureRecords.pushBack({ strings.add(textures[i]->name().data()) });
+	}
+
+	nctl::Array<const SpriteEntry *> spriteEntries;
+	for (unsigned int i = 0; i < data.spriteMgr.children().size(); i++)
+		LuaSaver::visitSpriteEntries(data.spriteMgr.children()[i].get(), spriteEntries);
+
+	nctl::HashMap<const SpriteEntry *, unsigned int> spriteEntryHash(spriteEntries.size() * 2 + 1);
+	for (unsigned int i = 0; i < spriteEntries.size(); i++)
+		spriteEntryHash.insert(spriteEntries[i], i);
+
+	nctl::Array<SpriteEntryRecord> spriteEntryRecords;
+	for (unsigned int i = 0; i < spriteEntries.size(); i++)
+	{
+		const SpriteEntry &spriteEntry = *spriteEntries[i];
+		SpriteEntryRecord record;
+		memset(&record, 0, sizeof(SpriteEntryRecord));
+		record.type = static_cast<uint32_t>(spriteEntry.type());
+		record.parentGroup = indexOf(static_cast<const SpriteEntry *>(spriteEntry.parentGroup()), spriteEntryHash);
+		encodeColor(record.entryColor, spriteEntry.entryColor());
+		record.texture = NoIndex;
+		record.parent = NoIndex;
+
+		if (spriteEntry.isGroup())
+			record.name = strings.add(spriteEntry.toGroup()->name().data());
+		else
+		{
+			const Sprite &sprite = *spriteEntry.toSprite();
+			record.name = strings.add(sprite.name.data());
+			record.texture = indexOf(&sprite.texture(), textureHash);
+			record.parent = indexOf(static_cast<const SpriteEntry *>(sprite.parent()), spriteEntryHash);
+			record.visible = sprite.visible;
+			record.position[0] = sprite.x;
+			record.position[1] = sprite.y;
+			record.rotation = sprite.rotation;
+			record.scaleFactor[0] = sprite.scaleFactor.x;
+			record.scaleFactor[1] = sprite.scaleFactor.y;
+			record.anchorPoint[0] = sprite.anchorPoint.x;
+			record.anchorPoint[1] = sprite.anchorPoint.y;
+			encodeColor(record.color, sprite.color);
+			record.texRect[0] = sprite.texRect().x;
+			record.texRect[1] = sprite.texRect().y;
+			record.texRect[2] = sprite.texRect().w;
+			record.texRect[3] = sprite.texRect().h;
+			record.flipX = sprite.isFlippedX();
+			record.flipY = sprite.isFlippedY();
+			record.rgbBlending = static_cast<uint32_t>(sprite.rgbBlendingPreset());
+			record.alphaBlending = static_cast<uint32_t>(sprite.alphaBlendingPreset());
+		}
+		spriteEntryRecords.pushBack(record);
+	}
+
+	const nctl::Array<nctl::UniquePtr<Script>> &scripts = data.scriptMgr.scripts();
+	nctl::HashMap<const Script *, unsigned int> scriptHash(scripts.size() * 2 + 1);
+	nctl::Array<NameRecord> scriptRecords;
+	for (unsigned int i = 0; i < scripts.size(); i++)
+	{
+		scriptHash.insert(scripts[i].get(), i);
+		scriptRecords.pushBack({ strings.add(scripts[i]->name().data()) });
+	}
+
+	nctl::Array<const IAnimation *> anims;
+	for (unsigned int i = 0; i < data.animMgr.anims().size(); i++)
+		LuaSaver::visitAnimations(data.animMgr.anims()[i].get(), anims);
+
+	nctl::HashMap<const IAnimation *, unsigned int> animationHash(anims.size() * 2 + 1);
+	for (unsigned int i = 0; i < anims.size(); i++)
+		animationHash.insert(anims[i], i);
+
+	nctl::Array<AnimationRecord> animationRecords;
+	nctl::Array<ParameterRecord> parameterRecords;
+	for (unsigned int i = 0; i < anims.size(); i++)
+	{
+		const IAnimation &anim = *anims[i];
+		AnimationRecord record;
+		memset(&record, 0, sizeof(AnimationRecord));
+		record.type = static_cast<uint32_t>(anim.type());
+		record.name = strings.add(anim.name.data());
+		record.enabled = anim.enabled;
+		record.parent = indexOf(static_cast<const IAnimation *>(anim.parent()), animationHash);
+		record.delay = anim.delay();
+		record.sprite = NoIndex;
+		record.propertyName = NoString;
+		record.functionName = NoString;
+		record.script = NoIndex;
+
+		if (anim.isGroup())
+			encodeLoop(record.loop, static_cast<const AnimationGroup &>(anim).loop());
+		else
+		{
+			const CurveAnimation &curveAnim = static_cast<const CurveAnimation &>(anim);
+			record.speed = curveAnim.speed();
+			encodeCurve(record.curve, curveAnim.curve());
+		}
+
+		switch (anim.type())
+		{
+			case IAnimation::Type::PARALLEL_GROUP:
+			case IAnimation::Type::SEQUENTIAL_GROUP:
+				break;
+			case IAnimation::Type::PROPERTY:
+			{
+				const PropertyAnimation &propertyAnim = static_cast<const PropertyAnimation &>(anim);
+				record.sprite = indexOf(static_cast<const SpriteEntry *>(propertyAnim.sprite()), spriteEntryHash);
+				record.propertyName = strings.add(propertyAnim.propertyName());
+				break;
+			}
+			case IAnimation::Type::GRID:
+			{
+				const GridAnimation &gridAnim = static_cast<const GridAnimation &>(anim);
+				record.sprite = indexOf(static_cast<const SpriteEntry *>(gridAnim.sprite()), spriteEntryHash);
+				if (gridAnim.function() != nullptr)
+				{
+					const GridFunction &function = *gridAnim.function();
+					record.functionName = strings.add(function.name().data());
+					record.firstParameter = parameterRecords.size();
+					record.numParameters = function.numParameters();
+					for (unsigned int j = 0; j < function.numParameters(); j++)
+					{
+						const GridFunctionParameter &param = gridAnim.parameters()[j];
+						parameterRecords.pushBack({ strings.add(function.parameterName(j)), param.value0, param.value1 });
+					}
+				}
+				break;
+			}
+			case IAnimation::Type::SCRIPT:
+			{
+				const ScriptAnimation &scriptAnim = static_cast<const ScriptAnimation &>(anim);
+				record.sprite = indexOf(static_cast<const SpriteEntry *>(scriptAnim.sprite()), spriteEntryHash);
+				record.script = indexOf(scriptAnim.script(), scriptHash);
+				break;
+			}
+		}
+		animationRecords.pushBack(record);
+	}
+
+	strings.align();
+
+	Header header;
+	memset(&header, 0, sizeof(Header));
+	memcpy(header.magic, Magic, sizeof(Magic));
+	header.formatVersion = FormatVersion;
+
+	uint32_t offset = sizeof(Header);
+	const uint32_t counts[NUM_SECTIONS] = { strings.chars().size(), 1, textureRecords.size(), spriteEntryRecords.size(),
+		                                    scriptRecords.size(), animationRecords.size(), parameterRecords.size() };
+	const unsigned int recordSizes[NUM_SECTIONS] = { 1, sizeof(CanvasRecord), sizeof(NameRecord), sizeof(SpriteEntryRecord),
+		                                             sizeof(NameRecord), sizeof(AnimationRecord), sizeof(ParameterRecord) };
+	const void *sources[NUM_SECTIONS] = { strings.chars().data(), &canvasRecord, textureRecords.data(), spriteEntryRecords.data(),
+		                                  scriptRecords.data(), animationRecords.data(), parameterRecords.data() };
+	for (unsigned int i = 0; i < NUM_SECTIONS; i++)
+	{
+		header.sections[i].offset = offset;
+		header.sections[i].count = counts[i];
+		offset += counts[i] * recordSizes[i];
+	}
+	header.fileSize = offset;
+
+	buffer = nctl::makeUnique<unsigned char[]>(header.fileSize);
+	memcpy(buffer.get(), &header, sizeof(Header));
+	for (unsigned int i = 0; i < NUM_SECTIONS; i++)
+	{
+		if (counts[i] > 0)
+			memcpy(buffer.get() + header.sections[i].offset, sources[i], counts[i] * recordSizes[i]);
+	}
+
+	return header.fileSize;
+}
+
+bool BinarySaver::decode(const unsigned char *buffer, unsigned long int size, LuaSaver::Data &data)
+{
+	Reader reader(buffer, size);
+	// The current project is only cleared once the whole buffer is known to be valid
+	if (reader.validate() == false || reader.validateRecords() == false)
+		return false;
+
+	data.spriteMgr.clear();
+	data.scriptMgr.clear();
+	data.animMgr.clear();
+
+	CanvasRecord canvasRecord;
+	reader.read(CANVAS, 0, canvasRecord);
+	data.canvas.backgroundColor = decodeColor(canvasRecord.backgroundColor);
+	data.canvas.resizeTexture(canvasRecord.size[0], canvasRecord.size[1]);
+
+	nctl::Array<nctl::UniquePtr<Texture>> &textures = data.spriteMgr.textures();
+	for (unsigned int i = 0; i < reader.count(TEXTURES); i++)
+	{
+		NameRecord record;
+		reader.read(TEXTURES, i, record);
+		const char *textureName = reader.name(record.name);
+		const nctl::String texturePath = Deserializers::resolveTexturePath(textureName);
+		textures.pushBack(nctl::makeUnique<Texture>());
+		theTextureLoader->request(*textures.back(), texturePath.data());
+		// Set the texture name to its basename to allow for relocatable project files
+		textures.back()->setName(textureName);
+	}
+
+	nctl::Array<nctl::UniquePtr<SpriteEntry>> spriteEntries;
+	for (unsigned int i = 0; i < reader.count(SPRITE_ENTRIES); i++)
+	{
+		SpriteEntryRecord record;
+		reader.read(SPRITE_ENTRIES, i, record);
+
+		nctl::UniquePtr<SpriteEntry> spriteEntry;
+		if (record.type == static_cast<uint32_t>(SpriteEntry::Type::GROUP))
+		{
+			nctl::UniquePtr<SpriteGroup> spriteGroup = nctl::makeUnique<SpriteGroup>();
+			spriteGroup->name() = reader.name(record.name);
+			spriteEntry = nctl::move(spriteGroup);
+		}
+		else
+		{
+			Texture *texture = pointerAt(record.texture, textures);
+			nctl::UniquePtr<Sprite> sprite = nctl::makeUnique<Sprite>(texture);
+
+			sprite->name = reader.name(record.name);
+			sprite->setParent(static_cast<Sprite *>(pointerAt(record.parent, spriteEntries)));
+			sprite->visible = (record.visible != 0);
+			sprite->x = record.position[0];
+			sprite->y = record.position[1];
+			sprite->rotation = record.rotation;
+			sprite->scaleFactor.set(record.scaleFactor[0], record.scaleFactor[1]);
+			sprite->anchorPoint.set(record.anchorPoint[0], record.anchorPoint[1]);
+			sprite->color = decodeColor(record.color);
+			sprite->setTexRect(nc::Recti(record.texRect[0], record.texRect[1], record.texRect[2], record.texRect[3]));
+			sprite->setFlippedX(record.flipX != 0);
+			sprite->setFlippedY(record.flipY != 0);
+			sprite->setRgbBlendingPreset(static_cast<Sprite::BlendingPreset>(record.rgbBlending));
+			sprite->setAlphaBlendingPreset(static_cast<Sprite::BlendingPreset>(record.alphaBlending));
+			spriteEntry = nctl::move(sprite);
+		}
+
+		SpriteGroup *parentGroup = static_cast<SpriteGroup *>(pointerAt(record.parentGroup, spriteEntries));
+		spriteEntry->entryColor() = decodeColor(record.entryColor);
+		spriteEntry->setParentGroup(parentGroup ? parentGroup : &data.spriteMgr.root());
+		spriteEntries.pushBack(nctl::move(spriteEntry));
+	}
+
+	nctl::Array<nctl::UniquePtr<Script>> &scripts = data.scriptMgr.scripts();
+	for (unsigned int i = 0; i < reader.count(SCRIPTS); i++)
+	{
+		NameRecord record;
+		reader.read(SCRIPTS, i, record);
+		const char *scriptName = reader.name(record.name);
+		const nctl::String scriptPath = Deserializers::resolveScriptPath(scriptName);
+		scripts.pushBack(nctl::makeUnique<Script>(scriptPath.data()));
+		// Set the script name to its basename to allow for relocatable project files
+		scripts.back()->setName(scriptName);
+	}
+
+	const unsigned int numFunctions = GridFunctionLibrary::gridFunctions().size();
+	nctl::HashMap<const char *, const GridFunction *> functionHash(numFunctions * 2);
+	for (unsigned int i = 0; i < numFunctions; i++)
+	{
+		const GridFunction &function = GridFunctionLibrary::gridFunctions()[i];
+		functionHash.insert(function.name().data(), &function);
+	}
+
+	nctl::Array<nctl::UniquePtr<IAnimation>> anims;
+	for (unsigned int i = 0; i < reader.count(ANIMATIONS); i++)
+	{
+		AnimationRecord record;
+		reader.read(ANIMATIONS, i, record);
+
+		nctl::UniquePtr<IAnimation> anim;
+		switch (static_cast<IAnimation::Type>(record.type))
+		{
+			case IAnimation::Type::PARALLEL_GROUP:
+				anim = nctl::makeUnique<ParallelAnimationGroup>();
+				break;
+			case IAnimation::Type::SEQUENTIAL_GROUP:
+				anim = nctl::makeUnique<SequentialAnimationGroup>();
+				break;
+			case IAnimation::Type::PROPERTY:
+			{
+				nctl::UniquePtr<PropertyAnimation> propertyAnim = nctl::makeUnique<PropertyAnimation>();
+				propertyAnim->setSprite(static_cast<Sprite *>(pointerAt(record.sprite, spriteEntries)));
+				propertyAnim->setSpeed(record.speed);
+				decodeCurve(record.curve, propertyAnim->curve());
+				propertyAnim->setProperty(reader.string(record.propertyName));
+				anim = nctl::move(propertyAnim);
+				break;
+			}
+			case IAnimation::Type::GRID:
+			{
+				nctl::UniquePtr<GridAnimation> gridAnim = nctl::makeUnique<GridAnimation>();
+				gridAnim->setSprite(static_cast<Sprite *>(pointerAt(record.sprite, spriteEntries)));
+				gridAnim->setSpeed(record.speed);
+				decodeCurve(record.curve, gridAnim->curve());
+
+				const char *functionName = reader.string(record.functionName);
+				const GridFunction **functionPtr = functionName ? functionHash.find(functionName) : nullptr;
+				if (functionPtr)
+				{
+					const GridFunction *function = *functionPtr;
+					gridAnim->setFunction(function);
+					const bool validRange = uint64_t(record.firstParameter) + record.numParameters <= reader.count(PARAMETERS);
+					for (unsigned int j = 0; validRange && j < record.numParameters && j < function->numParameters(); j++)
+					{
+						ParameterRecord paramRecord;
+						reader.read(PARAMETERS, record.firstParameter + j, paramRecord);
+						if (function->parameterInfo(j).name == reader.name(paramRecord.name))
+						{
+							gridAnim->parameters()[j].value0 = paramRecord.value0;
+							gridAnim->parameters()[j].value1 = paramRecord.value1;
+						}
+					}
+				}
+				anim = nctl::move(gridAnim);
+				break;
+			}
+			case IAnimation::Type::SCRIPT:
+			{
+				nctl::UniquePtr<ScriptAnimation> scriptAnim = nctl::makeUnique<ScriptAnimation>();
+				scriptAnim->setSprite(static_cast<Sprite *>(pointerAt(record.sprite, spriteEntries)));
+				scriptAnim->setSpeed(record.speed);
+				decodeCurve(record.curve, scriptAnim->curve());
+				scriptAnim->setScript(pointerAt(record.script, scripts));
+				anim = nctl::move(scriptAnim);
+				break;
+			}
+		}
+
+		if (anim->isGroup())
+			decodeLoop(record.loop, static_cast<AnimationGroup &>(*anim).loop());
+
+		anim->name = reader.name(record.name);
+		anim->enabled = (record.enabled != 0);
+		AnimationGroup *parent = static_cast<AnimationGroup *>(pointerAt(record.parent, anims));
+		anim->setParent(parent ? parent : &data.animMgr.animGroup());
+		anim->setDelay(record.delay);
+		anims.pushBack(nctl::move(anim));
+	}
+
+	if (data.animMgr.anims().capacity() < anims.size())
+		data.animMgr.anims().setCapacity(anims.size());
+	for (unsigned int i = 0; i < anims.size(); i++)
+		anims[i]->parent()->anims().pushBack(nctl::move(anims[i]));
+
+	// Stop all animations to get the initial state
+	data.animMgr.animGroup().stop();
+
+	// After the animations have been decoded, the array of sprite entries can be moved to the sprite manager
+	if (data.spriteMgr.children().capacity() < spriteEntries.size())
+		data.spriteMgr.children().setCapacity(spriteEntries.size());
+	for (unsigned int i = 0; i < spriteEntries.size(); i++)
+		spriteEntries[i]->parentGroup()->children().pushBack(nctl::move(spriteEntries[i]));
+	data.spriteMgr.updateSpritesArray();
+
+	return true;
+}
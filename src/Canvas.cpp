@@ -2,6 +2,7 @@
 
 #include "Canvas.h"
 #include "RenderingResources.h"
+#include "FrameProfiler.h"
 #include <ncine/Application.h>
 #include <ncine/GLTexture.h>
 #include <ncine/GLFramebufferObject.h>
@@ -100,6 +101,7 @@ void Canvas::unbind()
 
 void Canvas::save(const char *filename)
 {
+	FrameProfiler::beginScope("Readback");
 #if !defined(NCINE_WITH_OPENGLES) && !defined(__EMSCRIPTEN__)
 	fbo_->unbind();
 	texture_->getTexImage(0, GL_RGBA, GL_UNSIGNED_BYTE, pixels_.get());
@@ -109,7 +111,9 @@ void Canvas::save(const char *filename)
 	glReadPixels(0, 0, texWidth_, texHeight_, GL_RGBA, GL_UNSIGNED_BYTE, pixels_.get());
 	fbo_->unbind();
 #endif
+	FrameProfiler::endScope();
 
+	ProfileScope profileScope("Encoding");
 	nc::TextureSaverPng saver;
 	nc::ITextureSaver::Properties props;
 	props.width = texWidth_;
@@ -0,0 +1,211 @@
+#if defined(__linux__)
+	#include <cerrno>
+	#include <cstdint>
+	#include <unistd.h>
+	#include <poll.h>
+	#include <sys/eventfd.h>
+	#include <sys/inotify.h>
+#endif
+
+#include <ncine/FileSystem.h>
+#include "FileWatcher.h"
+
+///////////////////////////////////////////////////////////
+// STATIC DEFINITIONS
+///////////////////////////////////////////////////////////
+
+const float FileWatcher::DebounceTime = 0.25f;
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+FileWatcher::FileWatcher()
+    : inotifyFd_(-1), wakeUpFd_(-1)
+{
+#if defined(__linux__)
+	inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	wakeUpFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (inotifyFd_ >= 0 && wakeUpFd_ >= 0)
+		thread_ = std::thread([this]() { watcherLoop(); });
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#if defined(__linux__)
+	if (thread_.joinable())
+	{
+		const uint64_t value = 1;
+		const ssize_t bytesWritten = write(wakeUpFd_, &value, sizeof(value));
+		static_cast<void>(bytesWritten);
+		thread_.join();
+	}
+
+	// Closing the descriptor also removes all its watches
+	if (inotifyFd_ >= 0)
+		close(inotifyFd_);
+	if (wakeUpFd_ >= 0)
+		close(wakeUpFd_);
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void FileWatcher::setFiles(const nctl::Array<const char *> &filenames)
+{
+#if defined(__linux__)
+	if (thread_.joinable() == false)
+		return;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	// Compared with the requested files, as the ones that cannot be watched are missing from the accepted ones
+	bool hasChanged = (filenames.size() != requestedFiles_.size());
+	for (unsigned int i = 0; i < filenames.size() && hasChanged == false; i++)
+		hasChanged = (requestedFiles_[i] != filenames[i]);
+	if (hasChanged == false)
+		return;
+
+	requestedFiles_.clear();
+	for (unsigned int i = 0; i < filenames.size(); i++)
+		requestedFiles_.pushBack(nctl::String(filenames[i]));
+
+	// Files are watched through their directories, as editors often save by replacing the file
+	nctl::Array<Directory> directories;
+	nctl::Array<nctl::String> failedDirectories;
+	files_.clear();
+	for (unsigned int i = 0; i < filenames.size(); i++)
+	{
+		const nctl::String dirName = nc::fs::dirName(filenames[i]);
+		int watchDescriptor = -1;
+		for (unsigned int j = 0; j < directories.size(); j++)
+		{
+			if (directories[j].path == dirName)
+			{
+				watchDescriptor = directories[j].watchDescriptor;
+				break;
+			}
+		}
+
+		if (watchDescriptor < 0)
+		{
+			bool hasFailed = false;
+			for (unsigned int j = 0; j < failedDirectories.size() && hasFailed == false; j++)
+				hasFailed = (failedDirectories[j] == dirName);
+			if (hasFailed)
+				continue;
+
+			// Adding a watch to an already watched directory returns the same descriptor
+			watchDescriptor = inotify_add_watch(inotifyFd_, dirName.data(), IN_CLOSE_WRITE | IN_MOVED_TO);
+			if (watchDescriptor < 0)
+			{
+				failedDirectories.pushBack(dirName);
+				continue;
+			}
+			directories.pushBack({ dirName, watchDescriptor });
+		}
+
+		files_.pushBack({ nctl::String(filenames[i]), nc::fs::baseName(filenames[i]), watchDescriptor });
+	}
+
+	for (unsigned int i = 0; i < directories_.size(); i++)
+	{
+		bool isStillWatched = false;
+		for (unsigned int j = 0; j < directories.size(); j++)
+		{
+			if (directories[j].watchDescriptor == directories_[i].watchDescriptor)
+			{
+				isStillWatched = true;
+				break;
+			}
+		}
+
+		if (isStillWatched == false)
+			inotify_rm_watch(inotifyFd_, directories_[i].watchDescriptor);
+	}
+	directories_ = nctl::move(directories);
+#endif
+}
+
+void FileWatcher::poll(nctl::Array<nctl::String> &changedFiles)
+{
+	changedFiles.clear();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (unsigned int i = 0; i < changes_.size();)
+	{
+		if (changes_[i].lastEvent.secondsSince() >= DebounceTime)
+		{
+			changedFiles.pushBack(nctl::move(changes_[i].filename));
+			changes_.removeAt(i);
+		}
+		else
+			i++;
+	}
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void FileWatcher::watcherLoop()
+{
+#if defined(__linux__)
+	alignas(inotify_event) char buffer[4096];
+	pollfd pollFds[2] = { { inotifyFd_, POLLIN, 0 }, { wakeUpFd_, POLLIN, 0 } };
+
+	while (true)
+	{
+		if (::poll(pollFds, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		if (pollFds[1].revents & POLLIN)
+			break;
+		if ((pollFds[0].revents & POLLIN) == 0)
+			continue;
+
+		const ssize_t length = read(inotifyFd_, buffer, sizeof(buffer));
+		if (length <= 0)
+			continue;
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (ssize_t offset = 0; offset < length;)
+		{
+			const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+			if (event->len > 0)
+				recordEvent(event->wd, event->name);
+			offset += sizeof(inotify_event) + event->len;
+		}
+	}
+#endif
+}
+
+void FileWatcher::recordEvent(int watchDescriptor, const char *name)
+{
+	for (unsigned int i = 0; i < files_.size(); i++)
+	{
+		const WatchedFile &file = files_[i];
+		if (file.watchDescriptor != watchDescriptor || file.baseName != name)
+			continue;
+
+		// Every new event for the same file postpones its notification
+		for (unsigned int j = 0; j < changes_.size(); j++)
+		{
+			if (changes_[j].filename == file.filename)
+			{
+				changes_[j].lastEvent = nc::TimeStamp::now();
+				return;
+			}
+		}
+
+		changes_.pushBack({ file.filename, nc::TimeStamp::now() });
+		return;
+	}
+}
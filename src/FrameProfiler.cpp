@@ -0,0 +1,269 @@
+#include <ncine/config.h>
+
+#define NCINE_INCLUDE_OPENGL
+#include <ncine/common_headers.h>
+#ifdef __MINGW32__
+	#undef ERROR
+	#undef DELETE
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <nctl/UniquePtr.h>
+#include <ncine/IFile.h>
+#include "FrameProfiler.h"
+#include "file_utils.h"
+
+#if !defined(NCINE_WITH_OPENGLES) && !defined(__EMSCRIPTEN__)
+	#define WITH_GPU_TIMERS 1
+#else
+	#define WITH_GPU_TIMERS 0
+#endif
+
+namespace {
+
+#if WITH_GPU_TIMERS
+/// Queries are recycled only after their result has been read, the ring covers a few frames of latency
+const unsigned int NumGpuQueries = 4;
+
+struct GpuQuery
+{
+	GLuint id = 0;
+	bool isPending = false;
+	unsigned int frameIndex = 0;
+};
+
+GpuQuery gpuQueries[NumGpuQueries];
+unsigned int nextGpuQuery = 0;
+bool isGpuTimerActive = false;
+#endif
+
+/// Copies a scope name, long names keep their end where file names are
+void copyName(char *dest, const char *name)
+{
+	const size_t length = strlen(name);
+	const size_t maxLength = FrameProfiler::MaxNameLength - 1;
+	const char *source = (length > maxLength) ? name + length - maxLength : name;
+	strncpy(dest, source, maxLength);
+	dest[maxLength] = '\0';
+}
+
+}
+
+///////////////////////////////////////////////////////////
+// STATIC DEFINITIONS
+///////////////////////////////////////////////////////////
+
+FrameProfiler::Frame FrameProfiler::frames_[HistoryLength];
+unsigned int FrameProfiler::frameIndex_ = 0;
+unsigned int FrameProfiler::numFrames_ = 0;
+bool FrameProfiler::isInFrame_ = false;
+nc::TimeStamp FrameProfiler::frameStart_;
+double FrameProfiler::elapsedTime_ = 0.0;
+std::thread::id FrameProfiler::mainThreadId_;
+nctl::Array<int> FrameProfiler::openScopes_;
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void FrameProfiler::beginFrame()
+{
+	if (numFrames_ == 0)
+		mainThreadId_ = std::this_thread::get_id();
+	else
+		elapsedTime_ += frameStart_.secondsSince();
+	frameStart_ = nc::TimeStamp::now();
+
+	Frame &frame = frames_[frameIndex_];
+	frame.scopes.clear();
+	frame.startTime = elapsedTime_;
+	frame.cpuTime = 0.0f;
+	frame.gpuTime = 0.0f;
+	openScopes_.clear();
+	isInFrame_ = true;
+
+	readGpuTimers();
+}
+
+void FrameProfiler::endFrame()
+{
+	if (isInFrame_ == false)
+		return;
+
+	// Scopes left open by an early return are closed at the end of the frame
+	while (openScopes_.isEmpty() == false)
+		endScope();
+
+	frames_[frameIndex_].cpuTime = frameStart_.secondsSince() * 1000.0f;
+	frameIndex_ = (frameIndex_ + 1) % HistoryLength;
+	numFrames_++;
+	isInFrame_ = false;
+}
+
+void FrameProfiler::beginScope(const char *name)
+{
+	if (isInFrame_ == false || std::this_thread::get_id() != mainThreadId_)
+		return;
+
+	nctl::Array<Scope> &scopes = frames_[frameIndex_].scopes;
+	if (scopes.size() >= MaxScopesPerFrame)
+	{
+		openScopes_.pushBack(-1);
+		return;
+	}
+
+	Scope scope;
+	copyName(scope.name, name);
+	scope.depth = openScopes_.size();
+	scope.start = frameStart_.secondsSince() * 1000.0f;
+	scope.duration = 0.0f;
+	openScopes_.pushBack(static_cast<int>(scopes.size()));
+	scopes.pushBack(scope);
+}
+
+void FrameProfiler::endScope()
+{
+	if (isInFrame_ == false || openScopes_.isEmpty() || std::this_thread::get_id() != mainThreadId_)
+		return;
+
+	const int index = openScopes_.back();
+	openScopes_.popBack();
+	if (index >= 0)
+	{
+		Scope &scope = frames_[frameIndex_].scopes[index];
+		scope.duration = frameStart_.secondsSince() * 1000.0f - scope.start;
+	}
+}
+
+void FrameProfiler::beginGpuTimer()
+{
+#if WITH_GPU_TIMERS
+	if (isInFrame_ == false)
+		return;
+
+	GpuQuery &query = gpuQueries[nextGpuQuery];
+	// The timing of this frame is skipped rather than waiting for an old result
+	if (query.isPending)
+		return;
+
+	if (query.id == 0)
+		glGenQueries(1, &query.id);
+	glBeginQuery(GL_TIME_ELAPSED, query.id);
+	isGpuTimerActive = true;
+#endif
+}
+
+void FrameProfiler::endGpuTimer()
+{
+#if WITH_GPU_TIMERS
+	if (isGpuTimerActive == false)
+		return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	GpuQuery &query = gpuQueries[nextGpuQuery];
+	query.isPending = true;
+	query.frameIndex = frameIndex_;
+	nextGpuQuery = (nextGpuQuery + 1) % NumGpuQueries;
+	isGpuTimerActive = false;
+#endif
+}
+
+const FrameProfiler::Frame &FrameProfiler::lastFrame()
+{
+	return frame(0);
+}
+
+const FrameProfiler::Frame &FrameProfiler::frame(unsigned int age)
+{
+	ASSERT(age < HistoryLength - 1);
+	const unsigned int index = (frameIndex_ + 2 * HistoryLength - 1 - age) % HistoryLength;
+	return frames_[index];
+}
+
+bool FrameProfiler::saveChromeTrace(const char *filename)
+{
+	nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(filename);
+	fileHandle->open(nc::IFile::OpenMode::WRITE | nc::IFile::OpenMode::BINARY);
+	if (fileHandle->isOpened() == false)
+		return false;
+
+	nc::IFile &file = *fileHandle;
+	const char header[] = "{\"traceEvents\":[\n";
+	file.write(header, sizeof(header) - 1);
+
+	// Every frame is an event containing its scopes, the GPU time is a counter
+	char buffer[256];
+	bool isFirstEvent = true;
+	for (int age = static_cast<int>(numFrames()) - 1; age >= 0; age--)
+	{
+		const Frame &frame = FrameProfiler::frame(age);
+		const double frameStart = frame.startTime * 1000000.0;
+
+		int length = snprintf(buffer, sizeof(buffer), "%s{\"name\":\"Frame\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+		                      isFirstEvent ? "" : ",\n", frameStart, frame.cpuTime * 1000.0);
+		file.write(buffer, length);
+		isFirstEvent = false;
+
+		length = snprintf(buffer, sizeof(buffer), ",\n{\"name\":\"GPU\",\"ph\":\"C\",\"pid\":0,\"ts\":%.3f,\"args\":{\"ms\":%.3f}}",
+		                  frameStart, frame.gpuTime);
+		file.write(buffer, length);
+
+		for (unsigned int i = 0; i < frame.scopes.size(); i++)
+		{
+			const Scope &scope = frame.scopes[i];
+			const char nameField[] = ",\n{\"name\":";
+			file.write(nameField, sizeof(nameField) - 1);
+			fileUtils::writeJsonString(file, scope.name);
+			length = snprintf(buffer, sizeof(buffer), ",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+			                  frameStart + scope.start * 1000.0, scope.duration * 1000.0);
+			file.write(buffer, length);
+		}
+	}
+
+	const char footer[] = "\n],\"displayTimeUnit\":\"ms\"}\n";
+	file.write(footer, sizeof(footer) - 1);
+	file.close();
+
+	return true;
+}
+
+void FrameProfiler::dispose()
+{
+#if WITH_GPU_TIMERS
+	for (unsigned int i = 0; i < NumGpuQueries; i++)
+	{
+		if (gpuQueries[i].id != 0)
+			glDeleteQueries(1, &gpuQueries[i].id);
+		gpuQueries[i] = GpuQuery();
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void FrameProfiler::readGpuTimers()
+{
+#if WITH_GPU_TIMERS
+	for (unsigned int i = 0; i < NumGpuQueries; i++)
+	{
+		GpuQuery &query = gpuQueries[i];
+		if (query.isPending == false)
+			continue;
+
+		GLint isAvailable = GL_FALSE;
+		glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+		if (isAvailable == GL_FALSE)
+			continue;
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &nanoseconds);
+		// A result as old as the history would belong to a slot that has just been cleared
+		if (query.frameIndex != frameIndex_)
+			frames_[query.frameIndex].gpuTime = static_cast<float>(nanoseconds / 1000000.0);
+		query.isPending = false;
+	}
+#endif
+}
@@ -1,8 +1,12 @@
 #include "GridAnimation.h"
+#include "ObjectPool.h"
 #include "Sprite.h"
 #include "GridFunction.h"
 #include "GridFunctionLibrary.h"
 #include "AnimationGroup.h"
+#include "AnimationManager.h"
+
+#include "singletons.h"
 
 ///////////////////////////////////////////////////////////
 // CONSTRUCTORS and DESTRUCTOR
@@ -20,10 +24,26 @@ GridAnimation::GridAnimation(Sprite *sprite)
 	setSprite(sprite);
 }
 
+GridAnimation::~GridAnimation()
+{
+	if (theAnimMgr.get() != nullptr)
+		theAnimMgr->updateSpriteIndex(this, sprite_, nullptr);
+}
+
 ///////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
 
+void *GridAnimation::operator new(size_t size)
+{
+	return ObjectPool<GridAnimation>::allocate(size);
+}
+
+void GridAnimation::operator delete(void *ptr, size_t size)
+{
+	ObjectPool<GridAnimation>::deallocate(ptr, size);
+}
+
 nctl::UniquePtr<IAnimation> GridAnimation::clone() const
 {
 	nctl::UniquePtr<GridAnimation> anim = nctl::makeUnique<GridAnimation>(sprite_);
@@ -38,7 +58,7 @@ nctl::UniquePtr<IAnimation> GridAnimation::clone() const
 
 void GridAnimation::perform()
 {
-	if (sprite_ && sprite_->visible && gridFunction_)
+	if (sprite_ && sprite_->visible && sprite_->isGridCulled() == false && gridFunction_)
 		gridFunction_->execute(*this);
 }
 
@@ -51,6 +71,8 @@ void GridAnimation::setSprite(Sprite *sprite)
 		if (sprite)
 			sprite->incrementGridAnimCounter();
 
+		if (theAnimMgr.get() != nullptr)
+			theAnimMgr->updateSpriteIndex(this, sprite_, sprite);
 		sprite_ = sprite;
 	}
 }
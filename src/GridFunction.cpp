@@ -1,4 +1,5 @@
 #include "GridFunction.h"
+#include "FrameProfiler.h"
 
 ///////////////////////////////////////////////////////////
 // CONSTRUCTORS and DESTRUCTOR
@@ -52,5 +53,8 @@ GridFunction::ParameterInfo &GridFunction::addParameter(const char *name, Parame
 void GridFunction::execute(GridAnimation &animation) const
 {
 	if (callback_ != nullptr)
+	{
+		ProfileScope profileScope(name_.data());
 		callback_(animation);
+	}
 }
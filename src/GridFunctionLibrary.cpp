@@ -10,20 +10,58 @@ nctl::Array<GridFunction> GridFunctionLibrary::gridFunctions_(4);
 
 namespace {
 
+/// Hashes an integer into a pseudo-random value in the [-1.0, 1.0] range
+inline float hashToSignedUnit(unsigned int value)
+{
+	value ^= value >> 16;
+	value *= 0x7feb352du;
+	value ^= value >> 15;
+	value *= 0x846ca68bu;
+	value ^= value >> 16;
+	return static_cast<float>(value) * (2.0f / 4294967295.0f) - 1.0f;
+}
+
 void waveX(GridAnimation &gridAnimation)
 {
-	const float value = gridAnimation.curve().value();
 	const nctl::Array<GridFunctionParameter> &parameters = gridAnimation.parameters();
+	GridFunctionLibrary::applyWaveX(*gridAnimation.sprite(), gridAnimation.curve().value(),
+	                                parameters[0].value0, parameters[1].value0, parameters[2].value0);
+}
 
-	const float amplitude = parameters[0].value0;
-	const float frequency = parameters[1].value0;
-	const float py = parameters[2].value0;
-	Sprite *sprite = gridAnimation.sprite();
+void waveY(GridAnimation &gridAnimation)
+{
+	const nctl::Array<GridFunctionParameter> &parameters = gridAnimation.parameters();
+	GridFunctionLibrary::applyWaveY(*gridAnimation.sprite(), gridAnimation.curve().value(),
+	                                parameters[0].value0, parameters[1].value0, parameters[2].value0);
+}
 
-	const int width = sprite->width();
-	const int height = sprite->height();
+void skewX(GridAnimation &gridAnimation)
+{
+	const nctl::Array<GridFunctionParameter> &parameters = gridAnimation.parameters();
+	GridFunctionLibrary::applySkewX(*gridAnimation.sprite(), gridAnimation.curve().value(), parameters[0].value0);
+}
+
+void skewY(GridAnimation &gridAnimation)
+{
+	const nctl::Array<GridFunctionParameter> &parameters = gridAnimation.parameters();
+	GridFunctionLibrary::applySkewY(*gridAnimation.sprite(), gridAnimation.curve().value(), parameters[0].value0);
+}
+
+void zoom(GridAnimation &gridAnimation)
+{
+	const nctl::Array<GridFunctionParameter> &parameters = gridAnimation.parameters();
+	GridFunctionLibrary::applyZoom(*gridAnimation.sprite(), gridAnimation.curve().value(),
+	                               parameters[0].value0, parameters[1].value0);
+}
+
+}
+
+void GridFunctionLibrary::applyWaveX(Sprite &sprite, float value, float amplitude, float frequency, float py)
+{
+	const int width = sprite.width();
+	const int height = sprite.height();
 	const int halfHeight = height / 2;
-	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite->interleavedVertices();
+	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite.interleavedVertices();
 
 	for (int y = 0; y < height + 1; y++)
 	{
@@ -38,20 +76,12 @@ void waveX(GridAnimation &gridAnimation)
 	}
 }
 
-void waveY(GridAnimation &gridAnimation)
+void GridFunctionLibrary::applyWaveY(Sprite &sprite, float value, float amplitude, float frequency, float px)
 {
-	const float value = gridAnimation.curve().value();
-	const nctl::Array<GridFunctionParameter> &parameters = gridAnimation.parameters();
-
-	const float amplitude = parameters[0].value0;
-	const float frequency = parameters[1].value0;
-	const float px = parameters[2].value0;
-	Sprite *sprite = gridAnimation.sprite();
-
-	const int width = sprite->width();
-	const int height = sprite->height();
+	const int width = sprite.width();
+	const int height = sprite.height();
 	const int halfWidth = width / 2;
-	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite->interleavedVertices();
+	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite.interleavedVertices();
 
 	for (int x = 0; x < width + 1; x++)
 	{
@@ -66,19 +96,13 @@ void waveY(GridAnimation &gridAnimation)
 	}
 }
 
-void skewX(GridAnimation &gridAnimation)
+void GridFunctionLibrary::applySkewX(Sprite &sprite, float value, float py)
 {
-	const float value = gridAnimation.curve().value();
-	const nctl::Array<GridFunctionParameter> &parameters = gridAnimation.parameters();
-
-	const float py = parameters[0].value0;
-	Sprite *sprite = gridAnimation.sprite();
-
-	const int width = sprite->width();
-	const int height = sprite->height();
+	const int width = sprite.width();
+	const int height = sprite.height();
 	const int halfHeight = height / 2;
 	const float invWidth = 1.0f / float(width);
-	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite->interleavedVertices();
+	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite.interleavedVertices();
 
 	for (int y = 0; y < height + 1; y++)
 	{
@@ -93,19 +117,13 @@ void skewX(GridAnimation &gridAnimation)
 	}
 }
 
-void skewY(GridAnimation &gridAnimation)
+void GridFunctionLibrary::applySkewY(Sprite &sprite, float value, float px)
 {
-	const float value = gridAnimation.curve().value();
-	const nctl::Array<GridFunctionParameter> &parameters = gridAnimation.parameters();
-
-	const float px = parameters[0].value0;
-	Sprite *sprite = gridAnimation.sprite();
-
-	const int width = sprite->width();
-	const int height = sprite->height();
+	const int width = sprite.width();
+	const int height = sprite.height();
 	const int halfWidth = width / 2;
 	const float invHeight = 1.0f / float(height);
-	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite->interleavedVertices();
+	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite.interleavedVertices();
 
 	for (int x = 0; x < width + 1; x++)
 	{
@@ -120,22 +138,15 @@ void skewY(GridAnimation &gridAnimation)
 	}
 }
 
-void zoom(GridAnimation &gridAnimation)
+void GridFunctionLibrary::applyZoom(Sprite &sprite, float value, float px, float py)
 {
-	const float value = gridAnimation.curve().value();
-	const nctl::Array<GridFunctionParameter> &parameters = gridAnimation.parameters();
-
-	const float px = parameters[0].value0;
-	const float py = parameters[1].value0;
-	Sprite *sprite = gridAnimation.sprite();
-
-	const int width = sprite->width();
-	const int height = sprite->height();
+	const int width = sprite.width();
+	const int height = sprite.height();
 	const int halfWidth = width / 2;
 	const int halfHeight = height / 2;
 	const float invWidth = 1.0f / float(width);
 	const float invHeight = 1.0f / float(height);
-	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite->interleavedVertices();
+	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite.interleavedVertices();
 
 	for (int y = 0; y < height + 1; y++)
 	{
@@ -153,6 +164,47 @@ void zoom(GridAnimation &gridAnimation)
 	}
 }
 
+void GridFunctionLibrary::applyNoise(Sprite &sprite, float amount, unsigned int seed)
+{
+	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite.interleavedVertices();
+	const unsigned int seedX = seed * 2u;
+	const unsigned int seedY = seed * 2u + 1u;
+
+	for (unsigned int i = 0; i < interleavedVertices.size(); i++)
+	{
+		Sprite::Vertex &v = interleavedVertices[i];
+		v.x += amount * hashToSignedUnit(i ^ (seedX * 0x9e3779b9u));
+		v.y += amount * hashToSignedUnit(i ^ (seedY * 0x9e3779b9u));
+	}
+}
+
+void GridFunctionLibrary::applyAffine(Sprite &sprite, const float matrix[6])
+{
+	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite.interleavedVertices();
+
+	for (unsigned int i = 0; i < interleavedVertices.size(); i++)
+	{
+		Sprite::Vertex &v = interleavedVertices[i];
+		const float x = v.x;
+		const float y = v.y;
+		v.x = matrix[0] * x + matrix[2] * y + matrix[4];
+		v.y = matrix[1] * x + matrix[3] * y + matrix[5];
+	}
+}
+
+void GridFunctionLibrary::lerpToRest(Sprite &sprite, float factor)
+{
+	nctl::Array<Sprite::Vertex> &interleavedVertices = sprite.interleavedVertices();
+	const nctl::Array<Sprite::Vertex> &restPositions = sprite.vertexRestPositions();
+	ASSERT(interleavedVertices.size() == restPositions.size());
+
+	for (unsigned int i = 0; i < interleavedVertices.size(); i++)
+	{
+		Sprite::Vertex &v = interleavedVertices[i];
+		const Sprite::Vertex &rest = restPositions[i];
+		v.x += (rest.x - v.x) * factor;
+		v.y += (rest.y - v.y) * factor;
+	}
 }
 
 void GridFunctionLibrary::init()
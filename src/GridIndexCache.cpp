@@ -0,0 +1,115 @@
+#include "GridIndexCache.h"
+#include <ncine/GLBufferObject.h>
+
+namespace {
+
+uint64_t sizeKey(int width, int height)
+{
+	return (static_cast<uint64_t>(width) << 32) | static_cast<uint32_t>(height);
+}
+
+void fillIndices(int width, int height, nctl::Array<unsigned int> &indices)
+{
+	const unsigned int gridWidth = static_cast<unsigned int>(width + 1);
+
+	unsigned int vertexIndex = gridWidth;
+	for (unsigned int i = 0; i < static_cast<unsigned int>(height); i++)
+	{
+		for (unsigned int j = 0; j < gridWidth; j++)
+		{
+			indices.pushBack(vertexIndex + j);
+			if (j == 0 && i != 0) // degenerate vertex
+				indices.pushBack(vertexIndex + j);
+			indices.pushBack(vertexIndex + j - gridWidth);
+		}
+		if (i != gridWidth - 2) // degenerate vertex
+			indices.pushBack(indices.back());
+		vertexIndex += gridWidth;
+	}
+}
+
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+GridIndexCache::Entry::Entry()
+    : width(0), height(0), numIndices(0), shortIndices(false), refCount(0)
+{
+}
+
+GridIndexCache::Entry::~Entry()
+{
+}
+
+GridIndexCache::GridIndexCache()
+    : entries_(4), hashMap_(16)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+GridIndexCache::Entry *GridIndexCache::acquire(int width, int height)
+{
+	ASSERT(width > 0 && height > 0);
+	const uint64_t key = sizeKey(width, height);
+	Entry **entryPtr = hashMap_.find(key);
+	if (entryPtr != nullptr)
+	{
+		(*entryPtr)->refCount++;
+		return *entryPtr;
+	}
+
+	// The indices only live on the CPU until they are uploaded
+	nctl::Array<unsigned int> indices((width + 2) * height * 2);
+	fillIndices(width, height, indices);
+
+	nctl::UniquePtr<Entry> entry = nctl::makeUnique<Entry>();
+	entry->ibo = nctl::makeUnique<nc::GLBufferObject>(GL_ELEMENT_ARRAY_BUFFER);
+	entry->width = width;
+	entry->height = height;
+	entry->numIndices = indices.size();
+	entry->shortIndices = (indices.size() < 65536);
+	entry->refCount = 1;
+
+	if (entry->shortIndices)
+	{
+		nctl::Array<unsigned short> shortIndices(indices.size());
+		for (unsigned int i = 0; i < indices.size(); i++)
+			shortIndices.pushBack(static_cast<unsigned short>(indices[i]));
+		entry->ibo->bufferData(shortIndices.size() * sizeof(unsigned short), shortIndices.data(), GL_STATIC_DRAW);
+	}
+	else
+		entry->ibo->bufferData(indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+	if ((hashMap_.size() + 1) * 2 > hashMap_.capacity())
+		hashMap_.rehash(hashMap_.capacity() * 2);
+	hashMap_.insert(key, entry.get());
+	entries_.pushBack(nctl::move(entry));
+
+	return entries_.back().get();
+}
+
+void GridIndexCache::release(Entry *entry)
+{
+	if (entry == nullptr)
+		return;
+
+	ASSERT(entry->refCount > 0);
+	entry->refCount--;
+	if (entry->refCount > 0)
+		return;
+
+	hashMap_.remove(sizeKey(entry->width, entry->height));
+	for (unsigned int i = 0; i < entries_.size(); i++)
+	{
+		if (entries_[i].get() == entry)
+		{
+			entries_.removeAt(i);
+			break;
+		}
+	}
+}
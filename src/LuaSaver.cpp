@@ -9,6 +9,7 @@
 #include "GridFunctionLibrary.h"
 #include "Configuration.h"
 
+#include "BinarySaver.h"
 #include "Serializers.h"
 #include "LuaSerializer.h"
 #include "SerializerContext.h"
@@ -32,6 +33,11 @@ nctl::String LuaSaver::defaultCfgFile_(256);
 LuaSaver::LuaSaver(unsigned int bufferSize)
 {
 	serializer_ = nctl::makeUnique<LuaSerializer>(bufferSize);
+	binarySaver_ = nctl::makeUnique<BinarySaver>();
+}
+
+LuaSaver::~LuaSaver()
+{
 }
 
 ///////////////////////////////////////////////////////////
@@ -40,6 +46,9 @@ LuaSaver::LuaSaver(unsigned int bufferSize)
 
 bool LuaSaver::load(const char *filename, Data &data)
 {
+	if (BinarySaver::isBinaryProject(filename))
+		return binarySaver_->load(filename, data);
+
 	DeserializerContext context;
 	serializer_->setContext(&context);
 	context.textures = &data.spriteMgr.textures();
@@ -99,7 +108,7 @@ bool LuaSaver::load(const char *filename, Data &data)
 	return true;
 }
 
-void visitSpriteEntries(const SpriteEntry *spriteEntry, nctl::Array<const SpriteEntry *> &spriteEntries)
+void LuaSaver::visitSpriteEntries(const SpriteEntry *spriteEntry, nctl::Array<const SpriteEntry *> &spriteEntries)
 {
 	spriteEntries.pushBack(spriteEntry);
 
@@ -111,7 +120,7 @@ void visitSpriteEntries(const SpriteEntry *spriteEntry, nctl::Array<const Sprite
 	}
 }
 
-void visitAnimations(const IAnimation *anim, nctl::Array<const IAnimation *> &anims)
+void LuaSaver::visitAnimations(const IAnimation *anim, nctl::Array<const IAnimation *> &anims)
 {
 	anims.pushBack(anim);
 
@@ -124,12 +133,20 @@ void visitAnimations(const IAnimation *anim, nctl::Array<const IAnimation *> &an
 	}
 }
 
-void LuaSaver::save(const char *filename, const Data &data)
+bool LuaSaver::save(const char *filename, const Data &data)
 {
+	if (BinarySaver::isBinaryProject(filename))
+		return binarySaver_->save(filename, data);
+
 	SerializerContext context;
 	serializer_->setContext(&context);
 
 	serializer_->reset();
+	// Projects can be large, they are written in chunks while being serialized
+#ifndef __EMSCRIPTEN__
+	if (serializer_->openStream(filename) == false)
+		return false;
+#endif
 
 	Serializers::serializeGlobal(*serializer_, "version", ProjectVersion);
 	serializer_->buffer().append("\n");
@@ -189,7 +206,7 @@ void LuaSaver::save(const char *filename, const Data &data)
 		Serializers::serialize(*serializer_, "animations", anims);
 	}
 
-	serializer_->save(filename);
+	return serializer_->save(filename);
 }
 
 bool LuaSaver::loadCfg(const char *filename, Configuration &cfg)
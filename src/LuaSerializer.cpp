@@ -1,10 +1,14 @@
+#include <cstdint>
+#include <cstring>
 #include "LuaSerializer.h"
+#include "file_utils.h"
 #include <ncine/LuaStateManager.h>
 #include <ncine/LuaVector2Utils.h>
 #include <ncine/LuaVector3Utils.h>
 #include <ncine/LuaRectUtils.h>
 #include <ncine/LuaColorUtils.h>
 #include <ncine/IFile.h>
+#include <ncine/FileSystem.h>
 
 #include <ncine/Rect.h>
 #include <ncine/Vector4.h>
@@ -15,6 +19,332 @@
 	#include <ncine/EmscriptenLocalFile.h>
 #endif
 
+namespace {
+
+/// Enough for a sign, nine significant digits, a decimal point, leading zeros and an exponent
+const unsigned int MaxFloatLength = 32;
+
+// The shortest round-trip conversion follows the Ryu algorithm by Ulf Adams (Apache 2.0 or Boost license)
+const int FloatMantissaBits = 23;
+const int FloatExponentBits = 8;
+const int FloatBias = 127;
+
+const int FloatPow5InvBitCount = 59;
+/// Values of `2^(pow5bits(i) - 1 + FloatPow5InvBitCount) / 5^i + 1`
+const uint64_t FloatPow5InvSplit[31] = {
+	576460752303423489ULL, 461168601842738791ULL, 368934881474191033ULL,
+	295147905179352826ULL, 472236648286964522ULL, 377789318629571618ULL,
+	302231454903657294ULL, 483570327845851670ULL, 386856262276681336ULL,
+	309485009821345069ULL, 495176015714152110ULL, 396140812571321688ULL,
+	316912650057057351ULL, 507060240091291761ULL, 405648192073033409ULL,
+	324518553658426727ULL, 519229685853482763ULL, 415383748682786211ULL,
+	332306998946228969ULL, 531691198313966350ULL, 425352958651173080ULL,
+	340282366920938464ULL, 544451787073501542ULL, 435561429658801234ULL,
+	348449143727040987ULL, 557518629963265579ULL, 446014903970612463ULL,
+	356811923176489971ULL, 570899077082383953ULL, 456719261665907162ULL,
+	365375409332725730ULL
+};
+
+const int FloatPow5BitCount = 61;
+/// Values of `5^i` normalized to `FloatPow5BitCount` bits
+const uint64_t FloatPow5Split[47] = {
+	1152921504606846976ULL, 1441151880758558720ULL, 1801439850948198400ULL,
+	2251799813685248000ULL, 1407374883553280000ULL, 1759218604441600000ULL,
+	2199023255552000000ULL, 1374389534720000000ULL, 1717986918400000000ULL,
+	2147483648000000000ULL, 1342177280000000000ULL, 1677721600000000000ULL,
+	2097152000000000000ULL, 1310720000000000000ULL, 1638400000000000000ULL,
+	2048000000000000000ULL, 1280000000000000000ULL, 1600000000000000000ULL,
+	2000000000000000000ULL, 1250000000000000000ULL, 1562500000000000000ULL,
+	1953125000000000000ULL, 1220703125000000000ULL, 1525878906250000000ULL,
+	1907348632812500000ULL, 1192092895507812500ULL, 1490116119384765625ULL,
+	1862645149230957031ULL, 1164153218269348144ULL, 1455191522836685180ULL,
+	1818989403545856475ULL, 2273736754432320594ULL, 1421085471520200371ULL,
+	1776356839400250464ULL, 2220446049250313080ULL, 1387778780781445675ULL,
+	1734723475976807094ULL, 2168404344971008868ULL, 1355252715606880542ULL,
+	1694065894508600678ULL, 2117582368135750847ULL, 1323488980084844279ULL,
+	1654361225106055349ULL, 2067951531382569187ULL, 1292469707114105741ULL,
+	1615587133892632177ULL, 2019483917365790221ULL
+};
+
+/// Returns `1` if `e` is zero, `ceil(log2(5^e))` otherwise
+inline int pow5Bits(int e)
+{
+	return static_cast<int>(((static_cast<uint32_t>(e) * 1217359) >> 19) + 1);
+}
+
+/// Returns `floor(log10(2^e))`
+inline uint32_t log10Pow2(int e)
+{
+	return (static_cast<uint32_t>(e) * 78913) >> 18;
+}
+
+/// Returns `floor(log10(5^e))`
+inline uint32_t log10Pow5(int e)
+{
+	return (static_cast<uint32_t>(e) * 732923) >> 20;
+}
+
+bool isMultipleOfPowerOf5(uint32_t value, uint32_t power)
+{
+	uint32_t count = 0;
+	while (value % 5 == 0)
+	{
+		value /= 5;
+		count++;
+	}
+	return count >= power;
+}
+
+inline bool isMultipleOfPowerOf2(uint32_t value, uint32_t power)
+{
+	return (value & ((1u << power) - 1)) == 0;
+}
+
+inline uint32_t mulShift(uint32_t m, uint64_t factor, int shift)
+{
+	const uint64_t bitsLow = static_cast<uint64_t>(m) * static_cast<uint32_t>(factor);
+	const uint64_t bitsHigh = static_cast<uint64_t>(m) * static_cast<uint32_t>(factor >> 32);
+	return static_cast<uint32_t>(((bitsLow >> 32) + bitsHigh) >> (shift - 32));
+}
+
+/// Computes the shortest decimal `mantissa * 10^exponent` that reads back as the finite positive float with the given bits
+void floatToDecimal(uint32_t ieeeMantissa, uint32_t ieeeExponent, uint32_t &mantissa, int &exponent)
+{
+	int e2 = 0;
+	uint32_t m2 = 0;
+	if (ieeeExponent == 0)
+	{
+		e2 = 1 - FloatBias - FloatMantissaBits - 2;
+		m2 = ieeeMantissa;
+	}
+	else
+	{
+		e2 = static_cast<int>(ieeeExponent) - FloatBias - FloatMantissaBits - 2;
+		m2 = (1u << FloatMantissaBits) | ieeeMantissa;
+	}
+	const bool acceptBounds = (m2 & 1) == 0;
+
+	// The interval of values that round to this float, scaled by four
+	const uint32_t mv = 4 * m2;
+	const uint32_t mp = 4 * m2 + 2;
+	const uint32_t mmShift = (ieeeMantissa != 0 || ieeeExponent <= 1) ? 1 : 0;
+	const uint32_t mm = 4 * m2 - 1 - mmShift;
+
+	// Convert the interval to a decimal power base
+	uint32_t vr, vp, vm;
+	int e10 = 0;
+	bool vmIsTrailingZeros = false;
+	bool vrIsTrailingZeros = false;
+	uint32_t lastRemovedDigit = 0;
+	if (e2 >= 0)
+	{
+		const uint32_t q = log10Pow2(e2);
+		e10 = static_cast<int>(q);
+		const int k = FloatPow5InvBitCount + pow5Bits(q) - 1;
+		const int i = -e2 + static_cast<int>(q) + k;
+		vr = mulShift(mv, FloatPow5InvSplit[q], i);
+		vp = mulShift(mp, FloatPow5InvSplit[q], i);
+		vm = mulShift(mm, FloatPow5InvSplit[q], i);
+		if (q != 0 && (vp - 1) / 10 <= vm / 10)
+		{
+			// One removed digit is needed for rounding even if the loop below does not run
+			const int l = FloatPow5InvBitCount + pow5Bits(q - 1) - 1;
+			lastRemovedDigit = mulShift(mv, FloatPow5InvSplit[q - 1], -e2 + static_cast<int>(q) - 1 + l) % 10;
+		}
+		if (q <= 9)
+		{
+			// Only one of `mp`, `mv` and `mm` can be a multiple of five
+			if (mv % 5 == 0)
+				vrIsTrailingZeros = isMultipleOfPowerOf5(mv, q);
+			else if (acceptBounds)
+				vmIsTrailingZeros = isMultipleOfPowerOf5(mm, q);
+			else
+				vp -= isMultipleOfPowerOf5(mp, q) ? 1 : 0;
+		}
+	}
+	else
+	{
+		const uint32_t q = log10Pow5(-e2);
+		e10 = static_cast<int>(q) + e2;
+		const int i = -e2 - static_cast<int>(q);
+		const int k = pow5Bits(i) - FloatPow5BitCount;
+		int j = static_cast<int>(q) - k;
+		vr = mulShift(mv, FloatPow5Split[i], j);
+		vp = mulShift(mp, FloatPow5Split[i], j);
+		vm = mulShift(mm, FloatPow5Split[i], j);
+		if (q != 0 && (vp - 1) / 10 <= vm / 10)
+		{
+			j = static_cast<int>(q) - 1 - (pow5Bits(i + 1) - FloatPow5BitCount);
+			lastRemovedDigit = mulShift(mv, FloatPow5Split[i + 1], j) % 10;
+		}
+		if (q <= 1)
+		{
+			// `mv` has at least two trailing zero bits, `mm` has one only if `mmShift` is one
+			vrIsTrailingZeros = true;
+			if (acceptBounds)
+				vmIsTrailingZeros = (mmShift == 1);
+			else
+				vp--;
+		}
+		else if (q < 31)
+			vrIsTrailingZeros = isMultipleOfPowerOf2(mv, q - 1);
+	}
+
+	// Remove the digits that are shared by the whole interval
+	int removed = 0;
+	if (vmIsTrailingZeros || vrIsTrailingZeros)
+	{
+		while (vp / 10 > vm / 10)
+		{
+			vmIsTrailingZeros &= (vm % 10 == 0);
+			vrIsTrailingZeros &= (lastRemovedDigit == 0);
+			lastRemovedDigit = vr % 10;
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			removed++;
+		}
+		if (vmIsTrailingZeros)
+		{
+			while (vm % 10 == 0)
+			{
+				vrIsTrailingZeros &= (lastRemovedDigit == 0);
+				lastRemovedDigit = vr % 10;
+				vr /= 10;
+				vp /= 10;
+				vm /= 10;
+				removed++;
+			}
+		}
+		// Round to even if the exact value ends with a five followed by zeros
+		if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0)
+			lastRemovedDigit = 4;
+		const bool roundUp = (vr == vm && (acceptBounds == false || vmIsTrailingZeros == false)) || lastRemovedDigit >= 5;
+		mantissa = vr + (roundUp ? 1 : 0);
+	}
+	else
+	{
+		while (vp / 10 > vm / 10)
+		{
+			lastRemovedDigit = vr % 10;
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			removed++;
+		}
+		mantissa = vr + ((vr == vm || lastRemovedDigit >= 5) ? 1 : 0);
+	}
+	exponent = e10 + removed;
+}
+
+/// Writes the shortest decimal text that reads back as the same float, regardless of the current locale
+void formatFloat(float value, char *buffer)
+{
+	uint32_t bits = 0;
+	memcpy(&bits, &value, sizeof(float));
+	const bool isNegative = (bits >> 31) != 0;
+	const uint32_t ieeeMantissa = bits & ((1u << FloatMantissaBits) - 1);
+	const uint32_t ieeeExponent = (bits >> FloatMantissaBits) & ((1u << FloatExponentBits) - 1);
+
+	// Non-finite values are written as Lua expressions
+	if (ieeeExponent == (1u << FloatExponentBits) - 1)
+	{
+		if (ieeeMantissa != 0)
+			strcpy(buffer, "0/0");
+		else
+			strcpy(buffer, isNegative ? "-1/0" : "1/0");
+		return;
+	}
+	// A negative zero needs a decimal point, as an integer zero has no sign in Lua 5.4
+	else if (ieeeExponent == 0 && ieeeMantissa == 0)
+	{
+		strcpy(buffer, isNegative ? "-0.0" : "0");
+		return;
+	}
+
+	uint32_t mantissa = 0;
+	int scale = 0;
+	floatToDecimal(ieeeMantissa, ieeeExponent, mantissa, scale);
+
+	char digits[MaxFloatLength];
+	int numDigits = 0;
+	for (uint32_t rest = mantissa; rest > 0; rest /= 10)
+		digits[numDigits++] = static_cast<char>('0' + rest % 10);
+	for (int i = 0; i < numDigits / 2; i++)
+	{
+		const char digit = digits[i];
+		digits[i] = digits[numDigits - 1 - i];
+		digits[numDigits - 1 - i] = digit;
+	}
+	// Trailing zeros are moved to the exponent
+	while (numDigits > 1 && digits[numDigits - 1] == '0')
+	{
+		numDigits--;
+		scale++;
+	}
+	// Number of digits before the decimal point
+	const int pointPosition = numDigits + scale;
+
+	char *ptr = buffer;
+	if (isNegative)
+		*ptr++ = '-';
+
+	if (pointPosition > 10 || pointPosition < -4)
+	{
+		*ptr++ = digits[0];
+		if (numDigits > 1)
+		{
+			*ptr++ = '.';
+			for (int i = 1; i < numDigits; i++)
+				*ptr++ = digits[i];
+		}
+		*ptr++ = 'e';
+		int exponent = pointPosition - 1;
+		if (exponent < 0)
+		{
+			*ptr++ = '-';
+			exponent = -exponent;
+		}
+		if (exponent >= 10)
+			*ptr++ = static_cast<char>('0' + exponent / 10);
+		*ptr++ = static_cast<char>('0' + exponent % 10);
+	}
+	else if (pointPosition <= 0)
+	{
+		*ptr++ = '0';
+		*ptr++ = '.';
+		for (int i = 0; i < -pointPosition; i++)
+			*ptr++ = '0';
+		for (int i = 0; i < numDigits; i++)
+			*ptr++ = digits[i];
+	}
+	else
+	{
+		for (int i = 0; i < pointPosition; i++)
+			*ptr++ = (i < numDigits) ? digits[i] : '0';
+		if (pointPosition < numDigits)
+		{
+			*ptr++ = '.';
+			for (int i = pointPosition; i < numDigits; i++)
+				*ptr++ = digits[i];
+		}
+	}
+	*ptr = '\0';
+}
+
+/// A float formatted as text, meant to be used as a temporary argument of `formatAppend()`
+class FloatText
+{
+  public:
+	explicit FloatText(float value) { formatFloat(value, buffer_); }
+	inline const char *data() const { return buffer_; }
+
+  private:
+	char buffer_[MaxFloatLength];
+};
+
+}
+
 namespace Serializers {
 
 void serialize(LuaSerializer &ls, const char *name, const nctl::Array<nctl::String> &array)
@@ -46,7 +376,7 @@ void serialize(LuaSerializer &ls, const char *name, unsigned int number)
 
 void serialize(LuaSerializer &ls, const char *name, float number)
 {
-	ls.buffer().formatAppend("%s = %f,\n", name, number);
+	ls.buffer().formatAppend("%s = %s,\n", name, FloatText(number).data());
 }
 
 void serialize(LuaSerializer &ls, const char *name, const nctl::String &string)
@@ -66,7 +396,8 @@ void serialize(LuaSerializer &ls, const char *name, const nc::Recti &rect)
 
 void serialize(LuaSerializer &ls, const char *name, const nc::Rectf &rect)
 {
-	ls.buffer().formatAppend("%s = {x = %f, y = %f, w = %f, h = %f},\n", name, rect.x, rect.y, rect.w, rect.h);
+	ls.buffer().formatAppend("%s = {x = %s, y = %s, w = %s, h = %s},\n", name, FloatText(rect.x).data(), FloatText(rect.y).data(),
+	                         FloatText(rect.w).data(), FloatText(rect.h).data());
 }
 
 void serialize(LuaSerializer &ls, const char *name, const nc::Vector2i &vector)
@@ -76,7 +407,7 @@ void serialize(LuaSerializer &ls, const char *name, const nc::Vector2i &vector)
 
 void serialize(LuaSerializer &ls, const char *name, const nc::Vector2f &vector)
 {
-	ls.buffer().formatAppend("%s = {x = %f, y = %f},\n", name, vector.x, vector.y);
+	ls.buffer().formatAppend("%s = {x = %s, y = %s},\n", name, FloatText(vector.x).data(), FloatText(vector.y).data());
 }
 
 void serialize(LuaSerializer &ls, const char *name, const nc::Vector3i &vector)
@@ -86,7 +417,8 @@ void serialize(LuaSerializer &ls, const char *name, const nc::Vector3i &vector)
 
 void serialize(LuaSerializer &ls, const char *name, const nc::Vector3f &vector)
 {
-	ls.buffer().formatAppend("%s = {x = %f, y = %f, z = %f},\n", name, vector.x, vector.y, vector.z);
+	ls.buffer().formatAppend("%s = {x = %s, y = %s, z = %s},\n", name, FloatText(vector.x).data(),
+	                         FloatText(vector.y).data(), FloatText(vector.z).data());
 }
 
 void serialize(LuaSerializer &ls, const char *name, const nc::Color &color)
@@ -96,7 +428,8 @@ void serialize(LuaSerializer &ls, const char *name, const nc::Color &color)
 
 void serialize(LuaSerializer &ls, const char *name, const nc::Colorf &color)
 {
-	ls.buffer().formatAppend("%s = {r = %f, g = %f, b = %f, a = %f},\n", name, color.r(), color.g(), color.b(), color.a());
+	ls.buffer().formatAppend("%s = {r = %s, g = %s, b = %s, a = %s},\n", name, FloatText(color.r()).data(), FloatText(color.g()).data(),
+	                         FloatText(color.b()).data(), FloatText(color.a()).data());
 }
 
 void serializeGlobal(LuaSerializer &ls, const char *name, bool boolean)
@@ -116,7 +449,7 @@ void serializeGlobal(LuaSerializer &ls, const char *name, unsigned int number)
 
 void serializeGlobal(LuaSerializer &ls, const char *name, float number)
 {
-	ls.buffer().formatAppend("%s = %f\n", name, number);
+	ls.buffer().formatAppend("%s = %s\n", name, FloatText(number).data());
 }
 
 void serializeGlobal(LuaSerializer &ls, const char *name, const nctl::String &string)
@@ -391,10 +724,21 @@ LuaSerializer::LuaSerializer(unsigned int bufferSize)
     : luaState_(nc::LuaStateManager::ApiType::NONE,
                 nc::LuaStateManager::StatisticsTracking::DISABLED,
                 nc::LuaStateManager::StandardLibraries::NOT_LOADED),
-      bufferString_(bufferSize), context_(nullptr)
+      bufferString_(bufferSize), flushThreshold_(bufferSize / 2), tempFilename_(nc::fs::MaxPathLength),
+      streamFailed_(false), indentAmount_(0), context_(nullptr)
 {
 }
 
+LuaSerializer::~LuaSerializer()
+{
+	// A stream that has not been saved never replaces its destination
+	if (streamFile_ != nullptr)
+	{
+		streamFile_->close();
+		nc::fs::deleteFile(tempFilename_.data());
+	}
+}
+
 ///////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
@@ -405,6 +749,26 @@ void LuaSerializer::reset()
 	indentAmount_ = 0;
 }
 
+bool LuaSerializer::openStream(const char *filename)
+{
+#ifdef __EMSCRIPTEN__
+	// Local files are downloaded as a whole
+	return false;
+#else
+	tempFilename_.format("%s.tmp", filename);
+	streamFile_ = nc::IFile::createFileHandle(tempFilename_.data());
+	streamFile_->open(nc::IFile::OpenMode::WRITE | nc::IFile::OpenMode::BINARY);
+	if (streamFile_->isOpened() == false)
+	{
+		streamFile_.reset(nullptr);
+		return false;
+	}
+	streamFailed_ = false;
+
+	return true;
+#endif
+}
+
 bool LuaSerializer::load(const char *filename)
 #ifdef __EMSCRIPTEN__
 {
@@ -429,8 +793,21 @@ bool LuaSerializer::load(const char *filename, const nc::EmscriptenLocalFile *lo
 	return true;
 }
 
-void LuaSerializer::save(const char *filename)
+bool LuaSerializer::save(const char *filename)
 {
+	if (streamFile_ != nullptr)
+	{
+		flushStream();
+		streamFile_->close();
+		streamFile_.reset(nullptr);
+
+		if (streamFailed_ == false && fileUtils::replaceFile(tempFilename_.data(), filename))
+			return true;
+		nc::fs::deleteFile(tempFilename_.data());
+		return false;
+	}
+
+	bool hasSaved = true;
 #ifdef __EMSCRIPTEN__
 	// Don't save the configuration file locally
 	if (strncmp(filename, "config.lua", 10) == 0)
@@ -439,7 +816,9 @@ void LuaSerializer::save(const char *filename)
 
 		nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(filename);
 		fileHandle->open(nc::IFile::OpenMode::WRITE | nc::IFile::OpenMode::BINARY);
-		fileHandle->write(bufferString_.data(), bufferString_.length());
+		if (fileHandle->isOpened() == false)
+			return false;
+		hasSaved = (fileHandle->write(bufferString_.data(), bufferString_.length()) == bufferString_.length());
 		fileHandle->close();
 
 #ifdef __EMSCRIPTEN__
@@ -451,11 +830,17 @@ void LuaSerializer::save(const char *filename)
 		localFileSave.save(filename);
 	}
 #endif
+
+	return hasSaved;
 }
 
 nctl::String &LuaSerializer::buffer()
 {
 	FATAL_ASSERT(indentAmount_ >= 0);
+	// A single line is always shorter than the margin left by the threshold, the string is never reallocated
+	if (streamFile_ != nullptr && bufferString_.length() >= flushThreshold_)
+		flushStream();
+
 	for (int i = 0; i < indentAmount_; i++)
 		bufferString_.append("\t");
 
@@ -466,3 +851,14 @@ lua_State *LuaSerializer::luaState()
 {
 	return luaState_.state();
 }
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void LuaSerializer::flushStream()
+{
+	if (streamFile_->write(bufferString_.data(), bufferString_.length()) != bufferString_.length())
+		streamFailed_ = true;
+	bufferString_.clear();
+}
@@ -1,9 +1,20 @@
 #include "ParallelAnimationGroup.h"
+#include "ObjectPool.h"
 
 ///////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
 
+void *ParallelAnimationGroup::operator new(size_t size)
+{
+	return ObjectPool<ParallelAnimationGroup>::allocate(size);
+}
+
+void ParallelAnimationGroup::operator delete(void *ptr, size_t size)
+{
+	ObjectPool<ParallelAnimationGroup>::deallocate(ptr, size);
+}
+
 nctl::UniquePtr<IAnimation> ParallelAnimationGroup::clone() const
 {
 	nctl::UniquePtr<ParallelAnimationGroup> animGroup = nctl::makeUnique<ParallelAnimationGroup>();
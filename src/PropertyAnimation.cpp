@@ -1,6 +1,10 @@
 #include "PropertyAnimation.h"
+#include "ObjectPool.h"
 #include "Sprite.h"
 #include "AnimationGroup.h"
+#include "AnimationManager.h"
+
+#include "singletons.h"
 
 ///////////////////////////////////////////////////////////
 // CONSTRUCTORS and DESTRUCTOR
@@ -13,14 +17,31 @@ PropertyAnimation::PropertyAnimation()
 
 PropertyAnimation::PropertyAnimation(Sprite *sprite)
     : CurveAnimation(EasingCurve::Type::LINEAR, Loop::Mode::DISABLED),
-      propertyType_(Properties::Types::NONE), property_(nullptr), sprite_(sprite)
+      propertyType_(Properties::Types::NONE), property_(nullptr), sprite_(nullptr)
+{
+	setSprite(sprite);
+}
+
+PropertyAnimation::~PropertyAnimation()
 {
+	if (theAnimMgr.get() != nullptr)
+		theAnimMgr->updateSpriteIndex(this, sprite_, nullptr);
 }
 
 ///////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
 
+void *PropertyAnimation::operator new(size_t size)
+{
+	return ObjectPool<PropertyAnimation>::allocate(size);
+}
+
+void PropertyAnimation::operator delete(void *ptr, size_t size)
+{
+	ObjectPool<PropertyAnimation>::deallocate(ptr, size);
+}
+
 nctl::UniquePtr<IAnimation> PropertyAnimation::clone() const
 {
 	nctl::UniquePtr<PropertyAnimation> anim = nctl::makeUnique<PropertyAnimation>(sprite_);
@@ -34,8 +55,15 @@ nctl::UniquePtr<IAnimation> PropertyAnimation::clone() const
 
 void PropertyAnimation::perform()
 {
-	if (property_)
-		*property_ = curve_.value();
+	if (property_ == nullptr)
+		return;
+
+	const float value = curve_.value();
+	if (*property_ != value)
+	{
+		*property_ = value;
+		sprite_->markDirty();
+	}
 }
 
 const char *PropertyAnimation::propertyName() const
@@ -117,6 +145,8 @@ void PropertyAnimation::setSprite(Sprite *sprite)
 {
 	if (sprite_ != sprite)
 	{
+		if (theAnimMgr.get() != nullptr)
+			theAnimMgr->updateSpriteIndex(this, sprite_, sprite);
 		sprite_ = sprite;
 		setProperty(propertyType_);
 	}
@@ -11,6 +11,7 @@
 
 nctl::UniquePtr<nc::GLShaderProgram> RenderingResources::spriteShaderProgram_;
 nctl::UniquePtr<nc::GLShaderProgram> RenderingResources::meshSpriteShaderProgram_;
+nctl::UniquePtr<nc::GLShaderProgram> RenderingResources::compactMeshSpriteShaderProgram_;
 
 nc::Vector2f RenderingResources::canvasSize_(0.0f, 0.0f);
 nc::Matrix4x4f RenderingResources::projectionMatrix_ = nc::Matrix4x4f::Identity;
@@ -46,6 +47,7 @@ void RenderingResources::create()
 	ShaderLoad shadersToLoad[] = {
 		{ RenderingResources::spriteShaderProgram_, ShaderStrings::sprite_vs, ShaderStrings::sprite_fs, nc::GLShaderProgram::Introspection::ENABLED },
 		{ RenderingResources::meshSpriteShaderProgram_, ShaderStrings::meshsprite_vs, ShaderStrings::sprite_fs, nc::GLShaderProgram::Introspection::ENABLED },
+		{ RenderingResources::compactMeshSpriteShaderProgram_, ShaderStrings::meshsprite_compact_vs, ShaderStrings::sprite_fs, nc::GLShaderProgram::Introspection::ENABLED },
 	};
 
 	const nc::GLShaderProgram::QueryPhase queryPhase = appCfg.deferShaderQueries ? nc::GLShaderProgram::QueryPhase::DEFERRED : nc::GLShaderProgram::QueryPhase::IMMEDIATE;
@@ -66,6 +68,7 @@ void RenderingResources::create()
 
 void RenderingResources::dispose()
 {
+	compactMeshSpriteShaderProgram_.reset(nullptr);
 	meshSpriteShaderProgram_.reset(nullptr);
 	spriteShaderProgram_.reset(nullptr);
 
@@ -1,19 +1,144 @@
+#define NCINE_INCLUDE_LUA
+#include <ncine/common_headers.h>
+#if defined(WITH_LUAJIT)
+	#include <luajit.h>
+#endif
+#include <cstring>
+#include <mutex>
+
 #include <ncine/LuaUtils.h>
+#include <ncine/LuaDebug.h>
+#include <ncine/TimeStamp.h>
 #include <ncine/FileSystem.h>
+#include <ncine/IFile.h>
 #include "singletons.h"
 #include "Script.h"
 #include "ScriptManager.h"
+#include "file_utils.h"
+
+namespace {
+
+#if defined(WITH_LUAJIT)
+const char *BytecodeFormat = LUAJIT_VERSION;
+#else
+const char *BytecodeFormat = LUA_RELEASE;
+#endif
+
+const char *FunctionNames[] = { "init", "update" };
+/// A script that sets this global to true keeps being updated when its sprite is culled
+const char *UpdateWhenCulledName = "update_when_culled";
+
+const char *CacheExtension = "luac";
+/// The cache is cleared on startup when it holds more files than this
+const unsigned int MaxCacheFiles = 256;
+/// Every cached file ends with a checksum of its bytecode, as Lua does not verify bytecode before running it
+const unsigned int ChecksumSize = sizeof(uint64_t);
+/// Serializes the writes of cached files, as worker threads compile chunks too
+std::mutex cacheMutex;
+
+void pushGlobalsTable(lua_State *L)
+{
+#if LUA_VERSION_NUM >= 502
+	lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+#else
+	lua_pushvalue(L, LUA_GLOBALSINDEX);
+#endif
+}
+
+const uint64_t FnvOffsetBasis = 0xcbf29ce484222325ULL;
+
+/// 64-bit FNV-1a hash, used to detect changes in source code, to name cached bytecode and to verify it
+uint64_t fnv1aHash(const char *data, unsigned long int size, uint64_t hash = FnvOffsetBasis)
+{
+	for (unsigned long int i = 0; i < size; i++)
+	{
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+bool readFile(const char *filename, nctl::UniquePtr<char[]> &buffer, unsigned long int &size)
+{
+	nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(filename);
+	fileHandle->open(nc::IFile::OpenMode::READ | nc::IFile::OpenMode::BINARY);
+	if (fileHandle->isOpened() == false)
+		return false;
+
+	size = static_cast<unsigned long int>(fileHandle->size());
+	buffer = nctl::makeUnique<char[]>(size > 0 ? size : 1);
+	const unsigned long int bytesRead = fileHandle->read(buffer.get(), size);
+	fileHandle->close();
+
+	return (bytesRead == size);
+}
+
+struct BytecodeWriter
+{
+	nc::IFile *fileHandle;
+	uint64_t checksum;
+};
+
+int bytecodeWriter(lua_State *, const void *data, size_t size, void *userData)
+{
+	BytecodeWriter *writer = static_cast<BytecodeWriter *>(userData);
+	writer->checksum = fnv1aHash(static_cast<const char *>(data), static_cast<unsigned long int>(size), writer->checksum);
+	return (writer->fileHandle->write(data, static_cast<unsigned long int>(size)) == size) ? 0 : 1;
+}
+
+/// Dumps the function on top of the stack to a temporary file that is then renamed, a reader never sees a partial file
+void writeBytecode(lua_State *L, const char *cacheDirectory, const char *filename)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	if (nc::fs::isDirectory(cacheDirectory) == false)
+		nc::fs::createDir(cacheDirectory);
+
+	nctl::String tempFilename(nc::fs::MaxPathLength);
+	tempFilename.format("%s.tmp", filename);
+	nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(tempFilename.data());
+	fileHandle->open(nc::IFile::OpenMode::WRITE | nc::IFile::OpenMode::BINARY);
+	if (fileHandle->isOpened() == false)
+		return;
+
+	BytecodeWriter writer = { fileHandle.get(), FnvOffsetBasis };
+#if LUA_VERSION_NUM >= 503
+	bool hasWritten = (lua_dump(L, bytecodeWriter, &writer, 0) == 0);
+#else
+	bool hasWritten = (lua_dump(L, bytecodeWriter, &writer) == 0);
+#endif
+	hasWritten = hasWritten && (fileHandle->write(&writer.checksum, ChecksumSize) == ChecksumSize);
+	fileHandle->close();
+
+	if (hasWritten == false || fileUtils::replaceFile(tempFilename.data(), filename) == false)
+		nc::fs::deleteFile(tempFilename.data());
+}
+
+}
+
+///////////////////////////////////////////////////////////
+// STATIC DEFINITIONS
+///////////////////////////////////////////////////////////
+
+nctl::String Script::cacheDirectory_(nc::fs::MaxPathLength);
+unsigned long int Script::maxInstructions_ = 0;
+float Script::maxMilliseconds_ = 0.0f;
 
 ///////////////////////////////////////////////////////////
 // CONSTRUCTORS and DESTRUCTOR
 ///////////////////////////////////////////////////////////
 
+Script::Context::Context()
+    : luaState(nullptr), sourceHash(0), envRef(LUA_NOREF)
+{
+	functionRefs[0] = LUA_NOREF;
+	functionRefs[1] = LUA_NOREF;
+}
+
 Script::Script()
-    : canRun_(false), name_(256), errorMessage_(256),
-      luaState_(nc::LuaStateManager::ApiType::NONE,
-                nc::LuaStateManager::StatisticsTracking::DISABLED,
-                nc::LuaStateManager::StandardLibraries::LOADED)
+    : canRun_(false), name_(256), path_(256), errorMessage_(256),
+      sourceHash_(0), cacheFilename_(nc::fs::MaxPathLength), sourceSize_(0), chunkName_(256), workerIndex_(-1), updateWhenCulled_(false), disabledNotice_(false)
 {
+	context_.luaState = theScriptingMgr->luaState();
 }
 
 Script::Script(const char *filename)
@@ -22,17 +147,26 @@ Script::Script(const char *filename)
 	load(filename);
 }
 
+Script::~Script()
+{
+	releaseContext(context_);
+	releaseContext(workerContext_);
+}
+
 ///////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
 
 bool Script::load(const char *filename)
 {
-	const bool hasLoaded = nc::fs::isReadableFile(filename);
+	nctl::UniquePtr<char[]> source;
+	unsigned long int size = 0;
+	const bool hasLoaded = nc::fs::isReadableFile(filename) && readFile(filename, source, size);
 	if (hasLoaded)
 	{
 		name_ = filename;
-		run(filename, nc::fs::baseName(filename).data());
+		path_ = filename;
+		run(source.get(), size, nc::fs::baseName(filename).data());
 	}
 
 	return hasLoaded;
@@ -40,30 +174,362 @@ bool Script::load(const char *filename)
 
 bool Script::reload()
 {
-	nctl::String filename = name_;
+	nctl::String filename = path_.isEmpty() ? name_ : path_;
 	// Resolve relative path made to allow for relocatable project files
-	if (nc::fs::isReadableFile(nc::fs::joinPath(theCfg.scriptsPath, name_.data()).data()))
+	if (path_.isEmpty() && nc::fs::isReadableFile(nc::fs::joinPath(theCfg.scriptsPath, name_.data()).data()))
 		filename = nc::fs::joinPath(theCfg.scriptsPath, name_.data());
 
-	const bool hasLoaded = nc::fs::isReadableFile(filename.data());
+	nctl::UniquePtr<char[]> source;
+	unsigned long int size = 0;
+	const bool hasLoaded = nc::fs::isReadableFile(filename.data()) && readFile(filename.data(), source, size);
 	if (hasLoaded)
 	{
-		luaState_.reopen();
-		run(filename.data(), name_.data());
+		// Nothing to do if the source code has not changed since the last successful run
+		if (canRun_ && fnv1aHash(source.get(), size) == sourceHash_)
+			return true;
+
+		run(source.get(), size, name_.data());
 	}
 
 	return hasLoaded;
 }
 
+float Script::Statistics::lastUpdateTime() const
+{
+	const unsigned int lastIndex = (historyIndex + HistoryLength - 1) % HistoryLength;
+	return updateTimes[lastIndex];
+}
+
+float Script::Statistics::averageUpdateTime() const
+{
+	float sum = 0.0f;
+	for (unsigned int i = 0; i < HistoryLength; i++)
+		sum += updateTimes[i];
+	return sum / HistoryLength;
+}
+
+void Script::resetStatistics()
+{
+	statistics_ = Statistics();
+	frameCounters_ = FrameCounters();
+}
+
+void Script::updateStatistics()
+{
+	statistics_.updateTimes[statistics_.historyIndex] = frameCounters_.updateTime;
+	statistics_.historyIndex = (statistics_.historyIndex + 1) % Statistics::HistoryLength;
+	if (frameCounters_.updateTime > statistics_.worstUpdateTime)
+		statistics_.worstUpdateTime = frameCounters_.updateTime;
+
+	statistics_.numUpdateCalls = frameCounters_.numUpdateCalls;
+	statistics_.numVertexGetterCalls = frameCounters_.numVertexGetterCalls;
+	statistics_.numVertexSetterCalls = frameCounters_.numVertexSetterCalls;
+
+	frameCounters_ = FrameCounters();
+}
+
+void Script::recordCall(Function function, float milliseconds)
+{
+	if (function == Function::INIT)
+		statistics_.initTime = milliseconds;
+	else
+	{
+		frameCounters_.updateTime += milliseconds;
+		frameCounters_.numUpdateCalls++;
+	}
+}
+
+bool Script::consumeDisabledNotice()
+{
+	const bool disabledNotice = disabledNotice_;
+	disabledNotice_ = false;
+	return disabledNotice;
+}
+
+bool Script::chargeBudget(unsigned int cost)
+{
+	if (budget_.isActive == false)
+		return true;
+
+	if (maxInstructions_ > 0)
+	{
+		budget_.instructionsLeft -= cost;
+		if (budget_.instructionsLeft < 0)
+			budget_.isExceeded = true;
+	}
+	if (maxMilliseconds_ > 0.0f && budget_.startTime.secondsSince() * 1000.0f > maxMilliseconds_)
+		budget_.isExceeded = true;
+
+	return (budget_.isExceeded == false);
+}
+
+void Script::setCacheDirectory(const char *directory)
+{
+	cacheDirectory_ = directory;
+	if (cacheDirectory_.isEmpty() || nc::fs::isDirectory(directory) == false)
+		return;
+
+	// Files left by an interrupted write are removed, the compiled chunks only when there are too many of them
+	nctl::Array<nctl::String> cacheFiles;
+	nc::fs::Directory dir(directory);
+	while (const char *entryName = dir.readNext())
+	{
+		const nctl::String filePath = nc::fs::joinPath(cacheDirectory_, entryName);
+		if (nc::fs::hasExtension(entryName, "tmp"))
+			nc::fs::deleteFile(filePath.data());
+		else if (nc::fs::hasExtension(entryName, CacheExtension))
+			cacheFiles.pushBack(filePath);
+	}
+
+	if (cacheFiles.size() > MaxCacheFiles)
+	{
+		for (unsigned int i = 0; i < cacheFiles.size(); i++)
+			nc::fs::deleteFile(cacheFiles[i].data());
+	}
+}
+
+void Script::setBudget(unsigned long int maxInstructions, float maxMilliseconds)
+{
+	maxInstructions_ = maxInstructions;
+	maxMilliseconds_ = maxMilliseconds;
+#if defined(WITH_LUAJIT)
+	if (theScriptingMgr.get() != nullptr)
+		theScriptingMgr->updateJitMode();
+#endif
+}
+
 ///////////////////////////////////////////////////////////
 // PRIVATE FUNCTIONS
 ///////////////////////////////////////////////////////////
 
-bool Script::run(const char *filename, const char *chunkName)
+bool Script::run(const char *source, unsigned long int size, const char *chunkName)
 {
-	ScriptManager::exposeConstants(luaState_.state());
-	ScriptManager::exposeFunctions(luaState_.state());
-	canRun_ = luaState_.runFromFile(filename, chunkName, &errorMessage_);
+	sourceHash_ = fnv1aHash(source, size);
+
+	if (cacheDirectory_.isEmpty() == false)
+	{
+		// Bytecode is specific to the interpreter version and to the chunk name used in error messages
+		uint64_t hash = fnv1aHash(BytecodeFormat, strlen(BytecodeFormat));
+		hash = fnv1aHash(chunkName, strlen(chunkName), hash);
+		hash = fnv1aHash(source, size, hash);
+
+		nctl::String hashString(32);
+		hashString.format("%016llx.%s", static_cast<unsigned long long>(hash), CacheExtension);
+		// Stale files are not deleted here, another script might share them, they are pruned by `setCacheDirectory()`
+		cacheFilename_ = nc::fs::joinPath(cacheDirectory_, hashString);
+	}
+	else
+		cacheFilename_.clear();
+
+	source_ = nctl::makeUnique<char[]>(size > 0 ? size : 1);
+	memcpy(source_.get(), source, size);
+	sourceSize_ = size;
+	chunkName_ = chunkName;
+
+	const unsigned long int heapSizeBefore = ScriptManager::heapSize(context_.luaState);
+	canRun_ = runInContext(context_, errorMessage_);
+	if (canRun_)
+		errorMessage_.clear();
+	const unsigned long int heapSizeAfter = ScriptManager::heapSize(context_.luaState);
+	statistics_.loadMemory = (heapSizeAfter > heapSizeBefore) ? heapSizeAfter - heapSizeBefore : 0;
 
 	return canRun_;
 }
+
+bool Script::runInContext(Context &context, nctl::String &errorMessage)
+{
+	lua_State *L = context.luaState;
+	// The environment of a previous run is discarded together with its functions
+	releaseContext(context);
+	context.sourceHash = sourceHash_;
+
+	// Every script has its own environment table that falls back to the shared globals
+	nc::LuaUtils::createTable(L, 0, 2);
+	nc::LuaUtils::createTable(L, 0, 1);
+	pushGlobalsTable(L);
+	lua_setfield(L, -2, "__index");
+	lua_setmetatable(L, -2);
+	const int envIndex = lua_gettop(L);
+
+	bool hasRun = loadChunk(L, source_.get(), sourceSize_, chunkName_.data(), errorMessage);
+	if (hasRun)
+	{
+		lua_pushvalue(L, envIndex);
+#if LUA_VERSION_NUM >= 502
+		// The first upvalue of a main chunk is always `_ENV`
+		if (lua_setupvalue(L, -2, 1) == nullptr)
+			nc::LuaUtils::pop(L);
+#else
+		lua_setfenv(L, -2);
+#endif
+		// The chunk can run while another script is being called, its key is restored afterwards
+		Script *prevScript = ScriptManager::pushScript(L, this);
+		const bool isNested = budget_.isActive;
+		if (isNested == false)
+			beginBudget();
+		const int status = nc::LuaUtils::pcall(L, 0, 0);
+		if (isNested == false)
+			budget_.isActive = false;
+		ScriptManager::pushScript(L, prevScript);
+		hasRun = nc::LuaUtils::isStatusOk(status);
+		if (hasRun == false)
+		{
+			errorMessage = nc::LuaUtils::retrieve<const char *>(L, -1);
+			nc::LuaUtils::pop(L);
+		}
+	}
+
+	if (hasRun)
+	{
+		for (unsigned int i = 0; i < sizeof(FunctionNames) / sizeof(*FunctionNames); i++)
+		{
+			// Raw access, a function with the same name defined globally should not be picked
+			lua_pushstring(L, FunctionNames[i]);
+			lua_rawget(L, envIndex);
+			if (lua_isfunction(L, -1))
+				context.functionRefs[i] = luaL_ref(L, LUA_REGISTRYINDEX);
+			else
+				nc::LuaUtils::pop(L);
+		}
+
+		// Worker contexts run the same source code, the flag is only read on the main thread
+		if (&context == &context_)
+		{
+			lua_pushstring(L, UpdateWhenCulledName);
+			lua_rawget(L, envIndex);
+			updateWhenCulled_ = lua_toboolean(L, -1);
+			nc::LuaUtils::pop(L);
+		}
+	}
+
+	context.envRef = luaL_ref(L, LUA_REGISTRYINDEX);
+	return hasRun;
+}
+
+void Script::releaseContext(Context &context)
+{
+	if (context.luaState == nullptr)
+		return;
+
+	for (unsigned int i = 0; i < sizeof(context.functionRefs) / sizeof(*context.functionRefs); i++)
+	{
+		luaL_unref(context.luaState, LUA_REGISTRYINDEX, context.functionRefs[i]);
+		context.functionRefs[i] = LUA_NOREF;
+	}
+	luaL_unref(context.luaState, LUA_REGISTRYINDEX, context.envRef);
+	context.envRef = LUA_NOREF;
+	context.sourceHash = 0;
+}
+
+bool Script::loadChunk(lua_State *L, const char *source, unsigned long int size, const char *chunkName, nctl::String &errorMessage)
+{
+	if (cacheFilename_.isEmpty() == false)
+	{
+		nctl::UniquePtr<char[]> bytecode;
+		unsigned long int fileSize = 0;
+		if (nc::fs::isReadableFile(cacheFilename_.data()) && readFile(cacheFilename_.data(), bytecode, fileSize) && fileSize > ChecksumSize)
+		{
+			const unsigned long int bytecodeSize = fileSize - ChecksumSize;
+			uint64_t checksum = 0;
+			memcpy(&checksum, bytecode.get() + bytecodeSize, ChecksumSize);
+
+			// A damaged file never reaches the interpreter, it is compiled again and replaced
+			if (checksum == fnv1aHash(bytecode.get(), bytecodeSize))
+			{
+				if (nc::LuaUtils::isStatusOk(luaL_loadbuffer(L, bytecode.get(), bytecodeSize, chunkName)))
+					return true;
+				nc::LuaUtils::pop(L);
+			}
+		}
+	}
+
+	if (nc::LuaUtils::isStatusOk(luaL_loadbuffer(L, source, size, chunkName)) == false)
+	{
+		errorMessage = nc::LuaUtils::retrieve<const char *>(L, -1);
+		nc::LuaUtils::pop(L);
+		return false;
+	}
+
+	if (cacheFilename_.isEmpty() == false)
+		writeBytecode(L, cacheDirectory_.data(), cacheFilename_.data());
+
+	return true;
+}
+
+bool Script::callFunction(Context &context, Function function, Sprite *sprite, float value, nctl::String &errorMessage)
+{
+	const int functionRef = context.functionRefs[static_cast<int>(function)];
+	// A script disabled for exceeding its budget is not called until it is reloaded
+	if (functionRef == LUA_NOREF || canRun_ == false)
+		return true;
+
+	lua_State *L = context.luaState;
+	lua_rawgeti(L, LUA_REGISTRYINDEX, functionRef);
+	// A function can call other scripts, like the `init` functions run again by `set_texrect()`
+	Sprite *prevSprite = ScriptManager::pushSprite(L, sprite);
+	Script *prevScript = ScriptManager::pushScript(L, this);
+	nc::LuaUtils::push(L, value);
+	// A nested call of the same script is charged to the budget of the outer one
+	const bool isNested = budget_.isActive;
+	const nc::TimeStamp startTime = nc::TimeStamp::now();
+	if (isNested == false)
+		beginBudget();
+	const int status = nc::LuaUtils::pcall(L, 1, 0);
+	ScriptManager::pushSprite(L, prevSprite);
+	ScriptManager::pushScript(L, prevScript);
+	recordCall(function, startTime.secondsSince() * 1000.0f);
+	if (nc::LuaUtils::isStatusOk(status) == false)
+	{
+		errorMessage.format("Error running \"%s\" function for script \"%s\" (%s):\n%s", FunctionNames[static_cast<int>(function)], name_.data(),
+		                    nc::LuaDebug::statusToString(status), nc::LuaUtils::retrieve<const char *>(L, -1));
+		nc::LuaUtils::pop(L);
+	}
+	if (isNested == false)
+		endBudget(errorMessage);
+
+	if (nc::LuaUtils::isStatusOk(status) == false)
+		return false;
+
+	return true;
+}
+
+bool Script::callFunctionInWorker(lua_State *workerState, Function function, Sprite *sprite, float value, nctl::String &errorMessage)
+{
+	if (workerContext_.luaState != workerState)
+	{
+		workerContext_ = Context();
+		workerContext_.luaState = workerState;
+	}
+
+	// The chunk is run again in the worker state every time the script is reloaded
+	if (workerContext_.sourceHash != sourceHash_ && runInContext(workerContext_, errorMessage) == false)
+		return false;
+
+	return callFunction(workerContext_, function, sprite, value, errorMessage);
+}
+
+void Script::beginBudget()
+{
+	budget_.instructionsLeft = static_cast<long long int>(maxInstructions_);
+	budget_.startTime = nc::TimeStamp::now();
+	budget_.isActive = true;
+	budget_.isExceeded = false;
+}
+
+void Script::endBudget(const nctl::String &errorMessage)
+{
+	budget_.isActive = false;
+	if (budget_.isExceeded)
+	{
+		canRun_ = false;
+		errorMessage_ = errorMessage;
+		disabledNotice_ = true;
+	}
+}
+
+void Script::resetWorkerContext()
+{
+	// The references die with the worker state, there is nothing to release
+	workerContext_ = Context();
+	workerIndex_ = -1;
+}
@@ -1,10 +1,14 @@
-#include <ncine/LuaUtils.h>
-#include <ncine/LuaDebug.h>
+#include <ncine/common_macros.h>
 #include "ScriptAnimation.h"
+#include "ObjectPool.h"
 #include "Script.h"
 #include "ScriptManager.h"
+#include "ScriptWorkers.h"
+#include "FrameProfiler.h"
 #include "Sprite.h"
 #include "AnimationGroup.h"
+#include "AnimationManager.h"
+#include "singletons.h"
 
 ///////////////////////////////////////////////////////////
 // CONSTRUCTORS and DESTRUCTOR
@@ -26,10 +30,29 @@ ScriptAnimation::ScriptAnimation(Sprite *sprite, Script *script)
 	isLocked_ = false;
 }
 
+ScriptAnimation::~ScriptAnimation()
+{
+	if (theAnimMgr.get() != nullptr)
+	{
+		theAnimMgr->updateSpriteIndex(this, sprite_, nullptr);
+		theAnimMgr->updateScriptIndex(this, script_, nullptr);
+	}
+}
+
 ///////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
 
+void *ScriptAnimation::operator new(size_t size)
+{
+	return ObjectPool<ScriptAnimation>::allocate(size);
+}
+
+void ScriptAnimation::operator delete(void *ptr, size_t size)
+{
+	ObjectPool<ScriptAnimation>::deallocate(ptr, size);
+}
+
 nctl::UniquePtr<IAnimation> ScriptAnimation::clone() const
 {
 	nctl::UniquePtr<ScriptAnimation> anim = nctl::makeUnique<ScriptAnimation>(sprite_, script_);
@@ -45,13 +68,17 @@ void ScriptAnimation::play()
 {
 	CurveAnimation::play();
 	if (sprite_)
-		runScript("init", curve_.value());
+		runScript(Script::Function::INIT, curve_.value());
 }
 
 void ScriptAnimation::perform()
 {
-	if (sprite_ && sprite_->visible)
-		runScript("update", curve_.value());
+	if (sprite_ == nullptr || sprite_->visible == false)
+		return;
+
+	// Vertices of a culled sprite are not drawn, unless the script has other side effects its update can be skipped
+	if (sprite_->isGridCulled() == false || (script_ && script_->updateWhenCulled()))
+		runScript(Script::Function::UPDATE, curve_.value());
 }
 
 void ScriptAnimation::setSprite(Sprite *sprite)
@@ -63,12 +90,16 @@ void ScriptAnimation::setSprite(Sprite *sprite)
 		if (sprite)
 			sprite->incrementGridAnimCounter();
 
+		if (theAnimMgr.get() != nullptr)
+			theAnimMgr->updateSpriteIndex(this, sprite_, sprite);
 		sprite_ = sprite;
 	}
 }
 
 void ScriptAnimation::setScript(Script *script)
 {
+	if (script_ != script && theAnimMgr.get() != nullptr)
+		theAnimMgr->updateScriptIndex(this, script_, script);
 	script_ = script;
 }
 
@@ -76,28 +107,25 @@ void ScriptAnimation::setScript(Script *script)
 // PRIVATE FUNCTIONS
 ///////////////////////////////////////////////////////////
 
-bool ScriptAnimation::runScript(const char *functionName, float value)
+bool ScriptAnimation::runScript(Script::Function function, float value)
 {
 	if (sprite_ == nullptr || script_ == nullptr)
 		return false;
 
-	lua_State *L = script_->luaState_.state();
-	const int type = nc::LuaUtils::getGlobal(L, functionName);
-
-	if (nc::LuaUtils::isFunction(type))
+	ScriptWorkers *workers = theScriptingMgr->workers();
+	if (workers != nullptr)
 	{
-		ScriptManager::pushSprite(L, sprite_);
-		nc::LuaUtils::push(L, value);
-		const int status = nc::LuaUtils::pcall(L, 1, 0);
-		if (nc::LuaUtils::isStatusOk(status) == false)
-		{
-			LOGE_X("Error running \"%s\" function for script \"%s\" (%s):\n%s", functionName, script_->name().data(),
-			       nc::LuaDebug::statusToString(status), nc::LuaUtils::retrieve<const char *>(L, -1));
-			nc::LuaUtils::pop(L);
-		}
+		workers->submit({ script_, sprite_, function, value });
+		// A call can be deferred to the end of the batch only if no other grid animation writes the same vertices
+		if (theScriptingMgr->isBatching() == false || sprite_->gridAnimationsCounter() != 1)
+			workers->flush();
+		return true;
 	}
-	else
-		nc::LuaUtils::pop(L);
+
+	ProfileScope profileScope(script_->name().data());
+	nctl::String errorMessage(256);
+	if (script_->callFunction(script_->context_, function, sprite_, value, errorMessage) == false)
+		LOGE_X("%s", errorMessage.data());
 
 	return true;
 }
@@ -1,3 +1,9 @@
+#define NCINE_INCLUDE_LUA
+#include <ncine/common_headers.h>
+#if defined(WITH_LUAJIT)
+	#include <cstring>
+	#include <luajit.h>
+#endif
 #include <ncine/LuaUtils.h>
 #include <ncine/LuaVector2Utils.h>
 #include <ncine/LuaColorUtils.h>
@@ -5,13 +11,34 @@
 #include "singletons.h"
 #include "ScriptManager.h"
 #include "Script.h"
+#include "ScriptWorkers.h"
+#include "FrameProfiler.h"
 #include "SpriteManager.h"
 #include "Sprite.h"
 #include "Texture.h"
 #include "Canvas.h"
+#include "GridFunctionLibrary.h"
+#include "AnimationManager.h"
 
 namespace {
 const char *spriteKey = "k";
+const char *scriptKey = "s";
+const char *vertexViewKey = "v";
+const char *vertexViewMetatable = "VertexView";
+
+#if defined(WITH_LUAJIT)
+/// Declares the vertex layout for the FFI and wraps the raw pointer in a typed one, returned together with the number of vertices
+/*! The pointer is only valid until the grid is resized, for example by `set_texrect()`, and it should not be kept between calls */
+const char *ffiHelpers = R"lua(
+local ffi = require("ffi")
+ffi.cdef[[typedef struct { float x, y, u, v; } sg_vertex;]]
+local get_vertices_pointer = get_vertices_pointer
+function get_vertices_ffi()
+	local pointer, count = get_vertices_pointer()
+	return ffi.cast("sg_vertex *", pointer), count
+end
+)lua";
+#endif
 
 static const char *vertexX = "x";
 static const char *vertexY = "y";
@@ -34,6 +61,7 @@ void verticesHelper(lua_State *L, Sprite *sprite, Components components)
 	if (sprite)
 	{
 		const nctl::Array<Sprite::Vertex> &vertices = sprite->interleavedVertices();
+		ScriptManager::chargeBudget(L, vertices.size() * Script::VertexCost);
 		nc::LuaUtils::createTable(L, vertices.size(), 0);
 		for (unsigned int i = 0; i < vertices.size(); i++)
 		{
@@ -87,6 +115,7 @@ void setVerticesHelper(lua_State *L, Sprite *sprite, Components components)
 	if (sprite)
 	{
 		nctl::Array<Sprite::Vertex> &vertices = sprite->interleavedVertices();
+		ScriptManager::chargeBudget(L, vertices.size() * Script::VertexCost);
 		if (nc::LuaUtils::isTable(L, -1) && nc::LuaUtils::rawLen(L, -1) == vertices.size())
 		{
 			for (unsigned int i = 0; i < vertices.size(); i++)
@@ -141,6 +170,29 @@ void setVerticesHelper(lua_State *L, Sprite *sprite, Components components)
 	}
 }
 
+Sprite::Vertex &checkVertex(lua_State *L, Sprite *sprite)
+{
+	luaL_checkudata(L, 1, vertexViewMetatable);
+	if (sprite == nullptr)
+		luaL_error(L, "No sprite is bound to the vertex view");
+
+	nctl::Array<Sprite::Vertex> &vertices = sprite->interleavedVertices();
+	const lua_Integer index = luaL_checkinteger(L, 2);
+	// Lua arrays start from index 1
+	luaL_argcheck(L, index >= 1 && index <= static_cast<lua_Integer>(vertices.size()), 2, "vertex index out of range");
+
+	return vertices[static_cast<unsigned int>(index - 1)];
+}
+
+Sprite &checkGridSprite(lua_State *L, Sprite *sprite)
+{
+	if (sprite == nullptr)
+		luaL_error(L, "No sprite is bound to the grid module");
+	// Every grid function visits all the vertices, it is charged like the vertex accessors
+	ScriptManager::chargeBudget(L, sprite->interleavedVertices().size() * Script::VertexCost);
+	return *sprite;
+}
+
 }
 
 namespace LuaNames {
@@ -183,6 +235,8 @@ static const char *verticesX = "get_vertices_x";
 static const char *verticesY = "get_vertices_y";
 static const char *verticesU = "get_vertices_u";
 static const char *verticesV = "get_vertices_v";
+static const char *vertexView = "get_vertex_view";
+static const char *verticesPointer = "get_vertices_pointer";
 
 static const char *setPosition = "set_position";
 static const char *setPositionX = "set_x";
@@ -208,17 +262,139 @@ static const char *setVerticesY = "set_vertices_y";
 static const char *setVerticesU = "set_vertices_u";
 static const char *setVerticesV = "set_vertices_v";
 
+static const char *vertexViewSize = "size";
+static const char *vertexViewGet = "get";
+static const char *vertexViewGetXY = "get_xy";
+static const char *vertexViewGetUV = "get_uv";
+static const char *vertexViewSet = "set";
+static const char *vertexViewSetXY = "set_xy";
+static const char *vertexViewSetUV = "set_uv";
+
+static const char *Grid = "grid";
+static const char *gridAddWaveX = "add_wave_x";
+static const char *gridAddWaveY = "add_wave_y";
+static const char *gridAddSkewX = "add_skew_x";
+static const char *gridAddSkewY = "add_skew_y";
+static const char *gridAddZoom = "add_zoom";
+static const char *gridDisplaceByNoise = "displace_by_noise";
+static const char *gridApplyAffine = "apply_affine";
+static const char *gridLerpToRest = "lerp_to_rest";
+
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+ScriptManager::ScriptManager()
+    : luaState_(nc::LuaStateManager::ApiType::NONE,
+                nc::LuaStateManager::StatisticsTracking::ENABLED,
+                nc::LuaStateManager::StandardLibraries::LOADED),
+      isBatching_(false)
+{
+	// The API is registered only once, scripts reach it through the metatable of their environment
+	lua_State *L = luaState_.state();
+	exposeConstants(L);
+	exposeFunctions(L);
+	installBudgetHook(L);
+}
+
+ScriptManager::~ScriptManager()
+{
+	// Scripts release their references while the worker states are still alive
+	scripts_.clear();
 }
 
 ///////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
 
+unsigned long int ScriptManager::heapSize(lua_State *L)
+{
+	return static_cast<unsigned long int>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+}
+
 void ScriptManager::clear()
 {
 	scripts_.clear();
 }
 
+void ScriptManager::updateStatistics()
+{
+	for (unsigned int i = 0; i < scripts_.size(); i++)
+		scripts_[i]->updateStatistics();
+}
+
+void ScriptManager::setParallelExecution(bool enabled, unsigned int numWorkers)
+{
+#if defined(__EMSCRIPTEN__)
+	// Threads are not available
+	enabled = false;
+#endif
+
+	if (enabled && numWorkers == 0)
+	{
+		const unsigned int numCores = std::thread::hardware_concurrency();
+		numWorkers = (numCores > 1) ? numCores - 1 : 1;
+	}
+
+	const unsigned int currentNumWorkers = workers_ ? workers_->numWorkers() : 0;
+	if ((enabled ? numWorkers : 0) == currentNumWorkers)
+		return;
+
+	const bool wasParallel = (workers_ != nullptr);
+	if (workers_)
+	{
+		workers_->flush();
+		for (unsigned int i = 0; i < scripts_.size(); i++)
+			scripts_[i]->resetWorkerContext();
+		workers_.reset(nullptr);
+	}
+
+	if (enabled)
+		workers_ = nctl::makeUnique<ScriptWorkers>(numWorkers);
+
+	// Scripts continue in a different Lua state, where the chunk and the `init` functions have to run again
+	for (unsigned int i = 0; i < scripts_.size(); i++)
+	{
+		Script &script = *scripts_[i];
+		// The shared state still holds what the chunk defined before parallel execution was enabled
+		if (wasParallel && workers_ == nullptr && script.canRun_)
+			script.canRun_ = script.runInContext(script.context_, script.errorMessage_);
+		if (theAnimMgr.get() != nullptr)
+			theAnimMgr->reloadScript(&script);
+	}
+}
+
+#if defined(WITH_LUAJIT)
+void ScriptManager::updateJitMode()
+{
+	setJitMode(luaState_.state());
+	if (workers_)
+	{
+		// The workers are idle after a flush, their states can be modified from this thread
+		workers_->flush();
+		for (unsigned int i = 0; i < workers_->numWorkers(); i++)
+			setJitMode(workers_->luaState(i));
+	}
+}
+#endif
+
+void ScriptManager::beginBatch()
+{
+	isBatching_ = true;
+}
+
+void ScriptManager::endBatch()
+{
+	isBatching_ = false;
+	if (workers_)
+	{
+		ProfileScope profileScope("Script Workers");
+		workers_->flush();
+	}
+}
+
 int ScriptManager::scriptIndex(const Script *script) const
 {
 	if (script == nullptr)
@@ -254,11 +430,84 @@ Sprite *ScriptManager::retrieveSprite(lua_State *L)
 	return sprite;
 }
 
-void ScriptManager::pushSprite(lua_State *L, Sprite *sprite)
+Sprite *ScriptManager::pushSprite(lua_State *L, Sprite *sprite)
 {
+	Sprite *prevSprite = retrieveSprite(L);
 	nc::LuaUtils::push(L, reinterpret_cast<void *>(&spriteKey));
 	nc::LuaUtils::push(L, sprite);
 	nc::LuaUtils::setTable(L, nc::LuaUtils::registryIndex());
+	return prevSprite;
+}
+
+Script *ScriptManager::retrieveScript(lua_State *L)
+{
+	Script *script = nullptr;
+
+	nc::LuaUtils::push(L, reinterpret_cast<void *>(&scriptKey));
+	const int type = nc::LuaUtils::getTable(L, nc::LuaUtils::registryIndex());
+	if (nc::LuaUtils::isLightUserData(type))
+		script = reinterpret_cast<Script *>(nc::LuaUtils::retrieveUserData(L, -1));
+	nc::LuaUtils::pop(L, 1);
+
+	return script;
+}
+
+Script *ScriptManager::pushScript(lua_State *L, Script *script)
+{
+	Script *prevScript = retrieveScript(L);
+	nc::LuaUtils::push(L, reinterpret_cast<void *>(&scriptKey));
+	nc::LuaUtils::push(L, script);
+	nc::LuaUtils::setTable(L, nc::LuaUtils::registryIndex());
+	return prevScript;
+}
+
+void ScriptManager::chargeBudget(lua_State *L, unsigned int cost)
+{
+	Script *script = retrieveScript(L);
+	if (script && script->chargeBudget(cost) == false)
+		raiseBudgetError(L);
+}
+
+void ScriptManager::installBudgetHook(lua_State *L)
+{
+	lua_sethook(L, budgetHook, LUA_MASKCOUNT, BudgetHookInterval);
+#if defined(WITH_LUAJIT)
+	setJitMode(L);
+#endif
+}
+
+void ScriptManager::budgetHook(lua_State *L, lua_Debug *)
+{
+	chargeBudget(L, BudgetHookInterval);
+}
+
+void ScriptManager::raiseBudgetError(lua_State *L)
+{
+	luaL_error(L, "Script disabled for exceeding its budget of %lu instructions or %.0f ms per call",
+	           Script::maxInstructions(), static_cast<double>(Script::maxMilliseconds()));
+}
+
+#if defined(WITH_LUAJIT)
+void ScriptManager::setJitMode(lua_State *L)
+{
+	// Count hooks are not called from compiled traces, so a budget can only be enforced by the interpreter
+	const bool hasBudget = (Script::maxInstructions() > 0 || Script::maxMilliseconds() > 0.0f);
+	luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | (hasBudget ? LUAJIT_MODE_OFF : LUAJIT_MODE_ON));
+}
+#endif
+
+void ScriptManager::countVertexGetterCall(lua_State *L)
+{
+	Script *script = retrieveScript(L);
+	if (script)
+		script->countVertexGetterCall();
+}
+
+void ScriptManager::countVertexSetterCall(lua_State *L)
+{
+	Script *script = retrieveScript(L);
+	if (script)
+		script->countVertexSetterCall();
 }
 
 void ScriptManager::exposeConstants(lua_State *L)
@@ -307,6 +556,7 @@ void ScriptManager::exposeFunctions(lua_State *L)
 	nc::LuaUtils::addGlobalFunction(L, LuaNames::verticesY, verticesY);
 	nc::LuaUtils::addGlobalFunction(L, LuaNames::verticesU, verticesU);
 	nc::LuaUtils::addGlobalFunction(L, LuaNames::verticesV, verticesV);
+	nc::LuaUtils::addGlobalFunction(L, LuaNames::vertexView, vertexView);
 
 	nc::LuaUtils::addGlobalFunction(L, LuaNames::setPosition, setPosition);
 	nc::LuaUtils::addGlobalFunction(L, LuaNames::setPositionX, setPositionX);
@@ -331,6 +581,47 @@ void ScriptManager::exposeFunctions(lua_State *L)
 	nc::LuaUtils::addGlobalFunction(L, LuaNames::setVerticesY, setVerticesY);
 	nc::LuaUtils::addGlobalFunction(L, LuaNames::setVerticesU, setVerticesU);
 	nc::LuaUtils::addGlobalFunction(L, LuaNames::setVerticesV, setVerticesV);
+
+	exposeVertexView(L);
+	exposeGridModule(L);
+#if defined(WITH_LUAJIT)
+	exposeFfiHelpers(L);
+#endif
+}
+
+void ScriptManager::exposeVertexView(lua_State *L)
+{
+	if (luaL_newmetatable(L, vertexViewMetatable))
+	{
+		struct Method
+		{
+			const char *name;
+			lua_CFunction function;
+		};
+
+		const Method methods[] = {
+			{ LuaNames::vertexViewSize, vertexViewSize },
+			{ LuaNames::vertexViewGet, vertexViewGet },
+			{ LuaNames::vertexViewGetXY, vertexViewGetXY },
+			{ LuaNames::vertexViewGetUV, vertexViewGetUV },
+			{ LuaNames::vertexViewSet, vertexViewSet },
+			{ LuaNames::vertexViewSetXY, vertexViewSetXY },
+			{ LuaNames::vertexViewSetUV, vertexViewSetUV }
+		};
+
+		const unsigned int numMethods = sizeof(methods) / sizeof(*methods);
+		nc::LuaUtils::createTable(L, 0, numMethods);
+		for (unsigned int i = 0; i < numMethods; i++)
+		{
+			lua_pushcfunction(L, methods[i].function);
+			lua_setfield(L, -2, methods[i].name);
+		}
+		lua_setfield(L, -2, "__index");
+
+		lua_pushcfunction(L, vertexViewSize);
+		lua_setfield(L, -2, "__len");
+	}
+	nc::LuaUtils::pop(L);
 }
 
 int ScriptManager::canvasWidth(lua_State *L)
@@ -536,6 +827,7 @@ int ScriptManager::numVertices(lua_State *L)
 
 int ScriptManager::vertices(lua_State *L)
 {
+	countVertexGetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	verticesHelper(L, sprite, Components::XYUV);
 
@@ -544,6 +836,7 @@ int ScriptManager::vertices(lua_State *L)
 
 int ScriptManager::verticesXY(lua_State *L)
 {
+	countVertexGetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	verticesHelper(L, sprite, Components::XY);
 
@@ -552,6 +845,7 @@ int ScriptManager::verticesXY(lua_State *L)
 
 int ScriptManager::verticesUV(lua_State *L)
 {
+	countVertexGetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	verticesHelper(L, sprite, Components::UV);
 
@@ -560,6 +854,7 @@ int ScriptManager::verticesUV(lua_State *L)
 
 int ScriptManager::verticesX(lua_State *L)
 {
+	countVertexGetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	verticesHelper(L, sprite, Components::X);
 
@@ -568,6 +863,7 @@ int ScriptManager::verticesX(lua_State *L)
 
 int ScriptManager::verticesY(lua_State *L)
 {
+	countVertexGetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	verticesHelper(L, sprite, Components::Y);
 
@@ -576,6 +872,7 @@ int ScriptManager::verticesY(lua_State *L)
 
 int ScriptManager::verticesU(lua_State *L)
 {
+	countVertexGetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	verticesHelper(L, sprite, Components::U);
 	return 1;
@@ -583,12 +880,267 @@ int ScriptManager::verticesU(lua_State *L)
 
 int ScriptManager::verticesV(lua_State *L)
 {
+	countVertexGetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	verticesHelper(L, sprite, Components::V);
 
 	return 1;
 }
 
+void ScriptManager::exposeGridModule(lua_State *L)
+{
+	struct Function
+	{
+		const char *name;
+		lua_CFunction function;
+	};
+
+	const Function functions[] = {
+		{ LuaNames::gridAddWaveX, gridAddWaveX },
+		{ LuaNames::gridAddWaveY, gridAddWaveY },
+		{ LuaNames::gridAddSkewX, gridAddSkewX },
+		{ LuaNames::gridAddSkewY, gridAddSkewY },
+		{ LuaNames::gridAddZoom, gridAddZoom },
+		{ LuaNames::gridDisplaceByNoise, gridDisplaceByNoise },
+		{ LuaNames::gridApplyAffine, gridApplyAffine },
+		{ LuaNames::gridLerpToRest, gridLerpToRest }
+	};
+
+	const unsigned int numFunctions = sizeof(functions) / sizeof(*functions);
+	nc::LuaUtils::createTable(L, 0, numFunctions);
+	for (unsigned int i = 0; i < numFunctions; i++)
+	{
+		lua_pushcfunction(L, functions[i].function);
+		lua_setfield(L, -2, functions[i].name);
+	}
+	nc::LuaUtils::setGlobal(L, LuaNames::Grid);
+}
+
+int ScriptManager::gridAddWaveX(lua_State *L)
+{
+	countVertexSetterCall(L);
+	Sprite &sprite = checkGridSprite(L, retrieveSprite(L));
+	const float amplitude = static_cast<float>(luaL_checknumber(L, 1));
+	const float frequency = static_cast<float>(luaL_checknumber(L, 2));
+	const float phase = static_cast<float>(luaL_checknumber(L, 3));
+	const float anchorY = static_cast<float>(luaL_optnumber(L, 4, 0.0));
+	GridFunctionLibrary::applyWaveX(sprite, phase, amplitude, frequency, anchorY);
+
+	return 0;
+}
+
+int ScriptManager::gridAddWaveY(lua_State *L)
+{
+	countVertexSetterCall(L);
+	Sprite &sprite = checkGridSprite(L, retrieveSprite(L));
+	const float amplitude = static_cast<float>(luaL_checknumber(L, 1));
+	const float frequency = static_cast<float>(luaL_checknumber(L, 2));
+	const float phase = static_cast<float>(luaL_checknumber(L, 3));
+	const float anchorX = static_cast<float>(luaL_optnumber(L, 4, 0.0));
+	GridFunctionLibrary::applyWaveY(sprite, phase, amplitude, frequency, anchorX);
+
+	return 0;
+}
+
+int ScriptManager::gridAddSkewX(lua_State *L)
+{
+	countVertexSetterCall(L);
+	Sprite &sprite = checkGridSprite(L, retrieveSprite(L));
+	const float value = static_cast<float>(luaL_checknumber(L, 1));
+	const float anchorY = static_cast<float>(luaL_optnumber(L, 2, 0.0));
+	GridFunctionLibrary::applySkewX(sprite, value, anchorY);
+
+	return 0;
+}
+
+int ScriptManager::gridAddSkewY(lua_State *L)
+{
+	countVertexSetterCall(L);
+	Sprite &sprite = checkGridSprite(L, retrieveSprite(L));
+	const float value = static_cast<float>(luaL_checknumber(L, 1));
+	const float anchorX = static_cast<float>(luaL_optnumber(L, 2, 0.0));
+	GridFunctionLibrary::applySkewY(sprite, value, anchorX);
+
+	return 0;
+}
+
+int ScriptManager::gridAddZoom(lua_State *L)
+{
+	countVertexSetterCall(L);
+	Sprite &sprite = checkGridSprite(L, retrieveSprite(L));
+	const float value = static_cast<float>(luaL_checknumber(L, 1));
+	const float anchorX = static_cast<float>(luaL_optnumber(L, 2, 0.0));
+	const float anchorY = static_cast<float>(luaL_optnumber(L, 3, 0.0));
+	GridFunctionLibrary::applyZoom(sprite, value, anchorX, anchorY);
+
+	return 0;
+}
+
+int ScriptManager::gridDisplaceByNoise(lua_State *L)
+{
+	countVertexSetterCall(L);
+	Sprite &sprite = checkGridSprite(L, retrieveSprite(L));
+	const float amount = static_cast<float>(luaL_checknumber(L, 1));
+	const unsigned int seed = static_cast<unsigned int>(luaL_optinteger(L, 2, 0));
+	GridFunctionLibrary::applyNoise(sprite, amount, seed);
+
+	return 0;
+}
+
+int ScriptManager::gridApplyAffine(lua_State *L)
+{
+	countVertexSetterCall(L);
+	Sprite &sprite = checkGridSprite(L, retrieveSprite(L));
+	float matrix[6];
+	// The matrix can be passed either as a table or as six numbers
+	if (nc::LuaUtils::isTable(L, 1))
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			nc::LuaUtils::rawGeti(L, 1, i + 1); // Lua arrays start from index 1
+			matrix[i] = static_cast<float>(luaL_checknumber(L, -1));
+			nc::LuaUtils::pop(L);
+		}
+	}
+	else
+	{
+		for (int i = 0; i < 6; i++)
+			matrix[i] = static_cast<float>(luaL_checknumber(L, i + 1));
+	}
+	GridFunctionLibrary::applyAffine(sprite, matrix);
+
+	return 0;
+}
+
+int ScriptManager::gridLerpToRest(lua_State *L)
+{
+	countVertexSetterCall(L);
+	Sprite &sprite = checkGridSprite(L, retrieveSprite(L));
+	const float factor = static_cast<float>(luaL_checknumber(L, 1));
+	GridFunctionLibrary::lerpToRest(sprite, factor);
+
+	return 0;
+}
+
+#if defined(WITH_LUAJIT)
+void ScriptManager::exposeFfiHelpers(lua_State *L)
+{
+	nc::LuaUtils::addGlobalFunction(L, LuaNames::verticesPointer, verticesPointer);
+
+	const int status = luaL_loadbuffer(L, ffiHelpers, strlen(ffiHelpers), "ffi_helpers");
+	if (nc::LuaUtils::isStatusOk(status) == false || nc::LuaUtils::isStatusOk(nc::LuaUtils::pcall(L, 0, 0)) == false)
+	{
+		LOGE_X("Cannot expose the FFI helpers: %s", nc::LuaUtils::retrieve<const char *>(L, -1));
+		nc::LuaUtils::pop(L);
+	}
+}
+
+int ScriptManager::verticesPointer(lua_State *L)
+{
+	countVertexGetterCall(L);
+	Sprite *sprite = retrieveSprite(L);
+	const unsigned int numVertices = sprite ? sprite->interleavedVertices().size() : 0;
+	void *pointer = (numVertices > 0) ? sprite->interleavedVertices().data() : nullptr;
+	lua_pushlightuserdata(L, pointer);
+	nc::LuaUtils::push(L, numVertices);
+
+	return 2;
+}
+#endif
+
+int ScriptManager::vertexView(lua_State *L)
+{
+	// The view is stateless, a single instance per Lua state is reused by all calls
+	nc::LuaUtils::push(L, reinterpret_cast<void *>(&vertexViewKey));
+	const int type = nc::LuaUtils::getTable(L, nc::LuaUtils::registryIndex());
+	if (type != LUA_TUSERDATA)
+	{
+		nc::LuaUtils::pop(L);
+		lua_newuserdata(L, 1);
+		luaL_getmetatable(L, vertexViewMetatable);
+		lua_setmetatable(L, -2);
+
+		nc::LuaUtils::push(L, reinterpret_cast<void *>(&vertexViewKey));
+		lua_pushvalue(L, -2);
+		nc::LuaUtils::setTable(L, nc::LuaUtils::registryIndex());
+	}
+
+	return 1;
+}
+
+int ScriptManager::vertexViewSize(lua_State *L)
+{
+	Sprite *sprite = retrieveSprite(L);
+	const unsigned int numVertices = sprite ? sprite->interleavedVertices().size() : 0;
+	nc::LuaUtils::push(L, numVertices);
+
+	return 1;
+}
+
+int ScriptManager::vertexViewGet(lua_State *L)
+{
+	countVertexGetterCall(L);
+	const Sprite::Vertex &vertex = checkVertex(L, retrieveSprite(L));
+	nc::LuaUtils::push(L, vertex.x);
+	nc::LuaUtils::push(L, vertex.y);
+	nc::LuaUtils::push(L, vertex.u);
+	nc::LuaUtils::push(L, vertex.v);
+
+	return 4;
+}
+
+int ScriptManager::vertexViewGetXY(lua_State *L)
+{
+	countVertexGetterCall(L);
+	const Sprite::Vertex &vertex = checkVertex(L, retrieveSprite(L));
+	nc::LuaUtils::push(L, vertex.x);
+	nc::LuaUtils::push(L, vertex.y);
+
+	return 2;
+}
+
+int ScriptManager::vertexViewGetUV(lua_State *L)
+{
+	countVertexGetterCall(L);
+	const Sprite::Vertex &vertex = checkVertex(L, retrieveSprite(L));
+	nc::LuaUtils::push(L, vertex.u);
+	nc::LuaUtils::push(L, vertex.v);
+
+	return 2;
+}
+
+int ScriptManager::vertexViewSet(lua_State *L)
+{
+	countVertexSetterCall(L);
+	Sprite::Vertex &vertex = checkVertex(L, retrieveSprite(L));
+	vertex.x = static_cast<float>(luaL_checknumber(L, 3));
+	vertex.y = static_cast<float>(luaL_checknumber(L, 4));
+	vertex.u = static_cast<float>(luaL_checknumber(L, 5));
+	vertex.v = static_cast<float>(luaL_checknumber(L, 6));
+
+	return 0;
+}
+
+int ScriptManager::vertexViewSetXY(lua_State *L)
+{
+	countVertexSetterCall(L);
+	Sprite::Vertex &vertex = checkVertex(L, retrieveSprite(L));
+	vertex.x = static_cast<float>(luaL_checknumber(L, 3));
+	vertex.y = static_cast<float>(luaL_checknumber(L, 4));
+
+	return 0;
+}
+
+int ScriptManager::vertexViewSetUV(lua_State *L)
+{
+	countVertexSetterCall(L);
+	Sprite::Vertex &vertex = checkVertex(L, retrieveSprite(L));
+	vertex.u = static_cast<float>(luaL_checknumber(L, 3));
+	vertex.v = static_cast<float>(luaL_checknumber(L, 4));
+
+	return 0;
+}
+
 int ScriptManager::setPosition(lua_State *L)
 {
 	Sprite *sprite = retrieveSprite(L);
@@ -597,6 +1149,7 @@ int ScriptManager::setPosition(lua_State *L)
 		const nc::Vector2f pos = nc::LuaVector2fUtils::retrieveTable(L, -1);
 		sprite->x = pos.x;
 		sprite->y = pos.y;
+		sprite->markDirty();
 	}
 
 	return 0;
@@ -609,6 +1162,7 @@ int ScriptManager::setPositionX(lua_State *L)
 	{
 		const float x = nc::LuaUtils::retrieve<float>(L, -1);
 		sprite->x = x;
+		sprite->markDirty();
 	}
 
 	return 0;
@@ -621,6 +1175,7 @@ int ScriptManager::setPositionY(lua_State *L)
 	{
 		const float y = nc::LuaUtils::retrieve<float>(L, -1);
 		sprite->y = y;
+		sprite->markDirty();
 	}
 
 	return 0;
@@ -633,6 +1188,7 @@ int ScriptManager::setRotation(lua_State *L)
 	{
 		const float rot = nc::LuaUtils::retrieve<float>(L, -1);
 		sprite->rotation = rot;
+		sprite->markDirty();
 	}
 
 	return 0;
@@ -645,6 +1201,7 @@ int ScriptManager::setScale(lua_State *L)
 	{
 		const nc::Vector2f scale = nc::LuaVector2fUtils::retrieveTable(L, -1);
 		sprite->scaleFactor = scale;
+		sprite->markDirty();
 	}
 
 	return 0;
@@ -657,6 +1214,7 @@ int ScriptManager::setScaleX(lua_State *L)
 	{
 		const float scaleX = nc::LuaUtils::retrieve<float>(L, -1);
 		sprite->scaleFactor.x = scaleX;
+		sprite->markDirty();
 	}
 
 	return 0;
@@ -669,6 +1227,7 @@ int ScriptManager::setScaleY(lua_State *L)
 	{
 		const float scaleY = nc::LuaUtils::retrieve<float>(L, -1);
 		sprite->scaleFactor.y = scaleY;
+		sprite->markDirty();
 	}
 
 	return 0;
@@ -681,6 +1240,7 @@ int ScriptManager::setAnchorPoint(lua_State *L)
 	{
 		const nc::Vector2f anchorPoint = nc::LuaVector2fUtils::retrieveTable(L, -1);
 		sprite->anchorPoint = anchorPoint;
+		sprite->markDirty();
 	}
 
 	return 0;
@@ -693,6 +1253,7 @@ int ScriptManager::setAnchorPointX(lua_State *L)
 	{
 		const float anchorPointX = nc::LuaUtils::retrieve<float>(L, -1);
 		sprite->anchorPoint.x = anchorPointX;
+		sprite->markDirty();
 	}
 
 	return 0;
@@ -705,6 +1266,7 @@ int ScriptManager::setAnchorPointY(lua_State *L)
 	{
 		const float anchorPointY = nc::LuaUtils::retrieve<float>(L, -1);
 		sprite->anchorPoint.y = anchorPointY;
+		sprite->markDirty();
 	}
 
 	return 0;
@@ -718,6 +1280,7 @@ int ScriptManager::setColor(lua_State *L)
 		int colorIndex = 0;
 		const nc::Colorf color = nc::LuaColorUtils::retrieve(L, -1, colorIndex);
 		sprite->color = color;
+		sprite->markDirty();
 	}
 
 	return 0;
@@ -730,7 +1293,9 @@ int ScriptManager::setTexRect(lua_State *L)
 	{
 		int rectIndex = 0;
 		const nc::Recti texRect = nc::LuaRectiUtils::retrieve(L, -1, rectIndex);
-		sprite->setTexRect(texRect);
+		// A worker thread cannot reallocate the grid or trigger other script calls
+		if (ScriptWorkers::deferTexRect(sprite, texRect) == false)
+			sprite->setTexRect(texRect);
 	}
 
 	return 0;
@@ -786,6 +1351,7 @@ int ScriptManager::setAlphaBlendingPreset(lua_State *L)
 
 int ScriptManager::setVertices(lua_State *L)
 {
+	countVertexSetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	setVerticesHelper(L, sprite, Components::XYUV);
 
@@ -794,6 +1360,7 @@ int ScriptManager::setVertices(lua_State *L)
 
 int ScriptManager::setVerticesXY(lua_State *L)
 {
+	countVertexSetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	setVerticesHelper(L, sprite, Components::XY);
 
@@ -802,6 +1369,7 @@ int ScriptManager::setVerticesXY(lua_State *L)
 
 int ScriptManager::setVerticesUV(lua_State *L)
 {
+	countVertexSetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	setVerticesHelper(L, sprite, Components::UV);
 
@@ -810,6 +1378,7 @@ int ScriptManager::setVerticesUV(lua_State *L)
 
 int ScriptManager::setVerticesX(lua_State *L)
 {
+	countVertexSetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	setVerticesHelper(L, sprite, Components::X);
 
@@ -818,6 +1387,7 @@ int ScriptManager::setVerticesX(lua_State *L)
 
 int ScriptManager::setVerticesY(lua_State *L)
 {
+	countVertexSetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	setVerticesHelper(L, sprite, Components::Y);
 
@@ -826,6 +1396,7 @@ int ScriptManager::setVerticesY(lua_State *L)
 
 int ScriptManager::setVerticesU(lua_State *L)
 {
+	countVertexSetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	setVerticesHelper(L, sprite, Components::U);
 
@@ -834,6 +1405,7 @@ int ScriptManager::setVerticesU(lua_State *L)
 
 int ScriptManager::setVerticesV(lua_State *L)
 {
+	countVertexSetterCall(L);
 	Sprite *sprite = retrieveSprite(L);
 	setVerticesHelper(L, sprite, Components::V);
 
@@ -0,0 +1,199 @@
+#define NCINE_INCLUDE_LUA
+#include <ncine/common_headers.h>
+#include <ncine/LuaUtils.h>
+#include "ScriptWorkers.h"
+#include "ScriptManager.h"
+#include "Sprite.h"
+
+///////////////////////////////////////////////////////////
+// STATIC DEFINITIONS
+///////////////////////////////////////////////////////////
+
+thread_local ScriptWorkers::Worker *ScriptWorkers::currentWorker_ = nullptr;
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+ScriptWorkers::ScriptWorkers(unsigned int numWorkers)
+    : workers_(numWorkers), nextWorkerIndex_(0), generation_(0), numBusyWorkers_(0), shouldQuit_(false)
+{
+	ASSERT(numWorkers > 0);
+	for (unsigned int i = 0; i < numWorkers; i++)
+	{
+		nctl::UniquePtr<Worker> worker = nctl::makeUnique<Worker>();
+		worker->workers = this;
+		// Statistics tracking is not thread-safe and is disabled for worker states
+		worker->luaState = nctl::makeUnique<nc::LuaStateManager>(nc::LuaStateManager::ApiType::NONE,
+		                                                          nc::LuaStateManager::StatisticsTracking::DISABLED,
+		                                                          nc::LuaStateManager::StandardLibraries::LOADED);
+		lua_State *L = worker->luaState->state();
+		ScriptManager::exposeConstants(L);
+		ScriptManager::exposeFunctions(L);
+		ScriptManager::installBudgetHook(L);
+		installGlobalsWatcher(*worker);
+
+		workers_.pushBack(nctl::move(worker));
+	}
+
+	// Threads are started only when all the states are ready
+	for (unsigned int i = 0; i < workers_.size(); i++)
+	{
+		Worker *worker = workers_[i].get();
+		worker->thread = std::thread([this, worker]() { workerLoop(*worker); });
+	}
+}
+
+ScriptWorkers::~ScriptWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		shouldQuit_ = true;
+	}
+	startCondition_.notify_all();
+
+	for (unsigned int i = 0; i < workers_.size(); i++)
+		workers_[i]->thread.join();
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void ScriptWorkers::submit(const Job &job)
+{
+	ASSERT(job.script != nullptr);
+	// A script is bound to a single worker, its environment lives in that worker state
+	if (job.script->workerIndex_ < 0 || job.script->workerIndex_ >= static_cast<int>(workers_.size()))
+	{
+		job.script->workerIndex_ = static_cast<int>(nextWorkerIndex_);
+		nextWorkerIndex_ = (nextWorkerIndex_ + 1) % workers_.size();
+	}
+
+	workers_[job.script->workerIndex_]->jobs.pushBack(job);
+}
+
+void ScriptWorkers::flush()
+{
+	bool hasJobs = false;
+	for (unsigned int i = 0; i < workers_.size(); i++)
+		hasJobs |= (workers_[i]->jobs.isEmpty() == false);
+	if (hasJobs == false)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		numBusyWorkers_ = workers_.size();
+		generation_++;
+		startCondition_.notify_all();
+		doneCondition_.wait(lock, [this]() { return numBusyWorkers_ == 0; });
+	}
+
+	nctl::Array<DeferredTexRect> deferredTexRects;
+	for (unsigned int i = 0; i < workers_.size(); i++)
+	{
+		Worker &worker = *workers_[i];
+		for (unsigned int j = 0; j < worker.errors.size(); j++)
+			LOGE_X("%s", worker.errors[j].data());
+		for (unsigned int j = 0; j < worker.warnings.size(); j++)
+			LOGW_X("%s", worker.warnings[j].data());
+		for (unsigned int j = 0; j < worker.deferredTexRects.size(); j++)
+			deferredTexRects.pushBack(worker.deferredTexRects[j]);
+
+		worker.errors.clear();
+		worker.warnings.clear();
+		worker.deferredTexRects.clear();
+	}
+
+	// Applied on the main thread as it can reallocate the grid and run the init function of scripts again
+	for (unsigned int i = 0; i < deferredTexRects.size(); i++)
+		deferredTexRects[i].sprite->setTexRect(deferredTexRects[i].texRect);
+}
+
+bool ScriptWorkers::deferTexRect(Sprite *sprite, const nc::Recti &texRect)
+{
+	if (currentWorker_ == nullptr)
+		return false;
+
+	currentWorker_->deferredTexRects.pushBack({ sprite, texRect });
+	return true;
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void ScriptWorkers::workerLoop(Worker &worker)
+{
+	currentWorker_ = &worker;
+	unsigned int lastGeneration = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			startCondition_.wait(lock, [this, lastGeneration]() { return shouldQuit_ || generation_ != lastGeneration; });
+			if (shouldQuit_)
+				break;
+			lastGeneration = generation_;
+		}
+
+		runJobs(worker);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			numBusyWorkers_--;
+		}
+		doneCondition_.notify_one();
+	}
+}
+
+void ScriptWorkers::runJobs(Worker &worker)
+{
+	lua_State *L = worker.luaState->state();
+	nctl::String errorMessage(256);
+
+	// Jobs run in submission order, an `init` call always precedes the `update` calls that follow it
+	for (unsigned int i = 0; i < worker.jobs.size(); i++)
+	{
+		const Job &job = worker.jobs[i];
+		worker.currentScript = job.script;
+		if (job.script->callFunctionInWorker(L, job.function, job.sprite, job.value, errorMessage) == false)
+			worker.errors.pushBack(errorMessage);
+	}
+	worker.currentScript = nullptr;
+	worker.jobs.clear();
+}
+
+void ScriptWorkers::installGlobalsWatcher(Worker &worker)
+{
+	lua_State *L = worker.luaState->state();
+
+	// Script environments catch their own globals, a new key in `_G` is a side effect shared by all scripts of the worker.
+	// Writes to the fields of tables that already exist in `_G`, like `math` or `string`, are not detected.
+	nc::LuaUtils::getGlobal(L, "_G");
+	nc::LuaUtils::createTable(L, 0, 1);
+	lua_pushlightuserdata(L, &worker);
+	lua_pushcclosure(L, globalWrite, 1);
+	lua_setfield(L, -2, "__newindex");
+	lua_setmetatable(L, -2);
+	nc::LuaUtils::pop(L);
+}
+
+int ScriptWorkers::globalWrite(lua_State *L)
+{
+	Worker *worker = static_cast<Worker *>(lua_touserdata(L, lua_upvalueindex(1)));
+	Script *script = worker->currentScript;
+
+	if (script != nullptr)
+	{
+		script->countGlobalWrite();
+		nctl::String warning(256);
+		const char *key = lua_isstring(L, 2) ? lua_tostring(L, 2) : luaL_typename(L, 2);
+		warning.format("Script \"%s\" wrote the shared global \"%s\" while running in parallel", script->name().data(), key);
+		worker->warnings.pushBack(warning);
+	}
+
+	lua_rawset(L, 1);
+	return 0;
+}
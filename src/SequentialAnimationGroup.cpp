@@ -1,9 +1,20 @@
 #include "SequentialAnimationGroup.h"
+#include "ObjectPool.h"
 
 ///////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
 
+void *SequentialAnimationGroup::operator new(size_t size)
+{
+	return ObjectPool<SequentialAnimationGroup>::allocate(size);
+}
+
+void SequentialAnimationGroup::operator delete(void *ptr, size_t size)
+{
+	ObjectPool<SequentialAnimationGroup>::deallocate(ptr, size);
+}
+
 nctl::UniquePtr<IAnimation> SequentialAnimationGroup::clone() const
 {
 	nctl::UniquePtr<SequentialAnimationGroup> animGroup = nctl::makeUnique<SequentialAnimationGroup>();
@@ -13,6 +13,7 @@
 #include "ScriptAnimation.h"
 #include "AnimationManager.h"
 #include "Configuration.h"
+#include "TextureLoader.h"
 #include "singletons.h"
 
 #include "Serializers.h"
@@ -359,6 +360,13 @@ void serialize(LuaSerializer &ls, const Configuration &cfg)
 	serializeGlobal(ls, "textures_path", cfg.texturesPath);
 	serializeGlobal(ls, "scripts_path", cfg.scriptsPath);
 	serializeGlobal(ls, "show_tips_on_start", cfg.showTipsOnStart);
+	serializeGlobal(ls, "parallel_scripts", cfg.parallelScripts);
+	serializeGlobal(ls, "num_script_workers", cfg.numScriptWorkers);
+	serializeGlobal(ls, "script_instruction_budget", cfg.scriptInstructionBudget);
+	serializeGlobal(ls, "script_time_budget", cfg.scriptTimeBudget);
+	serializeGlobal(ls, "autosave_interval", cfg.autosaveInterval);
+	serializeGlobal(ls, "watch_files", cfg.watchFiles);
+	serializeGlobal(ls, "compact_vertices", cfg.compactVertices);
 
 	const unsigned int numPinnedDirectories = cfg.pinnedDirectories.size();
 	if (numPinnedDirectories > 0)
@@ -405,13 +413,10 @@ bool deserialize(LuaSerializer &ls, const char *name, Canvas &canvas)
 	return true;
 }
 
-void deserialize(LuaSerializer &ls, nctl::UniquePtr<Texture> &texture)
+nctl::String resolveTexturePath(const char *textureName)
 {
-	const char *textureName = deserialize<const char *>(ls, "name");
-	static nctl::String texturePath(256);
-
 	// Check first if the filename is relative to the configuration textures directory
-	texturePath = nc::fs::joinPath(theCfg.texturesPath, textureName);
+	nctl::String texturePath = nc::fs::joinPath(theCfg.texturesPath, textureName);
 	if (nc::fs::isReadableFile(texturePath.data()) == false)
 	{
 		// Then check if the filename is relative to the data textures directory
@@ -421,7 +426,33 @@ void deserialize(LuaSerializer &ls, nctl::UniquePtr<Texture> &texture)
 			texturePath = textureName;
 	}
 
-	texture = nctl::makeUnique<Texture>(texturePath.data());
+	return texturePath;
+}
+
+nctl::String resolveScriptPath(const char *scriptName)
+{
+	// Check first if the filename is relative to the configuration scripts directory
+	nctl::String scriptPath = nc::fs::joinPath(theCfg.scriptsPath, scriptName);
+	if (nc::fs::isReadableFile(scriptPath.data()) == false)
+	{
+		// Then check if the filename is relative to the data scripts directory
+		scriptPath = nc::fs::joinPath(ui::scriptsDataDir, scriptName);
+		// If not then use the full path
+		if (nc::fs::isReadableFile(scriptPath.data()) == false)
+			scriptPath = scriptName;
+	}
+
+	return scriptPath;
+}
+
+void deserialize(LuaSerializer &ls, nctl::UniquePtr<Texture> &texture)
+{
+	const char *textureName = deserialize<const char *>(ls, "name");
+	const nctl::String texturePath = resolveTexturePath(textureName);
+
+	// The texture is a placeholder until the loader uploads its data
+	texture = nctl::makeUnique<Texture>();
+	theTextureLoader->request(*texture, texturePath.data());
 	// Set the texture name to its basename to allow for relocatable project files
 	texture->setName(textureName);
 }
@@ -519,18 +550,7 @@ void deserialize(LuaSerializer &ls, nctl::UniquePtr<Sprite> &sprite)
 void deserialize(LuaSerializer &ls, nctl::UniquePtr<Script> &script)
 {
 	const char *scriptName = deserialize<const char *>(ls, "name");
-	static nctl::String scriptPath(256);
-
-	// Check first if the filename is relative to the configuration scripts directory
-	scriptPath = nc::fs::joinPath(theCfg.scriptsPath, scriptName);
-	if (nc::fs::isReadableFile(scriptPath.data()) == false)
-	{
-		// Then check if the filename is relative to the data scripts directory
-		scriptPath = nc::fs::joinPath(ui::scriptsDataDir, scriptName);
-		// If not then use the full path
-		if (nc::fs::isReadableFile(scriptPath.data()) == false)
-			scriptPath = scriptName;
-	}
+	const nctl::String scriptPath = resolveScriptPath(scriptName);
 
 	script = nctl::makeUnique<Script>(scriptPath.data());
 	// Set the script name to its basename to allow for relocatable project files
@@ -807,6 +827,27 @@ void deserialize(LuaSerializer &ls, Configuration &cfg)
 
 	if (version >= 5)
 		deserialize(ls, "pinned_directories", cfg.pinnedDirectories);
+
+	if (version >= 7)
+	{
+		cfg.parallelScripts = deserializeGlobal<bool>(ls, "parallel_scripts");
+		cfg.numScriptWorkers = deserializeGlobal<int>(ls, "num_script_workers");
+	}
+
+	if (version >= 8)
+	{
+		cfg.scriptInstructionBudget = deserializeGlobal<int>(ls, "script_instruction_budget");
+		cfg.scriptTimeBudget = deserializeGlobal<int>(ls, "script_time_budget");
+	}
+
+	if (version >= 9)
+		cfg.autosaveInterval = deserializeGlobal<int>(ls, "autosave_interval");
+
+	if (version >= 10)
+		cfg.watchFiles = deserializeGlobal<bool>(ls, "watch_files");
+
+	if (version >= 11)
+		cfg.compactVertices = deserializeGlobal<bool>(ls, "compact_vertices");
 }
 
 }
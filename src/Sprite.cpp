@@ -1,8 +1,12 @@
 #include <stddef.h> // for offsetof()
+#include <cmath>
+#include <cstdint>
 #include "Sprite.h"
+#include "ObjectPool.h"
 #include "Texture.h"
 #include "RenderingResources.h"
 #include "AnimationManager.h"
+#include "SpriteManager.h"
 #include "singletons.h"
 #include <ncine/Matrix4x4.h>
 #include <ncine/RenderResources.h>
@@ -20,8 +24,28 @@ struct VertexFormat
 	GLfloat texcoords[2];
 };
 
+/// Normalized displacement from the rest position, texture coordinates are computed by the shader
+struct CompactVertexFormat
+{
+	int16_t positionDelta[2];
+};
+
+/// Displacements are compact only up to the size of the sprite
+const float MaxCompactDelta = 1.0f;
+/// The largest quantization step, in pixels, accepted for the compact format
+const float MaxCompactStep = 0.1f;
+
+/// Shared by all sprites, as vertices are uploaded as soon as they are packed
+nctl::Array<CompactVertexFormat> compactVertices;
+
 }
 
+///////////////////////////////////////////////////////////
+// STATIC DEFINITIONS
+///////////////////////////////////////////////////////////
+
+unsigned int Sprite::hierarchyVersion_ = 0;
+
 ///////////////////////////////////////////////////////////
 // CONSTRUCTORS and DESTRUCTOR
 ///////////////////////////////////////////////////////////
@@ -30,13 +54,14 @@ Sprite::Sprite(Texture *texture)
     : SpriteEntry(SpriteEntry::Type::SPRITE),
       name(MaxNameLength), visible(true), x(0.0f), y(0.0f), rotation(0.0f), scaleFactor(1.0f, 1.0f),
       anchorPoint(0.0f, 0.0f), color(nc::Colorf::White), visited(false), gridAnchorPoint(0.0f, 0.0f),
-      width_(0), height_(0), localMatrix_(nc::Matrix4x4f::Identity), worldMatrix_(nc::Matrix4x4f::Identity),
+      width_(0), height_(0), dirty_(true), worldMatrix_(nc::Matrix4x4f::Identity),
+      culled_(false), gridCulled_(false), gridBounds_(-0.5f, -0.5f, 1.0f, 1.0f),
       absPosition_(0.0f, 0.0f), absScaleFactor_(1.0f, 1.0f), absRotation_(0.0f), absColor_(nc::Colorf::White),
-      texture_(nullptr), texRect_(0, 0, 0, 0), flippingTexRect_(0, 0, 0, 0),
+      texture_(nullptr), texRect_(0, 0, 0, 0), flippingTexRect_(0, 0, 0, 0), hasPlaceholderTexRect_(false),
       flippedX_(false), flippedY_(false),
       rgbBlendingPreset_(BlendingPreset::ALPHA), alphaBlendingPreset_(BlendingPreset::ALPHA),
       gridAnimationsCounter_(0), interleavedVertices_(0), restPositions_(0),
-      indices_(0), shortIndices_(0), parent_(nullptr), children_(4)
+      gridIndices_(nullptr), parent_(nullptr), children_(4), compactVertices_(false)
 {
 	spriteShaderProgram_ = RenderingResources::spriteShaderProgram();
 	spriteShaderUniforms_ = nctl::makeUnique<nc::GLShaderUniforms>(spriteShaderProgram_);
@@ -52,10 +77,20 @@ Sprite::Sprite(Texture *texture)
 	meshSpriteShaderProgram_->attribute("aPosition")->setVboParameters(sizeof(VertexFormat), reinterpret_cast<void *>(offsetof(VertexFormat, position)));
 	meshSpriteShaderProgram_->attribute("aTexCoords")->setVboParameters(sizeof(VertexFormat), reinterpret_cast<void *>(offsetof(VertexFormat, texcoords)));
 
-	FATAL_ASSERT(UniformsBufferSize >= spriteShaderProgram_->uniformsSize());
+	FATAL_ASSERT(UniformsBufferSize >= meshSpriteShaderProgram_->uniformsSize());
+
+	compactMeshSpriteShaderProgram_ = RenderingResources::compactMeshSpriteShaderProgram();
+	compactMeshSpriteShaderUniforms_ = nctl::makeUnique<nc::GLShaderUniforms>(compactMeshSpriteShaderProgram_);
+	compactMeshSpriteShaderUniforms_->setUniformsDataPointer(uniformsBuffer_);
+	compactMeshSpriteShaderUniforms_->uniform("uTexture")->setIntValue(0);
+	nc::GLVertexFormat::Attribute *positionDelta = compactMeshSpriteShaderProgram_->attribute("aPositionDelta");
+	positionDelta->setVboParameters(sizeof(CompactVertexFormat), reinterpret_cast<void *>(offsetof(CompactVertexFormat, positionDelta)));
+	positionDelta->setType(GL_SHORT);
+	positionDelta->setNormalized(true);
+
+	FATAL_ASSERT(UniformsBufferSize >= compactMeshSpriteShaderProgram_->uniformsSize());
 
 	vbo_ = nctl::makeUnique<nc::GLBufferObject>(GL_ARRAY_BUFFER);
-	ibo_ = nctl::makeUnique<nc::GLBufferObject>(GL_ELEMENT_ARRAY_BUFFER);
 
 	setTexture(texture);
 	// Move the sprite in the top-left corner
@@ -63,10 +98,25 @@ Sprite::Sprite(Texture *texture)
 	y = texRect().h / 2;
 }
 
+Sprite::~Sprite()
+{
+	theSpriteMgr->gridIndexCache().release(gridIndices_);
+}
+
 ///////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
 
+void *Sprite::operator new(size_t size)
+{
+	return ObjectPool<Sprite>::allocate(size);
+}
+
+void Sprite::operator delete(void *ptr, size_t size)
+{
+	ObjectPool<Sprite>::deallocate(ptr, size);
+}
+
 nctl::UniquePtr<Sprite> Sprite::clone() const
 {
 	nctl::UniquePtr<Sprite> sprite = nctl::makeUnique<Sprite>(texture_);
@@ -84,6 +134,7 @@ nctl::UniquePtr<Sprite> Sprite::clone() const
 	sprite->flippedX_ = flippedX_;
 	sprite->flippedY_ = flippedY_;
 	sprite->setTexRect(texRect_);
+	sprite->hasPlaceholderTexRect_ = hasPlaceholderTexRect_;
 	sprite->setRgbBlendingPreset(rgbBlendingPreset_);
 	sprite->setAlphaBlendingPreset(alphaBlendingPreset_);
 
@@ -97,31 +148,6 @@ nctl::UniquePtr<Sprite> Sprite::clone() const
 	return sprite;
 }
 
-void Sprite::transform()
-{
-	localMatrix_ = nc::Matrix4x4f::translation(x, y, 0.0f);
-	localMatrix_.rotateZ(rotation);
-	localMatrix_.scale(scaleFactor.x, scaleFactor.y, 1.0f);
-	localMatrix_.translate(-anchorPoint.x, -anchorPoint.y, 0.0f);
-
-	absScaleFactor_ = scaleFactor;
-	absRotation_ = rotation;
-	absColor_ = color;
-
-	if (parent_)
-	{
-		worldMatrix_ = parent_->worldMatrix_ * localMatrix_;
-
-		absScaleFactor_ *= parent_->absScaleFactor_;
-		absRotation_ += parent_->absRotation_;
-		absColor_ *= parent_->absColor_;
-	}
-	else
-		worldMatrix_ = localMatrix_;
-
-	absPosition_.set(worldMatrix_[3][0], worldMatrix_[3][1]);
-}
-
 void Sprite::updateRender()
 {
 	const float texWidth = static_cast<float>(texture_->width());
@@ -142,16 +168,31 @@ void Sprite::updateRender()
 	}
 	else
 	{
-		meshSpriteShaderUniforms_->uniform("color")->setFloatVector(absColor_.data());
-		meshSpriteShaderUniforms_->uniform("texRect")->setFloatValue(texScaleX, texBiasX, texScaleY, texBiasY);
-		meshSpriteShaderUniforms_->uniform("spriteSize")->setFloatValue(width_, height_);
-		meshSpriteShaderUniforms_->uniform("projection")->setFloatVector(RenderingResources::projectionMatrix().data());
-		meshSpriteShaderUniforms_->uniform("modelView")->setFloatVector(worldMatrix_.data());
-		meshSpriteShaderUniforms_->commitUniforms();
-
-		meshSpriteShaderProgram_->defineVertexFormat(vbo_.get(), ibo_.get());
-		const long int vboBytes = interleavedVertices_.size() * sizeof(Vertex);
-		vbo_->bufferData(vboBytes, interleavedVertices_.data(), GL_STATIC_DRAW);
+		float deltaScale = 1.0f;
+		compactVertices_ = theCfg.compactVertices && packCompactVertices(deltaScale);
+		nc::GLShaderProgram *shaderProgram = compactVertices_ ? compactMeshSpriteShaderProgram_ : meshSpriteShaderProgram_;
+		nc::GLShaderUniforms *shaderUniforms = compactVertices_ ? compactMeshSpriteShaderUniforms_.get() : meshSpriteShaderUniforms_.get();
+
+		shaderUniforms->uniform("color")->setFloatVector(absColor_.data());
+		shaderUniforms->uniform("texRect")->setFloatValue(texScaleX, texBiasX, texScaleY, texBiasY);
+		shaderUniforms->uniform("spriteSize")->setFloatValue(width_, height_);
+		shaderUniforms->uniform("projection")->setFloatVector(RenderingResources::projectionMatrix().data());
+		shaderUniforms->uniform("modelView")->setFloatVector(worldMatrix_.data());
+		if (compactVertices_)
+			shaderUniforms->uniform("deltaScale")->setFloatValue(deltaScale);
+		shaderUniforms->commitUniforms();
+
+		shaderProgram->defineVertexFormat(vbo_.get(), gridIndices_->ibo.get());
+		if (compactVertices_)
+		{
+			const long int vboBytes = compactVertices.size() * sizeof(CompactVertexFormat);
+			vbo_->bufferData(vboBytes, compactVertices.data(), GL_STATIC_DRAW);
+		}
+		else
+		{
+			const long int vboBytes = interleavedVertices_.size() * sizeof(Vertex);
+			vbo_->bufferData(vboBytes, interleavedVertices_.data(), GL_STATIC_DRAW);
+		}
 	}
 }
 
@@ -166,12 +207,13 @@ void Sprite::render()
 	}
 	else
 	{
-		meshSpriteShaderProgram_->use();
-
-		if (shortIndices_.isEmpty() == false)
-			glDrawElements(GL_TRIANGLE_STRIP, shortIndices_.size(), GL_UNSIGNED_SHORT, nullptr);
+		if (compactVertices_)
+			compactMeshSpriteShaderProgram_->use();
 		else
-			glDrawElements(GL_TRIANGLE_STRIP, indices_.size(), GL_UNSIGNED_INT, nullptr);
+			meshSpriteShaderProgram_->use();
+
+		const GLenum indexType = gridIndices_->shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		glDrawElements(GL_TRIANGLE_STRIP, gridIndices_->numIndices, indexType, nullptr);
 	}
 }
 
@@ -187,11 +229,17 @@ void Sprite::setTexture(Texture *texture)
 	FATAL_ASSERT(texture);
 	texture_ = texture;
 	setTexRect(nc::Recti(0, 0, texture_->width(), texture_->height()));
+	// The rectangle is replaced with the real size once the texture data is uploaded
+	hasPlaceholderTexRect_ = texture_->isLoading();
 }
 
 void Sprite::setTexRect(const nc::Recti &rect)
 {
-	if (rect == texRect_ || rect.w == 0 || rect.h == 0)
+	if (rect.w == 0 || rect.h == 0)
+		return;
+
+	hasPlaceholderTexRect_ = false;
+	if (rect == texRect_)
 		return;
 
 	texRect_ = rect;
@@ -259,8 +307,8 @@ void Sprite::decrementGridAnimCounter()
 	{
 		interleavedVertices_.clear();
 		restPositions_.clear();
-		indices_.clear();
-		shortIndices_.clear();
+		theSpriteMgr->gridIndexCache().release(gridIndices_);
+		gridIndices_ = nullptr;
 	}
 }
 
@@ -274,6 +322,9 @@ void Sprite::setParent(Sprite *parent)
 	if (parent)
 		parent->addChild(this);
 	parent_ = parent;
+
+	dirty_ = true;
+	hierarchyVersion_++;
 }
 
 void Sprite::setAbsPosition(float xx, float yy)
@@ -294,6 +345,7 @@ void Sprite::setAbsPosition(float xx, float yy)
 		x = xx;
 		y = yy;
 	}
+	dirty_ = true;
 }
 
 ///////////////////////////////////////////////////////////
@@ -324,31 +376,13 @@ void Sprite::initGrid(int width, int height)
 		vbo_->bufferData(vboBytes, nullptr, GL_STATIC_DRAW);
 	}
 
-	// Upper bound for number of indices
-	const unsigned int indicesCapacity = (width + 2) * height * 2;
-	if (indices_.capacity() < indicesCapacity)
-		indices_.setCapacity(indicesCapacity);
-
 	resetVertices();
 	ASSERT(interleavedVertices_.capacity() >= verticesCapacity);
-	resetIndices();
-	ASSERT(indices_.capacity() >= indicesCapacity);
-
-	const unsigned int indicesSize = indices_.size();
-	const long int iboBytes = (indicesSize < 65536)
-	                              ? indicesSize * sizeof(unsigned short)
-	                              : indicesSize * sizeof(unsigned int);
-	if (indicesSize < 65536)
-	{
-		shortIndices_.clear();
-		if (shortIndices_.capacity() < indicesCapacity)
-			shortIndices_.setCapacity(indicesCapacity);
-		for (unsigned int i = 0; i < indicesSize; i++)
-			shortIndices_.pushBack(static_cast<unsigned short>(indices_[i]));
-		ibo_->bufferData(iboBytes, shortIndices_.data(), GL_STATIC_DRAW);
-	}
-	else
-		ibo_->bufferData(iboBytes, indices_.data(), GL_STATIC_DRAW);
+
+	// The new buffer is acquired first, so that it is not uploaded again if the size has not changed
+	GridIndexCache::Entry *gridIndices = theSpriteMgr->gridIndexCache().acquire(width, height);
+	theSpriteMgr->gridIndexCache().release(gridIndices_);
+	gridIndices_ = gridIndices;
 }
 
 void Sprite::resetVertices()
@@ -380,32 +414,48 @@ void Sprite::resetVertices()
 #endif
 }
 
-void Sprite::resetIndices()
+bool Sprite::packCompactVertices(float &deltaScale) const
 {
-	indices_.clear();
-	const unsigned int gridWidth = static_cast<unsigned int>(width_ + 1);
+	ASSERT(interleavedVertices_.size() == restPositions_.size());
 
-	unsigned int vertexIndex = gridWidth;
-	for (unsigned int i = 0; i < height_; i++)
+	// The compact format cannot be used once a script has changed texture coordinates or moved a vertex too far
+	float maxDelta = 0.0f;
+	for (unsigned int i = 0; i < interleavedVertices_.size(); i++)
 	{
-		for (unsigned int j = 0; j < gridWidth; j++)
-		{
-			indices_.pushBack(vertexIndex + j);
-			if (j == 0 && i != 0) // degenerate vertex
-				indices_.pushBack(vertexIndex + j);
-			indices_.pushBack(vertexIndex + j - gridWidth);
-		}
-		if (i != gridWidth - 2) // degenerate vertex
-			indices_.pushBack(indices_.back());
-		vertexIndex += gridWidth;
+		const Vertex &vertex = interleavedVertices_[i];
+		const Vertex &rest = restPositions_[i];
+		if (vertex.u != rest.u || vertex.v != rest.v)
+			return false;
+
+		const float deltaX = fabsf(vertex.x - rest.x);
+		const float deltaY = fabsf(vertex.y - rest.y);
+		// Written to also reject not-a-number values
+		if ((deltaX <= MaxCompactDelta && deltaY <= MaxCompactDelta) == false)
+			return false;
+		maxDelta = (deltaX > maxDelta) ? deltaX : maxDelta;
+		maxDelta = (deltaY > maxDelta) ? deltaY : maxDelta;
 	}
 
-#if 0
-	nctl::String indicesString(1024);
-	for (unsigned int i = 0; i < indices_.size(); i++)
-		indicesString.formatAppend(" %u,", indices_[i]);
-	LOGE_X("Indices:%s", indicesString.data());
-#endif
+	// The step is scaled by the size of the sprite, big sprites can only use the compact format for small displacements
+	const int maxSize = (width_ > height_) ? width_ : height_;
+	if (maxDelta * maxSize / 32767.0f > MaxCompactStep)
+		return false;
+
+	deltaScale = (maxDelta > 0.0f) ? maxDelta : 1.0f;
+	const float quantizeScale = 32767.0f / deltaScale;
+
+	if (compactVertices.capacity() < interleavedVertices_.size())
+		compactVertices.setCapacity(interleavedVertices_.size());
+	compactVertices.setSize(interleavedVertices_.size());
+	for (unsigned int i = 0; i < interleavedVertices_.size(); i++)
+	{
+		const Vertex &vertex = interleavedVertices_[i];
+		const Vertex &rest = restPositions_[i];
+		compactVertices[i].positionDelta[0] = static_cast<int16_t>(lroundf((vertex.x - rest.x) * quantizeScale));
+		compactVertices[i].positionDelta[1] = static_cast<int16_t>(lroundf((vertex.y - rest.y) * quantizeScale));
+	}
+
+	return true;
 }
 
 bool Sprite::addChild(Sprite *sprite)
@@ -1,4 +1,5 @@
 #include "SpriteEntry.h"
+#include "ObjectPool.h"
 #include "Sprite.h" // for `SpriteGroup::clone()`
 #include <ncine/Random.h>
 
@@ -36,6 +37,16 @@ SpriteGroup::SpriteGroup(nc::Colorf entryColor, const char *name)
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
 
+void *SpriteGroup::operator new(size_t size)
+{
+	return ObjectPool<SpriteGroup>::allocate(size);
+}
+
+void SpriteGroup::operator delete(void *ptr, size_t size)
+{
+	ObjectPool<SpriteGroup>::deallocate(ptr, size);
+}
+
 const SpriteGroup *SpriteEntry::toGroup() const
 {
 	return (type_ == Type::GROUP) ? reinterpret_cast<const SpriteGroup *>(this) : nullptr;
@@ -1,6 +1,11 @@
+#include <cmath>
 #include "SpriteManager.h"
 #include "Texture.h"
 #include "Sprite.h"
+#include "ObjectPool.h"
+#include "RenderingResources.h"
+#include "FrameProfiler.h"
+#include <ncine/common_constants.h>
 #include <ncine/GLBlending.h>
 
 namespace {
@@ -32,6 +37,15 @@ void setBlendingFactors(Sprite::BlendingPreset blendingPreset, GLenum &sfactor,
 	}
 }
 
+/// Returns true if a sprite with zero alpha leaves the destination unchanged, as the source is scaled by its alpha
+bool isInvisibleWhenTransparent(const Sprite &sprite)
+{
+	GLenum rgbSfactor, alphaSfactor, dfactor;
+	setBlendingFactors(sprite.rgbBlendingPreset(), rgbSfactor, dfactor);
+	setBlendingFactors(sprite.alphaBlendingPreset(), alphaSfactor, dfactor);
+	return (rgbSfactor == GL_SRC_ALPHA && alphaSfactor == GL_SRC_ALPHA);
+}
+
 void setBlendingFactors(Sprite::BlendingPreset rgbBlendingPreset, Sprite::BlendingPreset alphaBlendingPreset)
 {
 	GLenum rgbSourceFactor = GL_ONE;
@@ -45,6 +59,48 @@ void setBlendingFactors(Sprite::BlendingPreset rgbBlendingPreset, Sprite::Blendi
 	nc::GLBlending::setBlendFunc(rgbSourceFactor, rgbDestFactor, alphaSourceFactor, alphaDestFactor);
 }
 
+template <class T>
+void resizeArray(nctl::Array<T> &array, unsigned int size)
+{
+	if (array.capacity() < size)
+		array.setCapacity(size);
+	array.setSize(size);
+}
+
+/// The grid is evaluated only when closer to the canvas than its size, so it is ready when the sprite enters
+const float GridCullingMargin = 1.0f;
+
+nc::Rectf vertexBounds(const nctl::Array<Sprite::Vertex> &vertices)
+{
+	if (vertices.isEmpty())
+		return nc::Rectf(-0.5f, -0.5f, 1.0f, 1.0f);
+
+	float minX = vertices[0].x;
+	float minY = vertices[0].y;
+	float maxX = vertices[0].x;
+	float maxY = vertices[0].y;
+	for (unsigned int i = 1; i < vertices.size(); i++)
+	{
+		const Sprite::Vertex &v = vertices[i];
+		minX = (v.x < minX) ? v.x : minX;
+		minY = (v.y < minY) ? v.y : minY;
+		maxX = (v.x > maxX) ? v.x : maxX;
+		maxY = (v.y > maxY) ? v.y : maxY;
+	}
+
+	return nc::Rectf(minX, minY, maxX - minX, maxY - minY);
+}
+
+nc::Rectf unionBounds(const nc::Rectf &first, const nc::Rectf &second)
+{
+	const float minX = (first.x < second.x) ? first.x : second.x;
+	const float minY = (first.y < second.y) ? first.y : second.y;
+	const float maxX = (first.x + first.w > second.x + second.w) ? first.x + first.w : second.x + second.w;
+	const float maxY = (first.y + first.h > second.y + second.h) ? first.y + first.h : second.y + second.h;
+
+	return nc::Rectf(minX, minY, maxX - minX, maxY - minY);
+}
+
 void recursiveLinearizeSprites(SpriteGroup &group, nctl::Array<Sprite *> &sprites, unsigned int &spriteId)
 {
 	for (unsigned int i = 0; i < group.children().size(); i++)
@@ -67,7 +123,8 @@ void recursiveLinearizeSprites(SpriteGroup &group, nctl::Array<Sprite *> &sprite
 ///////////////////////////////////////////////////////////
 
 SpriteManager::SpriteManager()
-    : textures_(4), root_(nctl::makeUnique<SpriteGroup>("Root")), spritesWithoutParent_(4), spritesArray_(4)
+    : textures_(4), root_(nctl::makeUnique<SpriteGroup>("Root")), spritesArray_(4),
+      hierarchyVersion_(0), textureIndices_(32)
 {
 	nc::GLBlending::enable();
 }
@@ -91,22 +148,27 @@ void SpriteManager::updateSpritesArray()
 	spritesArray_.clear();
 	unsigned int spriteId = 0;
 	recursiveLinearizeSprites(*root_, spritesArray_, spriteId);
+	updateTransformOrder();
 }
 
 void SpriteManager::update()
 {
-	spritesWithoutParent_.clear();
-	for (unsigned int i = 0; i < spritesArray_.size(); i++)
-	{
-		if (spritesArray_[i]->parent() == nullptr)
-			spritesWithoutParent_.pushBack(spritesArray_[i]);
-	}
+	ProfileScope profileScope("Sprites");
+
+	FrameProfiler::beginScope("Transform");
+	if (hierarchyVersion_ != Sprite::hierarchyVersion())
+		updateTransformOrder();
+	transform();
+	FrameProfiler::endScope();
 
-	for (unsigned int i = 0; i < spritesWithoutParent_.size(); i++)
-		transform(spritesWithoutParent_[i]);
+	FrameProfiler::beginScope("Culling");
+	cull();
+	FrameProfiler::endScope();
 
+	FrameProfiler::beginScope("Draw");
 	for (unsigned int i = 0; i < spritesArray_.size(); i++)
 		draw(spritesArray_[i]);
+	FrameProfiler::endScope();
 }
 
 int SpriteManager::textureIndex(const Texture *texture) const
@@ -114,17 +176,24 @@ int SpriteManager::textureIndex(const Texture *texture) const
 	if (texture == nullptr)
 		return -1;
 
-	int index = -1;
-	for (unsigned int i = 0; i < textures_.size(); i++)
+	const unsigned int *indexPtr = textureIndices_.find(texture);
+	if (indexPtr == nullptr || *indexPtr >= textures_.size() || textures_[*indexPtr].get() != texture)
 	{
-		if (textures_[i].get() == texture)
-		{
-			index = static_cast<int>(i);
-			break;
-		}
+		rebuildTextureIndices();
+		indexPtr = textureIndices_.find(texture);
 	}
 
-	return index;
+	return indexPtr ? static_cast<int>(*indexPtr) : -1;
+}
+
+void SpriteManager::updateSpritesWithTexture(Texture &texture)
+{
+	for (unsigned int i = 0; i < spritesArray_.size(); i++)
+	{
+		Sprite *sprite = spritesArray_[i];
+		if (&sprite->texture() == &texture && sprite->hasPlaceholderTexRect())
+			sprite->setTexture(&texture);
+	}
 }
 
 SpriteGroup *SpriteManager::addGroup(SpriteEntry *selected)
@@ -161,19 +230,178 @@ void SpriteManager::clear()
 {
 	root_->children().clear();
 	spritesArray_.clear();
+	updateTransformOrder();
+	ObjectPool<Sprite>::release();
+	ObjectPool<SpriteGroup>::release();
 	textures_.clear();
+	textureIndices_.clear();
 }
 
 ///////////////////////////////////////////////////////////
 // PRIVATE FUNCTIONS
 ///////////////////////////////////////////////////////////
 
-void SpriteManager::transform(Sprite *sprite)
+void SpriteManager::rebuildTextureIndices() const
+{
+	if (textureIndices_.capacity() < textures_.size() * 2)
+		textureIndices_.rehash(textures_.size() * 2);
+
+	textureIndices_.clear();
+	for (unsigned int i = 0; i < textures_.size(); i++)
+		textureIndices_.insert(textures_[i].get(), i);
+}
+
+void SpriteManager::updateTransformOrder()
+{
+	transformOrder_.clear();
+	parentIndices_.clear();
+	for (unsigned int i = 0; i < spritesArray_.size(); i++)
+	{
+		if (spritesArray_[i]->parent() == nullptr)
+		{
+			transformOrder_.pushBack(spritesArray_[i]);
+			parentIndices_.pushBack(-1);
+		}
+	}
+
+	// A breadth-first visit appends the children of a sprite after the sprite itself
+	for (unsigned int i = 0; i < transformOrder_.size(); i++)
+	{
+		const nctl::Array<Sprite *> &children = transformOrder_[i]->children();
+		for (unsigned int j = 0; j < children.size(); j++)
+		{
+			transformOrder_.pushBack(children[j]);
+			parentIndices_.pushBack(static_cast<int>(i));
+		}
+	}
+
+	const unsigned int numSprites = transformOrder_.size();
+	resizeArray(worldTransforms_, numSprites);
+	resizeArray(changedFlags_, numSprites);
+
+	// The arrays have lost their content, every sprite needs to be transformed again
+	for (unsigned int i = 0; i < numSprites; i++)
+		transformOrder_[i]->markDirty();
+
+	hierarchyVersion_ = Sprite::hierarchyVersion();
+}
+
+void SpriteManager::transform()
+{
+	const unsigned int numSprites = transformOrder_.size();
+	for (unsigned int i = 0; i < numSprites; i++)
+	{
+		Sprite &sprite = *transformOrder_[i];
+		const int parentIndex = parentIndices_[i];
+
+		// A clean sprite with a clean parent keeps the transformation of the previous frame
+		const bool hasChanged = sprite.dirty_ || (parentIndex >= 0 && changedFlags_[parentIndex]);
+		changedFlags_[i] = hasChanged;
+		if (hasChanged == false)
+			continue;
+
+		// Translation, rotation, scale and the anchor point offset, in this order
+		const float radians = sprite.rotation * nc::fDegToRad;
+		const float sine = sinf(radians);
+		const float cosine = cosf(radians);
+		Affine2D local;
+		local.a = cosine * sprite.scaleFactor.x;
+		local.b = sine * sprite.scaleFactor.x;
+		local.c = -sine * sprite.scaleFactor.y;
+		local.d = cosine * sprite.scaleFactor.y;
+		local.tx = sprite.x - (local.a * sprite.anchorPoint.x + local.c * sprite.anchorPoint.y);
+		local.ty = sprite.y - (local.b * sprite.anchorPoint.x + local.d * sprite.anchorPoint.y);
+
+		Affine2D &world = worldTransforms_[i];
+		sprite.absScaleFactor_ = sprite.scaleFactor;
+		sprite.absRotation_ = sprite.rotation;
+		sprite.absColor_ = sprite.color;
+
+		if (parentIndex >= 0)
+		{
+			const Affine2D &parent = worldTransforms_[parentIndex];
+			world.a = parent.a * local.a + parent.c * local.b;
+			world.b = parent.b * local.a + parent.d * local.b;
+			world.c = parent.a * local.c + parent.c * local.d;
+			world.d = parent.b * local.c + parent.d * local.d;
+			world.tx = parent.a * local.tx + parent.c * local.ty + parent.tx;
+			world.ty = parent.b * local.tx + parent.d * local.ty + parent.ty;
+
+			// The parent has already been visited, its absolute values are up to date
+			const Sprite &parentSprite = *transformOrder_[parentIndex];
+			sprite.absScaleFactor_ *= parentSprite.absScaleFactor_;
+			sprite.absRotation_ += parentSprite.absRotation_;
+			sprite.absColor_ *= parentSprite.absColor_;
+		}
+		else
+			world = local;
+
+		sprite.worldMatrix_[0].set(world.a, world.b, 0.0f, 0.0f);
+		sprite.worldMatrix_[1].set(world.c, world.d, 0.0f, 0.0f);
+		sprite.worldMatrix_[2].set(0.0f, 0.0f, 1.0f, 0.0f);
+		sprite.worldMatrix_[3].set(world.tx, world.ty, 0.0f, 1.0f);
+		sprite.absPosition_.set(world.tx, world.ty);
+		sprite.dirty_ = false;
+	}
+}
+
+void SpriteManager::cull()
 {
-	sprite->transform();
+	const unsigned int numSprites = transformOrder_.size();
+	for (unsigned int i = 0; i < numSprites; i++)
+	{
+		Sprite &sprite = *transformOrder_[i];
+		const Affine2D &world = worldTransforms_[i];
+		const float width = static_cast<float>(sprite.width_);
+		const float height = static_cast<float>(sprite.height_);
 
-	for (unsigned int i = 0; i < sprite->children().size(); i++)
-		transform(sprite->children()[i]);
+		// Sprites scaled to zero cannot cover any pixel, fully transparent ones only when blending scales them by their alpha
+		const bool isTransparent = (sprite.absColor_.a() <= 0.0f && isInvisibleWhenTransparent(sprite));
+		const bool isDegenerate = (world.a * world.d - world.b * world.c == 0.0f);
+		if (isTransparent || isDegenerate)
+		{
+			sprite.culled_ = true;
+			sprite.gridCulled_ = true;
+			continue;
+		}
+
+		if (sprite.gridAnimationsCounter_ == 0)
+		{
+			sprite.culled_ = !intersectsCanvas(world, -0.5f * width, -0.5f * height, 0.5f * width, 0.5f * height);
+			sprite.gridCulled_ = sprite.culled_;
+			continue;
+		}
+
+		// The vertices have already been modified for this frame, their bounds are exact
+		const nc::Rectf bounds = vertexBounds(sprite.interleavedVertices_);
+		if (sprite.gridCulled_ == false)
+			sprite.gridBounds_ = bounds;
+		sprite.culled_ = !intersectsCanvas(world, bounds.x * width, bounds.y * height,
+		                                   (bounds.x + bounds.w) * width, (bounds.y + bounds.h) * height);
+
+		// The last evaluated bounds keep the grid functions running for a sprite whose deformation is on the canvas
+		const nc::Rectf gridBounds = unionBounds(bounds, sprite.gridBounds_);
+		sprite.gridCulled_ = !intersectsCanvas(world, (gridBounds.x - GridCullingMargin) * width, (gridBounds.y - GridCullingMargin) * height,
+		                                       (gridBounds.x + gridBounds.w + GridCullingMargin) * width, (gridBounds.y + gridBounds.h + GridCullingMargin) * height);
+	}
+}
+
+bool SpriteManager::intersectsCanvas(const Affine2D &world, float minX, float minY, float maxX, float maxY)
+{
+	const float centerX = 0.5f * (minX + maxX);
+	const float centerY = 0.5f * (minY + maxY);
+	const float halfWidth = 0.5f * (maxX - minX);
+	const float halfHeight = 0.5f * (maxY - minY);
+
+	// The axis-aligned box that contains the transformed rectangle
+	const float worldCenterX = world.a * centerX + world.c * centerY + world.tx;
+	const float worldCenterY = world.b * centerX + world.d * centerY + world.ty;
+	const float worldHalfWidth = fabsf(world.a) * halfWidth + fabsf(world.c) * halfHeight;
+	const float worldHalfHeight = fabsf(world.b) * halfWidth + fabsf(world.d) * halfHeight;
+
+	const nc::Vector2f &canvasSize = RenderingResources::canvasSize();
+	return (worldCenterX + worldHalfWidth >= 0.0f && worldCenterX - worldHalfWidth <= canvasSize.x &&
+	        worldCenterY + worldHalfHeight >= 0.0f && worldCenterY - worldHalfHeight <= canvasSize.y);
 }
 
 void SpriteManager::draw(Sprite *sprite)
@@ -181,8 +409,12 @@ void SpriteManager::draw(Sprite *sprite)
 	if (sprite->visible == false)
 		return;
 
-	sprite->updateRender();
-	setBlendingFactors(sprite->rgbBlendingPreset(), sprite->alphaBlendingPreset());
-	sprite->render();
+	if (sprite->culled_ == false)
+	{
+		sprite->updateRender();
+		setBlendingFactors(sprite->rgbBlendingPreset(), sprite->alphaBlendingPreset());
+		sprite->render();
+	}
+	// Scripts modify the grid of culled sprites too
 	sprite->resetGrid();
 }
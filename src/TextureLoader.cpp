@@ -0,0 +1,198 @@
+#include <ncine/common_macros.h>
+#include <ncine/GLTexture.h>
+#include <ncine/ITextureLoader.h>
+#include "TextureLoader.h"
+#include "Texture.h"
+#include "SpriteManager.h"
+#include "TextureRegistry.h"
+
+#include "singletons.h"
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+TextureLoader::TextureLoader(unsigned int numThreads)
+    : pending_(16), nextId_(1), nextJob_(0), shouldQuit_(false)
+{
+#ifndef __EMSCRIPTEN__
+	if (numThreads == 0)
+	{
+		const unsigned int numCores = std::thread::hardware_concurrency();
+		numThreads = (numCores > 1) ? numCores - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < numThreads; i++)
+		threads_.pushBack(nctl::makeUnique<std::thread>([this]() { threadLoop(); }));
+#endif
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		shouldQuit_ = true;
+	}
+	condition_.notify_all();
+
+	for (unsigned int i = 0; i < threads_.size(); i++)
+		threads_[i]->join();
+
+	for (unsigned int i = 0; i < pending_.size(); i++)
+		pending_[i].texture->loader_ = nullptr;
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void TextureLoader::request(Texture &texture, const char *filename)
+{
+	if (texture.loader_ != nullptr)
+		texture.loader_->cancel(texture);
+	texture.path_ = filename;
+
+	// A file that has already been uploaded is shared without being decoded again
+	TextureRegistry::Entry *entry = theTextureRegistry->acquire(filename);
+	if (entry != nullptr)
+	{
+		texture.setEntry(entry);
+		return;
+	}
+
+	enqueue(texture, filename);
+}
+
+void TextureLoader::reload(Texture &texture)
+{
+	if (texture.loader_ != nullptr)
+		texture.loader_->cancel(texture);
+
+	if (texture.path().isEmpty() == false)
+		enqueue(texture, texture.path().data());
+}
+
+void TextureLoader::cancel(Texture &texture)
+{
+	for (unsigned int i = 0; i < pending_.size(); i++)
+	{
+		if (pending_[i].texture == &texture)
+		{
+			// The job still runs if it has already been picked up, its result will be discarded
+			pending_.removeAt(i);
+			break;
+		}
+	}
+	texture.loader_ = nullptr;
+}
+
+void TextureLoader::update()
+{
+	nctl::Array<Result> results;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (results_.isEmpty())
+			return;
+
+		// Keep only the results that fit in the per-frame budget, the rest will be uploaded in the next frames
+		unsigned long int uploadBytes = 0;
+		unsigned int numResults = 0;
+		while (numResults < results_.size() && (numResults == 0 || uploadBytes < MaxUploadBytesPerFrame))
+		{
+			const nc::ITextureLoader *texLoader = results_[numResults].texLoader.get();
+			uploadBytes += texLoader ? texLoader->dataSize() : 0;
+			numResults++;
+		}
+
+		for (unsigned int i = 0; i < numResults; i++)
+			results.pushBack(nctl::move(results_[i]));
+		for (unsigned int i = numResults; i < results_.size(); i++)
+			results_[i - numResults] = nctl::move(results_[i]);
+		results_.setSize(results_.size() - numResults);
+	}
+
+	for (unsigned int i = 0; i < results.size(); i++)
+	{
+		const Result &result = results[i];
+		Texture *texture = nullptr;
+		for (unsigned int j = 0; j < pending_.size(); j++)
+		{
+			if (pending_[j].id == result.id)
+			{
+				texture = pending_[j].texture;
+				pending_.removeAt(j);
+				break;
+			}
+		}
+
+		// The texture has been destroyed or loaded again in the meantime
+		if (texture == nullptr)
+			continue;
+
+		texture->loader_ = nullptr;
+		if (result.texLoader == nullptr || result.texLoader->hasLoaded() == false)
+		{
+			LOGE_X("Cannot load texture \"%s\"", result.filename.data());
+			continue;
+		}
+
+		texture->setEntry(theTextureRegistry->acquire(*result.texLoader, result.filename.data(), result.contentHash));
+		theSpriteMgr->updateSpritesWithTexture(*texture);
+	}
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void TextureLoader::enqueue(Texture &texture, const char *filename)
+{
+	if (threads_.isEmpty())
+	{
+		// Without threads the texture is decoded and uploaded immediately
+		nctl::UniquePtr<nc::ITextureLoader> texLoader = nc::ITextureLoader::createFromFile(filename);
+		if (texLoader->hasLoaded())
+			texture.setEntry(theTextureRegistry->acquire(*texLoader, filename, TextureRegistry::contentHash(*texLoader)));
+		return;
+	}
+
+	const unsigned int id = nextId_++;
+	pending_.pushBack({ &texture, id });
+	texture.loader_ = this;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs_.pushBack({ id, filename });
+	}
+	condition_.notify_one();
+}
+
+void TextureLoader::threadLoop()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this]() { return shouldQuit_ || nextJob_ < jobs_.size(); });
+			if (shouldQuit_)
+				break;
+
+			job = nctl::move(jobs_[nextJob_++]);
+			if (nextJob_ == jobs_.size())
+			{
+				jobs_.clear();
+				nextJob_ = 0;
+			}
+		}
+
+		// File reading, image decoding and hashing do not need the OpenGL context
+		nctl::UniquePtr<nc::ITextureLoader> texLoader = nc::ITextureLoader::createFromFile(job.filename.data());
+		const TextureRegistry::ContentHash contentHash = texLoader->hasLoaded() ? TextureRegistry::contentHash(*texLoader) : TextureRegistry::ContentHash{ 0, 0 };
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			results_.pushBack({ job.id, nctl::move(job.filename), nctl::move(texLoader), contentHash });
+		}
+	}
+}
@@ -0,0 +1,283 @@
+#include <cstring>
+#include <ncine/GLTexture.h>
+#include <ncine/ITextureLoader.h>
+#include "TextureRegistry.h"
+
+namespace {
+
+const unsigned int InitialCapacity = 64;
+
+/// Grows the map before it gets too crowded
+template <class K>
+void reserveOne(nctl::HashMap<K, TextureRegistry::Entry *> &hashMap)
+{
+	if ((hashMap.size() + 1) * 2 > hashMap.capacity())
+		hashMap.rehash(hashMap.capacity() * 2);
+}
+
+const uint64_t MurmurMultiplier = 0xc6a4a7935bd1e995ULL;
+const int MurmurShift = 47;
+const uint64_t XxPrime1 = 0x9e3779b185ebca87ULL;
+const uint64_t XxPrime2 = 0xc2b2ae3d27d4eb4fULL;
+const uint64_t XxPrime3 = 0x165667b19e3779f9ULL;
+const uint64_t XxPrime4 = 0x85ebca77c2b2ae63ULL;
+const uint64_t XxPrime5 = 0x27d4eb2f165667c5ULL;
+
+inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+/// Accumulates the two hashes in a single pass over the words
+class ContentHasher
+{
+  public:
+	explicit ContentHasher(unsigned long length)
+	    : murmur_(length * MurmurMultiplier), xx_(XxPrime5 + length) {}
+
+	void addWord(uint64_t word)
+	{
+		// MurmurHash64A, every bit of the word affects every bit of the state
+		uint64_t k = word * MurmurMultiplier;
+		k ^= k >> MurmurShift;
+		k *= MurmurMultiplier;
+		murmur_ = (murmur_ ^ k) * MurmurMultiplier;
+
+		// A single lane xxHash64 round, with different constants and rotations
+		uint64_t lane = rotateLeft(word * XxPrime2, 31) * XxPrime1;
+		xx_ = rotateLeft(xx_ ^ lane, 27) * XxPrime1 + XxPrime4;
+	}
+
+	TextureRegistry::ContentHash finalize() const
+	{
+		uint64_t murmur = murmur_;
+		murmur ^= murmur >> MurmurShift;
+		murmur *= MurmurMultiplier;
+		murmur ^= murmur >> MurmurShift;
+
+		uint64_t xx = xx_;
+		xx ^= xx >> 33;
+		xx *= XxPrime2;
+		xx ^= xx >> 29;
+		xx *= XxPrime3;
+		xx ^= xx >> 32;
+
+		return { murmur, xx };
+	}
+
+  private:
+	uint64_t murmur_;
+	uint64_t xx_;
+};
+
+void removePath(TextureRegistry::Entry &entry, const nctl::String &path)
+{
+	for (unsigned int i = 0; i < entry.paths.size(); i++)
+	{
+		if (entry.paths[i] == path)
+		{
+			entry.paths.removeAt(i);
+			break;
+		}
+	}
+}
+
+void upload(TextureRegistry::Entry &entry, const nc::ITextureLoader &texLoader)
+{
+	const nc::IGfxCapabilities &gfxCaps = nc::theServiceLocator().gfxCapabilities();
+	const int maxTextureSize = gfxCaps.value(nc::IGfxCapabilities::GLIntValues::MAX_TEXTURE_SIZE);
+	FATAL_ASSERT_MSG_X(texLoader.width() <= maxTextureSize, "Texture width %d is bigger than device maximum %d", texLoader.width(), maxTextureSize);
+	FATAL_ASSERT_MSG_X(texLoader.height() <= maxTextureSize, "Texture height %d is bigger than device maximum %d", texLoader.height(), maxTextureSize);
+
+	// Entries are never modified after creation, so the storage can always be immutable
+	entry.glTexture = nctl::makeUnique<nc::GLTexture>(GL_TEXTURE_2D);
+	nc::GLTexture &glTexture = *entry.glTexture;
+	glTexture.bind();
+	glTexture.texParameteri(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexture.texParameteri(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexture.texParameteri(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexture.texParameteri(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+	const nc::TextureFormat &texFormat = texLoader.texFormat();
+
+#if (defined(__ANDROID__) && GL_ES_VERSION_3_0) || defined(WITH_ANGLE) || defined(__EMSCRIPTEN__)
+	const bool withTexStorage = true;
+#else
+	const bool withTexStorage = gfxCaps.hasExtension(nc::IGfxCapabilities::GLExtensions::ARB_TEXTURE_STORAGE);
+#endif
+
+	if (withTexStorage)
+	{
+		glTexture.texStorage2D(texLoader.mipMapCount(), texFormat.internalFormat(), texLoader.width(), texLoader.height());
+		glTexture.texSubImage2D(0, 0, 0, texLoader.width(), texLoader.height(), texFormat.format(), texFormat.type(), texLoader.pixels());
+	}
+	else
+		glTexture.texImage2D(0, texFormat.internalFormat(), texLoader.width(), texLoader.height(), texFormat.format(), texFormat.type(), texLoader.pixels());
+
+	entry.width = texLoader.width();
+	entry.height = texLoader.height();
+	entry.numChannels = texFormat.numChannels();
+	entry.dataSize = texLoader.dataSize();
+}
+
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+TextureRegistry::Entry::Entry()
+    : contentHash({ 0, 0 }), width(0), height(0), numChannels(0), dataSize(0), refCount(0)
+{
+}
+
+TextureRegistry::Entry::~Entry()
+{
+}
+
+TextureRegistry::TextureRegistry()
+    : entries_(InitialCapacity), pathHash_(InitialCapacity), contentHash_(InitialCapacity)
+{
+	placeholder_ = nctl::makeUnique<Entry>();
+	placeholder_->glTexture = nctl::makeUnique<nc::GLTexture>(GL_TEXTURE_2D);
+	placeholder_->width = 1;
+	placeholder_->height = 1;
+	placeholder_->numChannels = 4;
+	// The registry holds a reference so that the placeholder is never released
+	placeholder_->refCount = 1;
+
+	const unsigned char pixel[4] = { 0, 0, 0, 0 };
+	nc::GLTexture &glTexture = *placeholder_->glTexture;
+	glTexture.bind();
+	glTexture.texParameteri(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexture.texParameteri(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexture.texImage2D(0, GL_RGBA8, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+}
+
+TextureRegistry::~TextureRegistry()
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+TextureRegistry::ContentHash TextureRegistry::contentHash(const nc::ITextureLoader &texLoader)
+{
+	const unsigned char *pixels = static_cast<const unsigned char *>(texLoader.pixels());
+	const unsigned long dataSize = texLoader.dataSize();
+	ContentHasher hasher(dataSize);
+
+	const unsigned long numWords = dataSize / sizeof(uint64_t);
+	for (unsigned long i = 0; i < numWords; i++)
+	{
+		uint64_t word;
+		memcpy(&word, pixels + i * sizeof(uint64_t), sizeof(uint64_t));
+		hasher.addWord(word);
+	}
+
+	// The tail is padded with zeros, the length is already part of the seed
+	uint64_t tail = 0;
+	memcpy(&tail, pixels + numWords * sizeof(uint64_t), dataSize - numWords * sizeof(uint64_t));
+	hasher.addWord(tail);
+
+	hasher.addWord((static_cast<uint64_t>(texLoader.width()) << 32) | static_cast<uint32_t>(texLoader.height()));
+	hasher.addWord(static_cast<uint64_t>(texLoader.texFormat().internalFormat()));
+
+	return hasher.finalize();
+}
+
+TextureRegistry::Entry *TextureRegistry::acquire(const char *path)
+{
+	if (path == nullptr || path[0] == '\0')
+		return nullptr;
+
+	Entry **entryPtr = pathHash_.find(nctl::String(path));
+	if (entryPtr == nullptr)
+		return nullptr;
+
+	(*entryPtr)->refCount++;
+	return *entryPtr;
+}
+
+TextureRegistry::Entry *TextureRegistry::acquire(const nc::ITextureLoader &texLoader, const char *path, const ContentHash &contentHash)
+{
+	Entry *entry = nullptr;
+	Entry **entryPtr = contentHash_.find(contentHash.key);
+	// The second hash is independent from the key, different images are not shared even if their keys collide
+	if (entryPtr != nullptr && (*entryPtr)->contentHash.check == contentHash.check && (*entryPtr)->width == texLoader.width() &&
+	    (*entryPtr)->height == texLoader.height() && (*entryPtr)->dataSize == texLoader.dataSize())
+	{
+		entry = *entryPtr;
+	}
+	else
+	{
+		nctl::UniquePtr<Entry> newEntry = nctl::makeUnique<Entry>();
+		upload(*newEntry, texLoader);
+		newEntry->contentHash = contentHash;
+		entry = newEntry.get();
+		entries_.pushBack(nctl::move(newEntry));
+
+		// A hash collision between different images keeps the first one in the map
+		if (entryPtr == nullptr)
+		{
+			reserveOne(contentHash_);
+			contentHash_.insert(contentHash.key, entry);
+		}
+	}
+
+	// The file is associated with its most recent content, without affecting the other files with the same pixels
+	if (path != nullptr && path[0] != '\0')
+	{
+		const nctl::String pathString(path);
+		Entry **pathEntryPtr = pathHash_.find(pathString);
+		if (pathEntryPtr != nullptr && *pathEntryPtr != entry)
+		{
+			removePath(**pathEntryPtr, pathString);
+			pathHash_.remove(pathString);
+			pathEntryPtr = nullptr;
+		}
+
+		if (pathEntryPtr == nullptr)
+		{
+			entry->paths.pushBack(pathString);
+			reserveOne(pathHash_);
+			pathHash_.insert(pathString, entry);
+		}
+	}
+
+	entry->refCount++;
+	return entry;
+}
+
+TextureRegistry::Entry *TextureRegistry::acquirePlaceholder()
+{
+	placeholder_->refCount++;
+	return placeholder_.get();
+}
+
+void TextureRegistry::release(Entry *entry)
+{
+	if (entry == nullptr)
+		return;
+
+	ASSERT(entry->refCount > 0);
+	entry->refCount--;
+	if (entry->refCount > 0)
+		return;
+
+	for (unsigned int i = 0; i < entry->paths.size(); i++)
+		pathHash_.remove(entry->paths[i]);
+	Entry **entryPtr = contentHash_.find(entry->contentHash.key);
+	if (entryPtr != nullptr && *entryPtr == entry)
+		contentHash_.remove(entry->contentHash.key);
+
+	for (unsigned int i = 0; i < entries_.size(); i++)
+	{
+		if (entries_[i].get() == entry)
+		{
+			entries_.removeAt(i);
+			break;
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#include <cstdio>
+#include <nctl/UniquePtr.h>
+#include <ncine/common_macros.h>
+#include <ncine/IFile.h>
+#include "bench/BenchmarkRunner.h"
+#include "file_utils.h"
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+BenchmarkRunner::BenchmarkRunner(float minTime, unsigned int minIterations)
+    : minTime_(minTime), minIterations_(minIterations), suite_(MaxNameLength), results_(64)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool BenchmarkRunner::saveJson(const char *filename) const
+{
+	nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(filename);
+	fileHandle->open(nc::IFile::OpenMode::WRITE | nc::IFile::OpenMode::BINARY);
+	if (fileHandle->isOpened() == false)
+		return false;
+
+	nc::IFile &file = *fileHandle;
+	const char header[] = "{\"results\":[\n";
+	file.write(header, sizeof(header) - 1);
+
+	char buffer[256];
+	for (unsigned int i = 0; i < results_.size(); i++)
+	{
+		const Result &result = results_[i];
+		const char suiteField[] = "{\"suite\":";
+		file.write(suiteField, sizeof(suiteField) - 1);
+		fileUtils::writeJsonString(file, result.suite.data());
+		const char nameField[] = ",\"name\":";
+		file.write(nameField, sizeof(nameField) - 1);
+		fileUtils::writeJsonString(file, result.name.data());
+
+		const double nsPerItem = (result.numItems > 0) ? result.meanTime * 1000000.0 / result.numItems : 0.0;
+		const int length = snprintf(buffer, sizeof(buffer), ",\"items\":%u,\"iterations\":%u,\"mean_ms\":%.6f,\"min_ms\":%.6f,\"ns_per_item\":%.3f}%s\n",
+		                            result.numItems, result.numIterations, result.meanTime, result.minTime, nsPerItem,
+		                            (i < results_.size() - 1) ? "," : "");
+		file.write(buffer, length);
+	}
+
+	const char footer[] = "]}\n";
+	file.write(footer, sizeof(footer) - 1);
+	file.close();
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void BenchmarkRunner::addResult(const char *name, unsigned int numItems, unsigned int numIterations, double totalTime, double minTime)
+{
+	Result result;
+	result.suite = suite_;
+	result.name = name;
+	result.numItems = numItems;
+	result.numIterations = numIterations;
+	result.meanTime = (numIterations > 0) ? totalTime * 1000.0 / numIterations : 0.0;
+	result.minTime = minTime * 1000.0;
+
+	LOGI_X("%s / %s: %.3f ms (min %.3f ms, %u iterations)", result.suite.data(), result.name.data(),
+	       result.meanTime, result.minTime, numIterations);
+	results_.pushBack(nctl::move(result));
+}
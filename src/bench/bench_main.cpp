@@ -0,0 +1,78 @@
+#include "bench/bench_main.h"
+#include "bench/bench_suites.h"
+#include "bench/BenchmarkRunner.h"
+#include "tools/headless.h"
+
+#include <ncine/common_macros.h>
+#include <ncine/Application.h>
+#include <ncine/AppConfiguration.h>
+#include <ncine/FileSystem.h>
+
+namespace {
+
+const char *DefaultOutputFilename = "spookyghost_bench.json";
+const char *DefaultWorkingDir = "spookyghost_bench_data";
+
+/// Every benchmark runs for at least this number of seconds and iterations
+const float MinTime = 0.5f;
+const unsigned int MinIterations = 5;
+
+}
+
+nctl::UniquePtr<nc::IAppEventHandler> createAppEventHandler()
+{
+	return nctl::makeUnique<BenchEventHandler>();
+}
+
+BenchEventHandler::BenchEventHandler()
+    : outputFilename_(nc::fs::MaxPathLength), workingDir_(nc::fs::MaxPathLength), hasRun_(false)
+{
+}
+
+void BenchEventHandler::onPreInit(nc::AppConfiguration &config)
+{
+	// Usage: spookyghost_bench [output.json] [working directory]
+	outputFilename_ = (config.argc() > 1) ? config.argv(1) : DefaultOutputFilename;
+	workingDir_ = (config.argc() > 2) ? config.argv(2) : DefaultWorkingDir;
+
+	headless::configure(config, "SpookyGhost Benchmarks");
+}
+
+void BenchEventHandler::onInit()
+{
+	headless::init();
+}
+
+void BenchEventHandler::onShutdown()
+{
+	headless::shutdown();
+}
+
+void BenchEventHandler::onFrameStart()
+{
+	if (hasRun_)
+		return;
+	hasRun_ = true;
+
+	if (bench::init(workingDir_.data()) == false)
+	{
+		LOGE_X("Cannot create the benchmark working directory \"%s\"", workingDir_.data());
+		nc::theApplication().quit();
+		return;
+	}
+
+	BenchmarkRunner runner(MinTime, MinIterations);
+	bench::runGridFunctions(runner);
+	bench::runEasingCurves(runner);
+	bench::runAnimationTrees(runner);
+	bench::runSpriteHierarchies(runner);
+	bench::runProjectSaving(runner);
+	bench::runFrameExport(runner);
+
+	if (runner.saveJson(outputFilename_.data()))
+		LOGI_X("Benchmark results saved to \"%s\"", outputFilename_.data());
+	else
+		LOGE_X("Cannot save the benchmark results to \"%s\"", outputFilename_.data());
+
+	nc::theApplication().quit();
+}
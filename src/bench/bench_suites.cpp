@@ -0,0 +1,301 @@
+#include <nctl/Array.h>
+#include <nctl/String.h>
+#include <nctl/UniquePtr.h>
+#include <ncine/FileSystem.h>
+#include "bench/bench_suites.h"
+#include "bench/BenchmarkRunner.h"
+#include "Canvas.h"
+#include "Texture.h"
+#include "Sprite.h"
+#include "SpriteManager.h"
+#include "EasingCurve.h"
+#include "PropertyAnimation.h"
+#include "GridAnimation.h"
+#include "GridFunction.h"
+#include "GridFunctionLibrary.h"
+#include "ParallelAnimationGroup.h"
+#include "AnimationManager.h"
+#include "ScriptManager.h"
+#include "LuaSaver.h"
+#include "BinarySaver.h"
+#include "tools/ProjectGenerator.h"
+
+#include "singletons.h"
+
+namespace {
+
+const float FrameTime = 1.0f / 60.0f;
+const int GridTextureSize = 128;
+const int SmallTextureSize = 16;
+const unsigned int NumCurveSamples = 100000;
+const unsigned int NumAnimatedSprites = 64;
+const unsigned int NumExportFrames = 30;
+
+nctl::String workingDir(nc::fs::MaxPathLength);
+nctl::UniquePtr<ProjectGenerator> generator;
+nctl::String pathString(nc::fs::MaxPathLength);
+nctl::String nameString(BenchmarkRunner::MaxNameLength);
+/// Written by the curve benchmarks so that the evaluation is not optimized away
+volatile float curveSink = 0.0f;
+
+Texture *createTexture(const char *name, int size)
+{
+	return generator->addTexture(*theSpriteMgr, name, size, nc::Colorf::White);
+}
+
+Sprite *addCenteredSprite(SpriteEntry *selected, Texture *texture)
+{
+	Sprite *sprite = theSpriteMgr->addSprite(selected, texture);
+	sprite->x = theCanvas->texWidth() * 0.5f;
+	sprite->y = theCanvas->texHeight() * 0.5f;
+	return sprite;
+}
+
+void clearProject()
+{
+	theAnimMgr->clear();
+	theSpriteMgr->clear();
+	theScriptingMgr->clear();
+}
+
+void addPropertyAnimation(AnimationGroup &parent, Sprite *sprite, Properties::Types property)
+{
+	nctl::UniquePtr<PropertyAnimation> anim = nctl::makeUnique<PropertyAnimation>(sprite);
+	anim->setProperty(property);
+	anim->curve().loop().setMode(Loop::Mode::PING_PONG);
+	anim->setParent(&parent);
+	parent.anims().pushBack(nctl::move(anim));
+}
+
+ParallelAnimationGroup *addParallelGroup(AnimationGroup &parent)
+{
+	nctl::UniquePtr<ParallelAnimationGroup> animGroup = nctl::makeUnique<ParallelAnimationGroup>();
+	animGroup->setParent(&parent);
+	parent.anims().pushBack(nctl::move(animGroup));
+	return static_cast<ParallelAnimationGroup *>(parent.anims().back().get());
+}
+
+/// Fills the root group with parallel groups of property animations, the groups are counted as nodes
+void populateAnimationTree(unsigned int numNodes, const nctl::Array<Sprite *> &sprites)
+{
+	const unsigned int AnimsPerGroup = 7;
+	const Properties::Types AnimatedProperties[] = { Properties::Types::POSITION_X, Properties::Types::POSITION_Y, Properties::Types::ROTATION };
+
+	unsigned int numAdded = 0;
+	while (numAdded < numNodes)
+	{
+		ParallelAnimationGroup *animGroup = addParallelGroup(theAnimMgr->animGroup());
+		numAdded++;
+		for (unsigned int i = 0; i < AnimsPerGroup && numAdded < numNodes; i++)
+		{
+			addPropertyAnimation(*animGroup, sprites[numAdded % sprites.size()], AnimatedProperties[numAdded % 3]);
+			numAdded++;
+		}
+	}
+}
+
+/// Children are attached in breadth-first order, with one child per sprite the hierarchy is a single chain
+Sprite *populateHierarchy(Texture *texture, unsigned int numSprites, unsigned int numChildren)
+{
+	nctl::Array<Sprite *> sprites(numSprites);
+	for (unsigned int i = 0; i < numSprites; i++)
+	{
+		Sprite *sprite = theSpriteMgr->addSprite(nullptr, texture);
+		// Transparent sprites are culled, only their transformations are measured
+		sprite->color = nc::Colorf(1.0f, 1.0f, 1.0f, 0.0f);
+		sprite->rotation = 1.0f;
+		if (i > 0)
+		{
+			sprite->x = 1.0f;
+			sprite->setParent(sprites[(i - 1) / numChildren]);
+		}
+		sprites.pushBack(sprite);
+	}
+	theSpriteMgr->updateSpritesArray();
+
+	return sprites[0];
+}
+
+}
+
+namespace bench {
+
+bool init(const char *dirName)
+{
+	workingDir = dirName;
+	if (nc::fs::isDirectory(workingDir.data()) == false && nc::fs::createDir(workingDir.data()) == false)
+		return false;
+
+	theCfg.texturesPath = workingDir;
+	theCfg.projectsPath = workingDir;
+	theCfg.scriptsPath = workingDir;
+	generator = nctl::makeUnique<ProjectGenerator>(workingDir.data());
+	return true;
+}
+
+void runGridFunctions(BenchmarkRunner &runner)
+{
+	runner.setSuite("Grid Functions");
+	Texture *texture = createTexture("bench_grid.png", GridTextureSize);
+	Sprite *sprite = addCenteredSprite(nullptr, texture);
+	theSpriteMgr->updateSpritesArray();
+	const unsigned int numVertices = sprite->interleavedVertices().size();
+
+	const nctl::Array<GridFunction> &functions = GridFunctionLibrary::gridFunctions();
+	for (unsigned int i = 0; i < functions.size(); i++)
+	{
+		nctl::UniquePtr<GridAnimation> gridAnim = nctl::makeUnique<GridAnimation>(sprite);
+		gridAnim->setFunction(&functions[i]);
+		// Halfway through the curve, as some functions do nothing at its start
+		gridAnim->curve().setTime(0.5f);
+
+		GridAnimation *anim = gridAnim.get();
+		runner.run(functions[i].name().data(), numVertices, [sprite, anim]() {
+			sprite->resetGrid();
+			anim->perform();
+		});
+	}
+
+	clearProject();
+}
+
+void runEasingCurves(BenchmarkRunner &runner)
+{
+	runner.setSuite("Easing Curves");
+	const char *TypeNames[] = { "Linear", "Quad", "Cubic", "Quart", "Quint", "Sine", "Expo", "Circ" };
+	static_assert(sizeof(TypeNames) / sizeof(TypeNames[0]) == EasingCurve::NumTypes, "Every easing curve type needs a name");
+
+	for (unsigned int i = 0; i < EasingCurve::NumTypes; i++)
+	{
+		EasingCurve curve(static_cast<EasingCurve::Type>(i), Loop::Mode::PING_PONG);
+		runner.run(TypeNames[i], NumCurveSamples, [&curve]() {
+			float sum = 0.0f;
+			for (unsigned int j = 0; j < NumCurveSamples; j++)
+			{
+				curve.next(FrameTime);
+				sum += curve.value();
+			}
+			curveSink = sum;
+		});
+	}
+}
+
+void runAnimationTrees(BenchmarkRunner &runner)
+{
+	runner.setSuite("Animation Manager");
+	Texture *texture = createTexture("bench_small.png", SmallTextureSize);
+	nctl::Array<Sprite *> sprites(NumAnimatedSprites);
+	for (unsigned int i = 0; i < NumAnimatedSprites; i++)
+		sprites.pushBack(addCenteredSprite(nullptr, texture));
+	theSpriteMgr->updateSpritesArray();
+
+	const unsigned int TreeSizes[] = { 10, 1000, 100000 };
+	for (unsigned int i = 0; i < sizeof(TreeSizes) / sizeof(TreeSizes[0]); i++)
+	{
+		populateAnimationTree(TreeSizes[i], sprites);
+		theAnimMgr->play();
+
+		nameString.format("%u nodes", TreeSizes[i]);
+		runner.run(nameString.data(), TreeSizes[i], []() { theAnimMgr->update(FrameTime); });
+
+		theAnimMgr->stop();
+		theAnimMgr->clear();
+	}
+
+	clearProject();
+}
+
+void runSpriteHierarchies(BenchmarkRunner &runner)
+{
+	runner.setSuite("Sprite Manager");
+	struct Hierarchy
+	{
+		unsigned int numSprites;
+		unsigned int numChildren;
+	};
+	const Hierarchy Hierarchies[] = { { 100, 1 }, { 1000, 1 }, { 10000, 1 }, { 10000, 4 } };
+
+	for (unsigned int i = 0; i < sizeof(Hierarchies) / sizeof(Hierarchies[0]); i++)
+	{
+		const Hierarchy &hierarchy = Hierarchies[i];
+		Texture *texture = createTexture("bench_small.png", SmallTextureSize);
+		Sprite *root = populateHierarchy(texture, hierarchy.numSprites, hierarchy.numChildren);
+		root->x = theCanvas->texWidth() * 0.5f;
+		root->y = theCanvas->texHeight() * 0.5f;
+
+		if (hierarchy.numChildren == 1)
+			nameString.format("Chain of %u", hierarchy.numSprites);
+		else
+			nameString.format("Tree of %u with %u children", hierarchy.numSprites, hierarchy.numChildren);
+
+		// A dirty root transforms the whole hierarchy again
+		runner.run(nameString.data(), hierarchy.numSprites, [root]() {
+			root->markDirty();
+			theSpriteMgr->update();
+		});
+
+		clearProject();
+	}
+}
+
+void runProjectSaving(BenchmarkRunner &runner)
+{
+	runner.setSuite("Project Saving");
+	LuaSaver::Data data(*theCanvas, *theSpriteMgr, *theScriptingMgr, *theAnimMgr);
+
+	const unsigned int ScaleFactors[] = { 1, 10, 100 };
+	const char *Extensions[] = { "lua", BinarySaver::Extension };
+	for (unsigned int i = 0; i < sizeof(ScaleFactors) / sizeof(ScaleFactors[0]); i++)
+	{
+		ProjectGenerator::Parameters params;
+		params.scale(ScaleFactors[i]);
+		generator->generate(params, data);
+		const unsigned int numItems = params.numSprites + params.numAnimations();
+
+		// Textures outside of the project keep the registry entries alive, loading does not decode the images again
+		nctl::Array<nctl::UniquePtr<Texture>> textureReferences(theSpriteMgr->textures().size());
+		for (unsigned int j = 0; j < theSpriteMgr->textures().size(); j++)
+			textureReferences.pushBack(nctl::makeUnique<Texture>(theSpriteMgr->textures()[j]->path().data()));
+
+		for (unsigned int j = 0; j < sizeof(Extensions) / sizeof(Extensions[0]); j++)
+		{
+			nameString.format("bench_project_%ux.%s", ScaleFactors[i], Extensions[j]);
+			const nctl::String filename = nc::fs::joinPath(workingDir, nameString);
+
+			nameString.format("Save %ux project (%s)", ScaleFactors[i], Extensions[j]);
+			runner.run(nameString.data(), numItems, [&filename, &data]() { theSaver->save(filename.data(), data); });
+			nameString.format("Load %ux project (%s)", ScaleFactors[i], Extensions[j]);
+			runner.run(nameString.data(), numItems, [&filename, &data]() { theSaver->load(filename.data(), data); });
+		}
+
+		clearProject();
+	}
+}
+
+void runFrameExport(BenchmarkRunner &runner)
+{
+	runner.setSuite("Frame Export");
+	LuaSaver::Data data(*theCanvas, *theSpriteMgr, *theScriptingMgr, *theAnimMgr);
+	generator->generate(ProjectGenerator::Parameters(), data);
+	theAnimMgr->play();
+
+	nameString.format("%u frames of %dx%d", NumExportFrames, theCanvas->texWidth(), theCanvas->texHeight());
+	runner.run(nameString.data(), NumExportFrames, []() {
+		for (unsigned int i = 0; i < NumExportFrames; i++)
+		{
+			theCanvas->bind();
+			theAnimMgr->update(FrameTime);
+			theSpriteMgr->update();
+			theCanvas->unbind();
+
+			pathString.format("bench_frame_%03u.png", i);
+			pathString = nc::fs::joinPath(workingDir, pathString);
+			theCanvas->save(pathString.data());
+		}
+	});
+
+	theAnimMgr->stop();
+	clearProject();
+}
+
+}
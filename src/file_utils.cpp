@@ -0,0 +1,45 @@
+#include <cstdio>
+#include <cstring>
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#endif
+
+#include "file_utils.h"
+#include <ncine/IFile.h>
+
+namespace fileUtils {
+
+bool replaceFile(const char *source, const char *destination)
+{
+#if defined(_WIN32)
+	return (MoveFileExA(source, destination, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+	return (rename(source, destination) == 0);
+#endif
+}
+
+void writeJsonString(nc::IFile &file, const char *string)
+{
+	file.write("\"", 1);
+	// Characters that need no escaping are written in runs
+	const char *run = string;
+	for (const char *c = string; *c != '\0'; c++)
+	{
+		const unsigned char character = static_cast<unsigned char>(*c);
+		if (character != '"' && character != '\\' && character >= ' ')
+			continue;
+
+		file.write(run, static_cast<unsigned int>(c - run));
+		char escape[8];
+		const int length = (character >= ' ') ? snprintf(escape, sizeof(escape), "\\%c", character)
+		                                      : snprintf(escape, sizeof(escape), "\\u%04x", character);
+		file.write(escape, static_cast<unsigned int>(length));
+		run = c + 1;
+	}
+	file.write(run, static_cast<unsigned int>(strlen(run)));
+	file.write("\"", 1);
+}
+
+}
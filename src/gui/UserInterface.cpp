@@ -1,4 +1,5 @@
 #include <ctime>
+#include <cstring>
 #include "gui/gui_common.h"
 #include <ncine/imgui_internal.h>
 #include <ncine/InputEvents.h>
@@ -25,7 +26,10 @@
 #include "ScriptAnimation.h"
 #include "Sprite.h"
 #include "Texture.h"
+#include "TextureLoader.h"
 #include "ScriptManager.h"
+#include "BinarySaver.h"
+#include "FrameProfiler.h"
 
 #include "version.h"
 #include <ncine/version.h>
@@ -154,6 +158,8 @@ UserInterface::UserInterface()
 		if (nc::fs::isReadableFile(startupProject.data()))
 			openProject(startupProject.data());
 	}
+	if (lastLoadedProject_.isEmpty())
+		resetAutosave(nullptr);
 	if (theCfg.autoPlayOnStart)
 		theAnimMgr->play();
 
@@ -246,6 +252,7 @@ void UserInterface::moveSprite(int xDiff, int yDiff)
 		Sprite *sprite = selectedSpriteEntry_->toSprite();
 		sprite->x += xDiff;
 		sprite->y += yDiff;
+		sprite->markDirty();
 	}
 }
 
@@ -288,6 +295,7 @@ void UserInterface::menuNew()
 	theAnimMgr->clear();
 	theScriptingMgr->clear();
 	theSpriteMgr->clear();
+	resetAutosave(nullptr);
 }
 
 void UserInterface::menuOpen()
@@ -297,16 +305,14 @@ void UserInterface::menuOpen()
 	FileDialog::config.windowTitle = "Open project file";
 	FileDialog::config.okButton = Labels::Ok;
 	FileDialog::config.selectionType = FileDialog::SelectionType::FILE;
-	FileDialog::config.extensions = "lua\0\0";
+	FileDialog::config.extensions = "lua\0sgb\0\0";
 	FileDialog::config.action = FileDialog::Action::OPEN_PROJECT;
 	FileDialog::config.windowOpen = true;
 }
 
 void UserInterface::menuSave()
 {
-	theSaver->save(lastLoadedProject_.data(), saverData_);
-	ui::auxString.format("Saved project file \"%s\"\n", lastLoadedProject_.data());
-	pushStatusInfoMessage(ui::auxString.data());
+	saveProject(lastLoadedProject_.data());
 }
 
 void UserInterface::menuSaveAs()
@@ -341,9 +347,7 @@ void UserInterface::menuQuickSave()
 	fileName.setLength(length);
 	lastQuickSavedProject_ = nc::fs::joinPath(lastQuickSavedProject_, fileName);
 
-	theSaver->save(lastQuickSavedProject_.data(), saverData_);
-	ui::auxString.format("Saved project file \"%s\"\n", lastQuickSavedProject_.data());
-	pushStatusInfoMessage(ui::auxString.data());
+	saveProject(lastQuickSavedProject_.data());
 }
 
 void UserInterface::quit()
@@ -400,6 +404,8 @@ void UserInterface::reloadScript()
 
 void UserInterface::createGui()
 {
+	ProfileScope profileScope("GUI");
+
 	// Cache the initial value of the auto-suspension flag
 	static bool autoSuspensionState = nc::theApplication().autoSuspension();
 
@@ -423,6 +429,9 @@ void UserInterface::createGui()
 	renderGuiWindow_.create();
 
 	createFileDialog();
+	updateAutosave();
+	updateFileWatcher();
+	updateScriptNotices();
 
 	if (numFrames == 1)
 		ImGui::SetNextWindowFocus();
@@ -446,6 +455,7 @@ void UserInterface::createGui()
 		createVideoModePopup();
 
 	createConfigWindow();
+	createProfilerWindow();
 
 	deleteKeyPressed = false;
 	if (enableKeyboardNav)
@@ -485,6 +495,7 @@ bool UserInterface::openProject(const char *filename)
 		renderGuiWindow_.setResize(renderGuiWindow_.saveAnimStatus().canvasResize);
 
 		lastLoadedProject_ = filename;
+		resetAutosave(filename);
 		ui::auxString.format("Loaded project file \"%s\"\n", filename);
 		pushStatusInfoMessage(ui::auxString.data());
 
@@ -499,8 +510,39 @@ bool UserInterface::openProject(const char *filename)
 	}
 }
 
+bool UserInterface::saveProject(const char *filename)
+{
+	if (theSaver->save(filename, saverData_))
+	{
+		resetAutosave(filename);
+		ui::auxString.format("Saved project file \"%s\"\n", filename);
+		pushStatusInfoMessage(ui::auxString.data());
+
+		return true;
+	}
+	else
+	{
+		ui::auxString.format("Cannot save project file \"%s\"\n", filename);
+		pushStatusErrorMessage(ui::auxString.data());
+
+		return false;
+	}
+}
+
 bool UserInterface::loadTexture(const char *filename)
 {
+	// A file that is already part of the project is selected instead of being loaded again
+	for (unsigned int i = 0; i < theSpriteMgr->textures().size(); i++)
+	{
+		if (theSpriteMgr->textures()[i]->path() == filename)
+		{
+			selectedTextureIndex_ = i;
+			ui::auxString.format("Texture \"%s\" is already loaded", filename);
+			pushStatusInfoMessage(ui::auxString.data());
+			return true;
+		}
+	}
+
 	nctl::UniquePtr<Texture> texture = nctl::makeUnique<Texture>(filename);
 	const bool hasLoaded = postLoadTexture(texture, filename);
 
@@ -737,6 +779,9 @@ void UserInterface::createMenuBar()
 			if (ImGui::MenuItem(Labels::Configuration))
 				showConfigWindow = true;
 
+			if (ImGui::MenuItem(Labels::Profiler))
+				showProfilerWindow = true;
+
 			ImGui::Separator();
 
 			if (ImGui::MenuItem(Labels::Quit, "CTRL + Q"))
@@ -2087,6 +2132,8 @@ void UserInterface::createSpriteWindow()
 	if (selectedSpriteEntry_->isSprite())
 	{
 		Sprite &sprite = *selectedSpriteEntry_->toSprite();
+		// The widgets of this window can change the transformation of the selected sprite at any time
+		sprite.markDirty();
 
 		ImGui::InputText("Name", sprite.name.data(), Sprite::MaxNameLength,
 		                 ImGuiInputTextFlags_CallbackResize, ui::inputTextCallback, &sprite.name);
@@ -2886,6 +2933,120 @@ void UserInterface::createScriptAnimationGui(ScriptAnimation &anim)
 	createCurveAnimationGui(anim, limits);
 }
 
+void UserInterface::resetAutosave(const char *projectFilename)
+{
+#ifndef __EMSCRIPTEN__
+	// Every project has its own snapshot, opening another one never overwrites the snapshot of a crashed session
+	nctl::String projectName(nc::fs::MaxPathLength);
+	projectName = (projectFilename != nullptr) ? nc::fs::baseName(projectFilename) : "untitled";
+	const char *extension = strrchr(projectName.data(), '.');
+	const int nameLength = (extension != nullptr) ? static_cast<int>(extension - projectName.data()) : static_cast<int>(projectName.length());
+
+	ui::auxString.format("autosave_%.*s.%s", nameLength, projectName.data(), BinarySaver::Extension);
+	autosaver_.reset(nc::fs::joinPath(theCfg.projectsPath, ui::auxString).data(), saverData_);
+#endif
+}
+
+void UserInterface::updateAutosave()
+{
+#ifndef __EMSCRIPTEN__
+	autosaver_.update(static_cast<float>(theCfg.autosaveInterval), saverData_);
+
+	switch (autosaver_.consumeResult())
+	{
+		case Autosaver::Result::NONE:
+			break;
+		case Autosaver::Result::SAVED:
+			ui::auxString.format("Autosaved project file \"%s\"\n", autosaver_.filename().data());
+			pushStatusInfoMessage(ui::auxString.data());
+			break;
+		case Autosaver::Result::FAILED:
+			ui::auxString.format("Cannot autosave project file \"%s\"\n", autosaver_.filename().data());
+			pushStatusErrorMessage(ui::auxString.data());
+			break;
+	}
+#endif
+}
+
+void UserInterface::updateFileWatcher()
+{
+	if (FileWatcher::IsSupported == false)
+		return;
+
+	watchedFiles_.clear();
+	if (theCfg.watchFiles)
+	{
+		for (unsigned int i = 0; i < theSpriteMgr->textures().size(); i++)
+		{
+			const Texture &texture = *theSpriteMgr->textures()[i];
+			if (texture.path().isEmpty() == false)
+				watchedFiles_.pushBack(texture.path().data());
+		}
+		for (unsigned int i = 0; i < theScriptingMgr->scripts().size(); i++)
+		{
+			const Script &script = *theScriptingMgr->scripts()[i];
+			if (script.path().isEmpty() == false)
+				watchedFiles_.pushBack(script.path().data());
+		}
+	}
+	fileWatcher_.setFiles(watchedFiles_);
+
+	fileWatcher_.poll(changedFiles_);
+	for (unsigned int i = 0; i < changedFiles_.size(); i++)
+	{
+		const nctl::String &filename = changedFiles_[i];
+
+		bool hasReloadedTexture = false;
+		for (unsigned int j = 0; j < theSpriteMgr->textures().size(); j++)
+		{
+			Texture &texture = *theSpriteMgr->textures()[j];
+			if (texture.path() == filename)
+			{
+				theTextureLoader->reload(texture);
+				hasReloadedTexture = true;
+			}
+		}
+		if (hasReloadedTexture)
+		{
+			ui::auxString.format("Reloaded texture \"%s\"\n", filename.data());
+			pushStatusInfoMessage(ui::auxString.data());
+		}
+
+		for (unsigned int j = 0; j < theScriptingMgr->scripts().size(); j++)
+		{
+			Script *script = theScriptingMgr->scripts()[j].get();
+			if (script->path() != filename)
+				continue;
+
+			script->reload();
+			theAnimMgr->reloadScript(script);
+			if (script->canRun())
+			{
+				ui::auxString.format("Reloaded script \"%s\"\n", script->name().data());
+				pushStatusInfoMessage(ui::auxString.data());
+			}
+			else
+			{
+				ui::auxString.format("Reloaded script \"%s\", but it cannot run\n", script->name().data());
+				pushStatusErrorMessage(ui::auxString.data());
+			}
+		}
+	}
+}
+
+void UserInterface::updateScriptNotices()
+{
+	for (unsigned int i = 0; i < theScriptingMgr->scripts().size(); i++)
+	{
+		Script &script = *theScriptingMgr->scripts()[i];
+		if (script.consumeDisabledNotice())
+		{
+			ui::auxString.format("Script \"%s\" has been disabled for exceeding its budget", nc::fs::baseName(script.name().data()).data());
+			pushStatusErrorMessage(ui::auxString.data());
+		}
+	}
+}
+
 void UserInterface::createFileDialog()
 {
 	static nctl::String selection = nctl::String(nc::fs::MaxPathLength);
@@ -2899,8 +3060,12 @@ void UserInterface::createFileDialog()
 					numFrames = 0; // force focus on the canvas
 				break;
 			case FileDialog::Action::SAVE_PROJECT:
-				if (nc::fs::hasExtension(selection.data(), "lua") == false)
+				// The extension selects the project format, Lua is the default one
+				if (nc::fs::hasExtension(selection.data(), "lua") == false &&
+				    BinarySaver::isBinaryProject(selection.data()) == false)
+				{
 					selection = selection + ".lua";
+				}
 				if (nc::fs::isFile(selection.data()) && FileDialog::config.allowOverwrite == false)
 				{
 					ui::auxString.format("Cannot overwrite existing file \"%s\"\n", selection.data());
@@ -2909,13 +3074,10 @@ void UserInterface::createFileDialog()
 				else
 				{
 #ifdef __EMSCRIPTEN__
-					theSaver->save(nc::fs::baseName(selection.data()).data(), saverData_);
-					ui::auxString.format("Saved project file \"%s\"\n", nc::fs::baseName(selection.data()).data());
+					saveProject(nc::fs::baseName(selection.data()).data());
 #else
-					theSaver->save(selection.data(), saverData_);
-					ui::auxString.format("Saved project file \"%s\"\n", selection.data());
+					saveProject(selection.data());
 #endif
-					pushStatusInfoMessage(ui::auxString.data());
 				}
 				break;
 			case FileDialog::Action::LOAD_TEXTURE:
@@ -2954,6 +3116,7 @@ void UserInterface::SpriteProperties::save(Sprite &sprite)
 	sprite.scaleFactor.set(1.0f, 1.0f);
 	sprite.anchorPoint.set(0.0f, 0.0f);
 	sprite.color = nc::Colorf::White;
+	sprite.markDirty();
 
 	saved_ = true;
 }
@@ -2971,6 +3134,7 @@ void UserInterface::SpriteProperties::restore(Sprite &sprite)
 	sprite.scaleFactor = scaleFactor_;
 	sprite.anchorPoint = anchorPoint_;
 	sprite.color = color_;
+	sprite.markDirty();
 
 	saved_ = false;
 }
@@ -7,6 +7,9 @@
 #include "gui/gui_labels.h"
 #include "Configuration.h"
 #include "LuaSaver.h"
+#include "ScriptManager.h"
+#include "Script.h"
+#include "FileWatcher.h"
 
 bool UserInterface::showConfigWindow = false;
 
@@ -161,6 +164,7 @@ void UserInterface::createConfigWindow()
 	ImGui::NewLine();
 	ImGui::SliderInt("Canvas Width", &theCfg.canvasWidth, 0, 1024);
 	ImGui::SliderInt("Canvas Height", &theCfg.canvasHeight, 0, 1024);
+	ImGui::Checkbox("Compact Grid Vertices", &theCfg.compactVertices);
 
 	ImGui::NewLine();
 	if (ImGui::Checkbox("Automatic GUI Scaling", &theCfg.autoGuiScaling))
@@ -189,7 +193,32 @@ void UserInterface::createConfigWindow()
 
 	ImGui::Checkbox("Show Tips On Start", &theCfg.showTipsOnStart);
 
+#ifndef __EMSCRIPTEN__
+	ImGui::NewLine();
+	ImGui::Checkbox("Parallel Scripts", &theCfg.parallelScripts);
+	ImGui::BeginDisabled(theCfg.parallelScripts == false);
+	ImGui::SliderInt("Script Workers", &theCfg.numScriptWorkers, 0, 16, theCfg.numScriptWorkers == 0 ? "Auto" : "%d");
+	ImGui::EndDisabled();
+#endif
+
+	ImGui::NewLine();
+	ImGui::SliderInt("Script Instruction Budget", &theCfg.scriptInstructionBudget, 0, 1000, theCfg.scriptInstructionBudget == 0 ? "Unlimited" : "%d M");
+	ImGui::SliderInt("Script Time Budget", &theCfg.scriptTimeBudget, 0, 10000, theCfg.scriptTimeBudget == 0 ? "Unlimited" : "%d ms");
+
+#ifndef __EMSCRIPTEN__
+	ImGui::NewLine();
+	ImGui::SliderInt("Autosave Interval", &theCfg.autosaveInterval, 0, 600, theCfg.autosaveInterval == 0 ? "Disabled" : "%d s");
+#endif
+
+	if (FileWatcher::IsSupported)
+	{
+		ImGui::NewLine();
+		ImGui::Checkbox("Reload Changed Files", &theCfg.watchFiles);
+	}
+
 	sanitizeConfigValues();
+	theScriptingMgr->setParallelExecution(theCfg.parallelScripts, theCfg.numScriptWorkers);
+	Script::setBudget(theCfg.scriptInstructionBudget * 1000000UL, static_cast<float>(theCfg.scriptTimeBudget));
 
 	ImGui::NewLine();
 	if (ImGui::Button(Labels::Close))
@@ -219,6 +248,17 @@ void UserInterface::sanitizeConfigValues()
 	if (theCfg.canvasHeight < 16)
 		theCfg.canvasHeight = 16;
 
+	if (theCfg.numScriptWorkers < 0)
+		theCfg.numScriptWorkers = 0;
+	else if (theCfg.numScriptWorkers > 16)
+		theCfg.numScriptWorkers = 16;
+	if (theCfg.scriptInstructionBudget < 0)
+		theCfg.scriptInstructionBudget = 0;
+	if (theCfg.scriptTimeBudget < 0)
+		theCfg.scriptTimeBudget = 0;
+	if (theCfg.autosaveInterval < 0)
+		theCfg.autosaveInterval = 0;
+
 	if (theCfg.autoGuiScaling == false)
 	{
 		if (theCfg.guiScaling < 0.5f)
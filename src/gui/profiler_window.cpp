@@ -0,0 +1,193 @@
+#include <ncine/IGfxDevice.h>
+#include <ncine/Application.h>
+#include <ncine/FileSystem.h>
+
+#include "singletons.h"
+#include "gui/gui_common.h"
+#include "gui/UserInterface.h"
+#include "gui/gui_labels.h"
+#include "Configuration.h"
+#include "ScriptManager.h"
+#include "Script.h"
+#include "FrameProfiler.h"
+
+namespace {
+
+const char *TraceFilename = "spookyghost_trace.json";
+
+/// The same scope always gets the same color across frames
+ImU32 scopeColor(const char *name)
+{
+	unsigned int hash = 2166136261u;
+	for (unsigned int i = 0; name[i] != '\0'; i++)
+		hash = (hash ^ static_cast<unsigned char>(name[i])) * 16777619u;
+
+	const float hue = (hash % 360) / 360.0f;
+	return ImColor::HSV(hue, 0.45f, 0.85f);
+}
+
+void drawFlameGraph(const FrameProfiler::Frame &frame)
+{
+	unsigned int maxDepth = 0;
+	for (unsigned int i = 0; i < frame.scopes.size(); i++)
+		maxDepth = (frame.scopes[i].depth > maxDepth) ? frame.scopes[i].depth : maxDepth;
+
+	const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	const ImVec2 origin = ImGui::GetCursorScreenPos();
+	const ImVec2 size(ImGui::GetContentRegionAvail().x, rowHeight * (maxDepth + 1));
+	ImGui::InvisibleButton("FlameGraph", size);
+	const bool isHovered = ImGui::IsItemHovered();
+	const ImVec2 mousePos = ImGui::GetIO().MousePos;
+
+	// The whole width of the graph is the CPU time of the frame
+	const float timeScale = (frame.cpuTime > 0.0f) ? size.x / frame.cpuTime : 0.0f;
+	ImDrawList *drawList = ImGui::GetWindowDrawList();
+	for (unsigned int i = 0; i < frame.scopes.size(); i++)
+	{
+		const FrameProfiler::Scope &scope = frame.scopes[i];
+		const ImVec2 min(origin.x + scope.start * timeScale, origin.y + scope.depth * rowHeight);
+		ImVec2 max(min.x + scope.duration * timeScale, min.y + rowHeight - 1.0f);
+		if (max.x - min.x < 1.0f)
+			max.x = min.x + 1.0f;
+
+		drawList->AddRectFilled(min, max, scopeColor(scope.name));
+		if (ImGui::CalcTextSize(scope.name).x + 4.0f < max.x - min.x)
+			drawList->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32(0, 0, 0, 255), scope.name);
+
+		if (isHovered && mousePos.x >= min.x && mousePos.x < max.x && mousePos.y >= min.y && mousePos.y < max.y)
+			ImGui::SetTooltip("%s: %.3f ms", scope.name, scope.duration);
+	}
+}
+
+}
+
+bool UserInterface::showProfilerWindow = false;
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void UserInterface::createProfilerWindow()
+{
+	if (showProfilerWindow == false)
+		return;
+
+	nc::IGfxDevice &gfxDevice = nc::theApplication().gfxDevice();
+	const float scalingFactor = theCfg.autoGuiScaling ? gfxDevice.windowScalingFactor() : theCfg.guiScaling;
+	const ImVec2 guiWindowSize = ImVec2(720.0f * scalingFactor, 360.0f * scalingFactor);
+	ImGui::SetNextWindowSize(guiWindowSize, ImGuiCond_Once);
+	const ImVec2 guiWindowPos = ImVec2(ImGui::GetWindowViewport()->Size.x * 0.5f, ImGui::GetWindowViewport()->Size.y * 0.5f);
+	ImGui::SetNextWindowPos(guiWindowPos, ImGuiCond_Once, ImVec2(0.5f, 0.5f));
+	ImGui::Begin(Labels::Profiler, &showProfilerWindow, ImGuiWindowFlags_NoDocking);
+
+	if (ImGui::CollapsingHeader(Labels::FrameTime, ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		const unsigned int numFrames = FrameProfiler::numFrames();
+		if (numFrames == 0)
+			ImGui::TextUnformatted("No frame has been profiled yet");
+		else
+		{
+			if (ImGui::Button(Labels::SaveTrace))
+			{
+				const nctl::String filename = nc::fs::joinPath(theCfg.projectsPath, TraceFilename);
+				if (FrameProfiler::saveChromeTrace(filename.data()))
+				{
+					ui::auxString.format("Saved trace file \"%s\"\n", filename.data());
+					pushStatusInfoMessage(ui::auxString.data());
+				}
+				else
+				{
+					ui::auxString.format("Cannot save trace file \"%s\"\n", filename.data());
+					pushStatusErrorMessage(ui::auxString.data());
+				}
+			}
+			ImGui::SameLine();
+			const FrameProfiler::Frame &lastFrame = FrameProfiler::lastFrame();
+			ImGui::Text("CPU: %.3f ms, GPU: %.3f ms", lastFrame.cpuTime, lastFrame.gpuTime);
+
+			float cpuTimes[FrameProfiler::HistoryLength];
+			float gpuTimes[FrameProfiler::HistoryLength];
+			float maxTime = 0.0f;
+			for (unsigned int i = 0; i < numFrames; i++)
+			{
+				const FrameProfiler::Frame &frame = FrameProfiler::frame(numFrames - 1 - i);
+				cpuTimes[i] = frame.cpuTime;
+				gpuTimes[i] = frame.gpuTime;
+				maxTime = (frame.cpuTime > maxTime) ? frame.cpuTime : maxTime;
+				maxTime = (frame.gpuTime > maxTime) ? frame.gpuTime : maxTime;
+			}
+			const ImVec2 plotSize(0.0f, ImGui::GetTextLineHeight() * 3.0f);
+			ImGui::PlotLines("CPU (ms)", cpuTimes, numFrames, 0, nullptr, 0.0f, maxTime, plotSize);
+			ImGui::PlotLines("GPU (ms)", gpuTimes, numFrames, 0, nullptr, 0.0f, maxTime, plotSize);
+
+			drawFlameGraph(lastFrame);
+		}
+	}
+
+	nctl::Array<nctl::UniquePtr<Script>> &scripts = theScriptingMgr->scripts();
+	if (ImGui::CollapsingHeader(Labels::Scripts, ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		if (scripts.isEmpty())
+			ImGui::TextUnformatted("There are no loaded scripts");
+		else
+		{
+			if (ImGui::Button(Labels::Reset))
+			{
+				for (unsigned int i = 0; i < scripts.size(); i++)
+					scripts[i]->resetStatistics();
+			}
+			ImGui::SameLine();
+			ImGui::Text("Shared Lua heap: %.1f KiB", theScriptingMgr->heapSize() / 1024.0f);
+
+			const ImGuiTableFlags tableFlags = ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollX;
+			if (ImGui::BeginTable("ScriptsProfiler", 10, tableFlags))
+			{
+				ImGui::TableSetupColumn("Script");
+				ImGui::TableSetupColumn("Init (ms)");
+				ImGui::TableSetupColumn("Update (ms)");
+				ImGui::TableSetupColumn("Average (ms)");
+				ImGui::TableSetupColumn("Worst (ms)");
+				ImGui::TableSetupColumn("Calls");
+				ImGui::TableSetupColumn("Vertex Get/Set");
+				ImGui::TableSetupColumn("Global Writes");
+				ImGui::TableSetupColumn("Load (KiB)");
+				ImGui::TableSetupColumn("History");
+				ImGui::TableHeadersRow();
+
+				for (unsigned int i = 0; i < scripts.size(); i++)
+				{
+					const Script &script = *scripts[i];
+					const Script::Statistics &stats = script.statistics();
+
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(nc::fs::baseName(script.name().data()).data());
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", stats.initTime);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", stats.lastUpdateTime());
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", stats.averageUpdateTime());
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", stats.worstUpdateTime);
+					ImGui::TableNextColumn();
+					ImGui::Text("%u", stats.numUpdateCalls);
+					ImGui::TableNextColumn();
+					ImGui::Text("%u / %u", stats.numVertexGetterCalls, stats.numVertexSetterCalls);
+					ImGui::TableNextColumn();
+					ImGui::Text("%u", stats.numGlobalWrites);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.1f", stats.loadMemory / 1024.0f);
+					ImGui::TableNextColumn();
+					ImGui::PushID(static_cast<int>(i));
+					ImGui::PlotLines("##History", stats.updateTimes, Script::Statistics::HistoryLength, stats.historyIndex,
+					                 nullptr, 0.0f, stats.worstUpdateTime, ImVec2(120.0f * scalingFactor, ImGui::GetTextLineHeight()));
+					ImGui::PopID();
+				}
+				ImGui::EndTable();
+			}
+		}
+	}
+
+	ImGui::End();
+}
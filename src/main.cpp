@@ -18,6 +18,7 @@
 #include "singletons.h"
 #include "main.h"
 #include "RenderingResources.h"
+#include "FrameProfiler.h"
 #include "Canvas.h"
 #include "SpriteManager.h"
 #include "gui/gui_common.h"
@@ -31,6 +32,9 @@
 #include "SequentialAnimationGroup.h"
 #include "LuaSaver.h"
 #include "ScriptManager.h"
+#include "Script.h"
+#include "TextureLoader.h"
+#include "TextureRegistry.h"
 
 #include <ncine/Application.h>
 #include <ncine/FileSystem.h>
@@ -99,6 +103,12 @@ void MyEventHandler::onPreInit(nc::AppConfiguration &config)
 #endif
 
 	LuaSaver::setDefaultCfgFile(ui::auxString.data());
+#if defined(__ANDROID__)
+	Script::setCacheDirectory(nc::fs::joinPath(ui::androidCfgDir, "script_cache").data());
+#elif !defined(__EMSCRIPTEN__)
+	// The bytecode cache lives next to the configuration file
+	Script::setCacheDirectory(nc::fs::joinPath(nc::fs::dirName(ui::auxString.data()), "script_cache").data());
+#endif
 	if (nc::fs::isReadableFile(LuaSaver::defaultCfgFile().data()))
 	{
 		LuaSaver saver(4096);
@@ -160,29 +170,39 @@ void MyEventHandler::onInit()
 
 	RenderingResources::create();
 	GridFunctionLibrary::init();
+	theTextureRegistry = nctl::makeUnique<TextureRegistry>();
 
 	theCanvas = nctl::makeUnique<Canvas>(theCfg.canvasWidth, theCfg.canvasHeight);
 	theResizedCanvas = nctl::makeUnique<Canvas>();
 	theSpritesheet = nctl::makeUnique<Canvas>();
 	theSpriteMgr = nctl::makeUnique<SpriteManager>();
+	theTextureLoader = nctl::makeUnique<TextureLoader>(0);
 	theAnimMgr = nctl::makeUnique<AnimationManager>();
 	theSaver = nctl::makeUnique<LuaSaver>(32 * 1024);
 	theScriptingMgr = nctl::makeUnique<ScriptManager>();
+	theScriptingMgr->setParallelExecution(theCfg.parallelScripts, theCfg.numScriptWorkers);
+	Script::setBudget(theCfg.scriptInstructionBudget * 1000000UL, static_cast<float>(theCfg.scriptTimeBudget));
 
 	ui_ = nctl::makeUnique<UserInterface>();
 }
 
 void MyEventHandler::onShutdown()
 {
+	// Worker threads are joined while the rest of the application is still alive
+	theTextureLoader.reset(nullptr);
+	FrameProfiler::dispose();
 	RenderingResources::dispose();
 }
 
 void MyEventHandler::onFrameStart()
 {
+	FrameProfiler::beginFrame();
 	const float interval = nc::theApplication().interval();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
+	theTextureLoader->update();
 	theCanvas->bind();
+	FrameProfiler::beginGpuTimer();
 
 	const SaveAnim &saveAnimStatus = ui_->saveAnimStatus();
 	if (ui_->shouldSaveFrames() || ui_->shouldSaveSpritesheet())
@@ -199,6 +219,7 @@ void MyEventHandler::onFrameStart()
 		theAnimMgr->update(interval);
 	theSpriteMgr->update();
 
+	FrameProfiler::endGpuTimer();
 	theCanvas->unbind();
 
 	if (ui_->shouldSaveFrames() || ui_->shouldSaveSpritesheet())
@@ -249,7 +270,9 @@ void MyEventHandler::onFrameStart()
 			theAnimMgr->update(saveAnimStatus.inverseFps());
 	}
 
+	theScriptingMgr->updateStatistics();
 	ui_->createGui();
+	FrameProfiler::endFrame();
 }
 
 void MyEventHandler::onChangeScalingFactor(float factor)
@@ -57,6 +57,31 @@ void main()
 }
 )glsl";
 
+char const *const ShaderStrings::meshsprite_compact_vs = R"glsl(
+uniform mat4 projection;
+uniform mat4 modelView;
+uniform vec4 color;
+uniform vec4 texRect;
+uniform vec2 spriteSize;
+uniform float deltaScale;
+in vec2 aPositionDelta;
+out vec2 vTexCoords;
+out vec4 vColor;
+
+void main()
+{
+	// Rest positions and texture coordinates only depend on the index of the vertex in the grid
+	int gridColumns = int(spriteSize.x) + 1;
+	vec2 gridCoords = vec2(float(gl_VertexID % gridColumns) / spriteSize.x, float(gl_VertexID / gridColumns) / spriteSize.y);
+	vec2 aPosition = gridCoords - vec2(0.5, 0.5) + aPositionDelta * deltaScale;
+
+	vec4 position = vec4(aPosition.x * spriteSize.x, aPosition.y * spriteSize.y, 0.0, 1.0);
+	gl_Position = projection * modelView * position;
+	vTexCoords = vec2(gridCoords.x * texRect.x + texRect.y, gridCoords.y * texRect.z + texRect.w);
+	vColor = color;
+}
+)glsl";
+
 char const *const ShaderStrings::meshsprite_snap_vs = R"glsl(
 uniform mat4 projection;
 uniform mat4 modelView;
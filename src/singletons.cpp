@@ -1,6 +1,8 @@
 #include "singletons.h"
 
 Configuration theCfg;
+// Defined first so that it outlives every texture
+nctl::UniquePtr<TextureRegistry> theTextureRegistry;
 nctl::UniquePtr<Canvas> theCanvas;
 nctl::UniquePtr<Canvas> theResizedCanvas;
 nctl::UniquePtr<Canvas> theSpritesheet;
@@ -8,3 +10,4 @@ nctl::UniquePtr<SpriteManager> theSpriteMgr;
 nctl::UniquePtr<AnimationManager> theAnimMgr;
 nctl::UniquePtr<LuaSaver> theSaver;
 nctl::UniquePtr<ScriptManager> theScriptingMgr;
+nctl::UniquePtr<TextureLoader> theTextureLoader;
@@ -0,0 +1,317 @@
+#include <nctl/UniquePtr.h>
+#include <ncine/FileSystem.h>
+#include <ncine/IFile.h>
+#include <ncine/TextureSaverPng.h>
+#include "tools/ProjectGenerator.h"
+#include "Canvas.h"
+#include "Texture.h"
+#include "Sprite.h"
+#include "SpriteManager.h"
+#include "Script.h"
+#include "ScriptManager.h"
+#include "PropertyAnimation.h"
+#include "GridAnimation.h"
+#include "GridFunction.h"
+#include "GridFunctionLibrary.h"
+#include "ScriptAnimation.h"
+#include "ParallelAnimationGroup.h"
+#include "SequentialAnimationGroup.h"
+#include "AnimationManager.h"
+
+namespace {
+
+const uint64_t RandomSequence = 1;
+
+/// Every script rotates its sprite and adds a wave to the grid, with constants that differ between scripts
+const char *ScriptSource =
+    "-- Generated by spookyghost_generator\n"
+    "function update(value)\n"
+    "\tset_rotation(value * %.1f)\n"
+    "\tgrid.add_wave_x(%.2f, %.2f, value)\n"
+    "end\n";
+
+/// The maximum change of a property value over the animation curve
+float propertyRange(Properties::Types property)
+{
+	switch (property)
+	{
+		case Properties::Types::POSITION_X:
+		case Properties::Types::POSITION_Y:
+			return 64.0f;
+		case Properties::Types::ROTATION:
+			return 180.0f;
+		case Properties::Types::ANCHOR_X:
+		case Properties::Types::ANCHOR_Y:
+			return 8.0f;
+		default:
+			return 0.5f;
+	}
+}
+
+void setupCurve(EasingCurve &curve, nc::Random &random)
+{
+	curve.setType(static_cast<EasingCurve::Type>(random.integer(0, EasingCurve::NumTypes)));
+	curve.loop().setMode(random.integer(0, 2) == 0 ? Loop::Mode::REWIND : Loop::Mode::PING_PONG);
+}
+
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS and DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+ProjectGenerator::ProjectGenerator(const char *outputDir)
+    : outputDir_(outputDir), auxString_(nc::fs::MaxPathLength)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void ProjectGenerator::Parameters::scale(unsigned int factor)
+{
+	numTextures *= factor;
+	numScripts *= factor;
+	numSprites *= factor;
+	numPropertyAnims *= factor;
+	numGridAnims *= factor;
+	numScriptAnims *= factor;
+}
+
+void ProjectGenerator::generate(const Parameters &params, LuaSaver::Data &data)
+{
+	random_.init(params.seed, RandomSequence);
+
+	data.spriteMgr.clear();
+	data.scriptMgr.clear();
+	data.animMgr.clear();
+
+	for (unsigned int i = 0; i < params.numTextures; i++)
+	{
+		auxString_.format("generated_texture_%03u.png", i);
+		addTexture(data.spriteMgr, auxString_.data(), params.textureSize, randomColor());
+	}
+
+	for (unsigned int i = 0; i < params.numScripts; i++)
+	{
+		auxString_.format("generated_script_%03u.lua", i);
+		addScript(data.scriptMgr, auxString_.data());
+	}
+
+	nctl::Array<Sprite *> sprites;
+	addSprites(params, data, sprites);
+	addAnimations(params, data, sprites);
+}
+
+Texture *ProjectGenerator::addTexture(SpriteManager &spriteMgr, const char *name, int size, const nc::Colorf &color)
+{
+	nctl::UniquePtr<unsigned char[]> pixels = nctl::makeUnique<unsigned char[]>(size * size * 4);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			unsigned char *pixel = pixels.get() + (y * size + x) * 4;
+			const float brightness = ((x / 8 + y / 8) % 2 == 0) ? 1.0f : 0.25f;
+			pixel[0] = static_cast<unsigned char>(color.r() * brightness * 255.0f);
+			pixel[1] = static_cast<unsigned char>(color.g() * brightness * 255.0f);
+			pixel[2] = static_cast<unsigned char>(color.b() * brightness * 255.0f);
+			pixel[3] = 255;
+		}
+	}
+
+	nc::TextureSaverPng saver;
+	nc::ITextureSaver::Properties props;
+	props.width = size;
+	props.height = size;
+	props.pixels = pixels.get();
+	props.format = nc::ITextureSaver::Format::RGBA8;
+	const nctl::String filename = nc::fs::joinPath(outputDir_, name);
+	saver.saveToFile(props, filename.data());
+
+	nctl::UniquePtr<Texture> texture = nctl::makeUnique<Texture>(filename.data());
+	texture->setName(name);
+	spriteMgr.textures().pushBack(nctl::move(texture));
+	return spriteMgr.textures().back().get();
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+Script *ProjectGenerator::addScript(ScriptManager &scriptMgr, const char *name)
+{
+	nctl::String source(256);
+	source.format(ScriptSource, random_.real(90.0f, 360.0f), random_.real(0.05f, 0.5f), random_.real(1.0f, 4.0f));
+
+	const nctl::String filename = nc::fs::joinPath(outputDir_, name);
+	nctl::UniquePtr<nc::IFile> fileHandle = nc::IFile::createFileHandle(filename.data());
+	fileHandle->open(nc::IFile::OpenMode::WRITE | nc::IFile::OpenMode::BINARY);
+	if (fileHandle->isOpened())
+	{
+		fileHandle->write(source.data(), source.length());
+		fileHandle->close();
+	}
+
+	nctl::UniquePtr<Script> script = nctl::makeUnique<Script>(filename.data());
+	script->setName(name);
+	scriptMgr.scripts().pushBack(nctl::move(script));
+	return scriptMgr.scripts().back().get();
+}
+
+void ProjectGenerator::addSprites(const Parameters &params, LuaSaver::Data &data, nctl::Array<Sprite *> &sprites)
+{
+	nctl::Array<nctl::UniquePtr<Texture>> &textures = data.spriteMgr.textures();
+	if (textures.isEmpty())
+		return;
+
+	const float canvasWidth = static_cast<float>(data.canvas.texWidth());
+	const float canvasHeight = static_cast<float>(data.canvas.texHeight());
+	const float maxOffset = static_cast<float>(params.textureSize);
+
+	nctl::Array<SpriteGroup *> openGroups;
+	SpriteGroup *spriteGroup = nullptr;
+	for (unsigned int i = 0; i < params.numSprites; i++)
+	{
+		if (params.groupDepth > 0 && params.spritesPerGroup > 0 && i % params.spritesPerGroup == 0)
+			spriteGroup = openSpriteGroup(data.spriteMgr, openGroups, params.groupDepth, i / params.spritesPerGroup);
+
+		Texture *texture = textures[random_.integer(0, textures.size())].get();
+		Sprite *sprite = data.spriteMgr.addSprite(spriteGroup, texture);
+		auxString_.format("Sprite%u", i);
+		sprite->name = auxString_;
+		sprite->entryColor() = randomColor();
+		sprite->rotation = random_.real(-45.0f, 45.0f);
+
+		// Sprites at the start of a chain are placed on the canvas, the others near their parent
+		if (params.hierarchyDepth > 1 && i % params.hierarchyDepth != 0)
+		{
+			sprite->x = random_.real(-maxOffset, maxOffset);
+			sprite->y = random_.real(-maxOffset, maxOffset);
+			sprite->setParent(sprites.back());
+		}
+		else
+		{
+			sprite->x = random_.real(0.0f, canvasWidth);
+			sprite->y = random_.real(0.0f, canvasHeight);
+		}
+		sprites.pushBack(sprite);
+	}
+
+	data.spriteMgr.updateSpritesArray();
+}
+
+void ProjectGenerator::addAnimations(const Parameters &params, LuaSaver::Data &data, const nctl::Array<Sprite *> &sprites)
+{
+	if (sprites.isEmpty())
+		return;
+
+	const nctl::Array<GridFunction> &functions = GridFunctionLibrary::gridFunctions();
+	nctl::Array<nctl::UniquePtr<Script>> &scripts = data.scriptMgr.scripts();
+	unsigned int numPropertyAnims = params.numPropertyAnims;
+	unsigned int numGridAnims = functions.isEmpty() ? 0 : params.numGridAnims;
+	unsigned int numScriptAnims = scripts.isEmpty() ? 0 : params.numScriptAnims;
+	const unsigned int numAnims = numPropertyAnims + numGridAnims + numScriptAnims;
+
+	AnimationGroup &root = data.animMgr.animGroup();
+	nctl::Array<AnimationGroup *> openGroups;
+	AnimationGroup *animGroup = &root;
+	for (unsigned int i = 0; i < numAnims; i++)
+	{
+		if (params.animGroupDepth > 0 && params.animsPerGroup > 0 && i % params.animsPerGroup == 0)
+			animGroup = openAnimationGroup(root, openGroups, params.animGroupDepth, i / params.animsPerGroup);
+
+		Sprite *sprite = sprites[random_.integer(0, sprites.size())];
+		CurveAnimation *anim = nullptr;
+
+		// The types are interleaved by picking them with a probability proportional to the remaining counts
+		const unsigned int pick = random_.integer(0, numPropertyAnims + numGridAnims + numScriptAnims);
+		if (pick < numPropertyAnims)
+		{
+			nctl::UniquePtr<PropertyAnimation> propertyAnim = nctl::makeUnique<PropertyAnimation>(sprite);
+			const Properties::Types property = static_cast<Properties::Types>(random_.integer(1, Properties::Count));
+			propertyAnim->setProperty(property);
+			if (propertyAnim->property() != nullptr)
+			{
+				propertyAnim->curve().setShift(*propertyAnim->property());
+				propertyAnim->curve().setScale(random_.real(-1.0f, 1.0f) * propertyRange(property));
+			}
+			anim = propertyAnim.get();
+			animGroup->anims().pushBack(nctl::move(propertyAnim));
+			numPropertyAnims--;
+		}
+		else if (pick < numPropertyAnims + numGridAnims)
+		{
+			nctl::UniquePtr<GridAnimation> gridAnim = nctl::makeUnique<GridAnimation>(sprite);
+			gridAnim->setFunction(&functions[random_.integer(0, functions.size())]);
+			anim = gridAnim.get();
+			animGroup->anims().pushBack(nctl::move(gridAnim));
+			numGridAnims--;
+		}
+		else
+		{
+			Script *script = scripts[random_.integer(0, scripts.size())].get();
+			nctl::UniquePtr<ScriptAnimation> scriptAnim = nctl::makeUnique<ScriptAnimation>(sprite, script);
+			anim = scriptAnim.get();
+			animGroup->anims().pushBack(nctl::move(scriptAnim));
+			numScriptAnims--;
+		}
+
+		setupCurve(anim->curve(), random_);
+		anim->setSpeed(random_.real(0.5f, 2.0f));
+		auxString_.format("Anim%u", i);
+		anim->name = auxString_;
+		anim->setParent(animGroup);
+	}
+}
+
+SpriteGroup *ProjectGenerator::openSpriteGroup(SpriteManager &spriteMgr, nctl::Array<SpriteGroup *> &openGroups, unsigned int maxDepth, unsigned int id)
+{
+	const unsigned int depth = randomDepth(openGroups.size(), maxDepth);
+	while (openGroups.size() > depth)
+		openGroups.popBack();
+
+	SpriteGroup *parent = openGroups.isEmpty() ? nullptr : openGroups.back();
+	SpriteGroup *spriteGroup = spriteMgr.addGroup(parent);
+	auxString_.format("Group%u", id);
+	spriteGroup->name() = auxString_;
+	spriteGroup->entryColor() = randomColor();
+
+	openGroups.pushBack(spriteGroup);
+	return spriteGroup;
+}
+
+AnimationGroup *ProjectGenerator::openAnimationGroup(AnimationGroup &root, nctl::Array<AnimationGroup *> &openGroups, unsigned int maxDepth, unsigned int id)
+{
+	const unsigned int depth = randomDepth(openGroups.size(), maxDepth);
+	while (openGroups.size() > depth)
+		openGroups.popBack();
+
+	AnimationGroup *parent = openGroups.isEmpty() ? &root : openGroups.back();
+	// Mostly parallel groups, as sequential ones play a single animation at a time
+	if (random_.integer(0, 4) == 0)
+		parent->anims().pushBack(nctl::makeUnique<SequentialAnimationGroup>());
+	else
+		parent->anims().pushBack(nctl::makeUnique<ParallelAnimationGroup>());
+
+	AnimationGroup *animGroup = static_cast<AnimationGroup *>(parent->anims().back().get());
+	animGroup->loop().setMode(Loop::Mode::REWIND);
+	auxString_.format("AnimGroup%u", id);
+	animGroup->name = auxString_;
+	animGroup->setParent(parent);
+
+	openGroups.pushBack(animGroup);
+	return animGroup;
+}
+
+unsigned int ProjectGenerator::randomDepth(unsigned int numOpenGroups, unsigned int maxDepth)
+{
+	// A group can only be nested in one that is still open
+	const unsigned int depth = random_.integer(0, maxDepth);
+	return (depth < numOpenGroups) ? depth : numOpenGroups;
+}
+
+nc::Colorf ProjectGenerator::randomColor()
+{
+	return nc::Colorf(random_.real(0.25f, 1.0f), random_.real(0.25f, 1.0f), random_.real(0.25f, 1.0f), 1.0f);
+}
@@ -0,0 +1,91 @@
+#include <cstdlib>
+#include "singletons.h"
+#include "tools/generator_main.h"
+#include "tools/ProjectGenerator.h"
+#include "tools/headless.h"
+#include "Canvas.h"
+#include "SpriteManager.h"
+#include "AnimationManager.h"
+#include "LuaSaver.h"
+#include "ScriptManager.h"
+
+#include <ncine/common_macros.h>
+#include <ncine/Application.h>
+#include <ncine/AppConfiguration.h>
+#include <ncine/FileSystem.h>
+
+namespace {
+
+const char *DefaultOutputDir = "generated_projects";
+/// The workloads generated when no scale factor is specified
+const unsigned int DefaultScaleFactors[] = { 1, 10, 100 };
+
+}
+
+nctl::UniquePtr<nc::IAppEventHandler> createAppEventHandler()
+{
+	return nctl::makeUnique<GeneratorEventHandler>();
+}
+
+GeneratorEventHandler::GeneratorEventHandler()
+    : outputDir_(nc::fs::MaxPathLength), scaleFactor_(0), seed_(1), hasRun_(false)
+{
+}
+
+void GeneratorEventHandler::onPreInit(nc::AppConfiguration &config)
+{
+	// Usage: spookyghost_generator [output directory] [scale factor] [seed]
+	outputDir_ = (config.argc() > 1) ? config.argv(1) : DefaultOutputDir;
+	if (config.argc() > 2)
+		scaleFactor_ = static_cast<unsigned int>(strtoul(config.argv(2), nullptr, 10));
+	if (config.argc() > 3)
+		seed_ = static_cast<unsigned int>(strtoul(config.argv(3), nullptr, 10));
+
+	headless::configure(config, "SpookyGhost Project Generator");
+}
+
+void GeneratorEventHandler::onInit()
+{
+	headless::init();
+}
+
+void GeneratorEventHandler::onShutdown()
+{
+	headless::shutdown();
+}
+
+void GeneratorEventHandler::onFrameStart()
+{
+	if (hasRun_)
+		return;
+	hasRun_ = true;
+
+	if (nc::fs::isDirectory(outputDir_.data()) == false && nc::fs::createDir(outputDir_.data()) == false)
+	{
+		LOGE_X("Cannot create the output directory \"%s\"", outputDir_.data());
+		nc::theApplication().quit();
+		return;
+	}
+
+	ProjectGenerator generator(outputDir_.data());
+	LuaSaver::Data data(*theCanvas, *theSpriteMgr, *theScriptingMgr, *theAnimMgr);
+	const unsigned int numScaleFactors = (scaleFactor_ > 0) ? 1 : sizeof(DefaultScaleFactors) / sizeof(DefaultScaleFactors[0]);
+	nctl::String filename(nc::fs::MaxPathLength);
+	for (unsigned int i = 0; i < numScaleFactors; i++)
+	{
+		const unsigned int scaleFactor = (scaleFactor_ > 0) ? scaleFactor_ : DefaultScaleFactors[i];
+		ProjectGenerator::Parameters params;
+		params.seed = seed_;
+		params.scale(scaleFactor);
+		generator.generate(params, data);
+
+		filename.format("generated_%ux.lua", scaleFactor);
+		filename = nc::fs::joinPath(outputDir_, filename);
+		if (theSaver->save(filename.data(), data))
+			LOGI_X("Project \"%s\" generated with %u sprites and %u animations", filename.data(), params.numSprites, params.numAnimations());
+		else
+			LOGE_X("Cannot save project \"%s\"", filename.data());
+	}
+
+	nc::theApplication().quit();
+}
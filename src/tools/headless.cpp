@@ -0,0 +1,59 @@
+#include "singletons.h"
+#include "tools/headless.h"
+#include "RenderingResources.h"
+#include "FrameProfiler.h"
+#include "Canvas.h"
+#include "SpriteManager.h"
+#include "AnimationManager.h"
+#include "GridFunctionLibrary.h"
+#include "LuaSaver.h"
+#include "Script.h"
+#include "ScriptManager.h"
+#include "TextureLoader.h"
+#include "TextureRegistry.h"
+
+#include <ncine/AppConfiguration.h>
+
+namespace headless {
+
+void configure(nc::AppConfiguration &config, const char *windowTitle)
+{
+	config.resolution.set(640, 360);
+	config.frameLimit = 0;
+	config.withVSync = false;
+
+	config.withScenegraph = false;
+	config.withAudio = false;
+	config.withDebugOverlay = false;
+	config.withThreads = false;
+
+	config.windowTitle = windowTitle;
+}
+
+void init()
+{
+	RenderingResources::create();
+	GridFunctionLibrary::init();
+	theTextureRegistry = nctl::makeUnique<TextureRegistry>();
+
+	theCanvas = nctl::makeUnique<Canvas>(theCfg.canvasWidth, theCfg.canvasHeight);
+	theResizedCanvas = nctl::makeUnique<Canvas>();
+	theSpritesheet = nctl::makeUnique<Canvas>();
+	theSpriteMgr = nctl::makeUnique<SpriteManager>();
+	theTextureLoader = nctl::makeUnique<TextureLoader>(0);
+	theAnimMgr = nctl::makeUnique<AnimationManager>();
+	theSaver = nctl::makeUnique<LuaSaver>(32 * 1024);
+	theScriptingMgr = nctl::makeUnique<ScriptManager>();
+	theScriptingMgr->setParallelExecution(theCfg.parallelScripts, theCfg.numScriptWorkers);
+	Script::setBudget(theCfg.scriptInstructionBudget * 1000000UL, static_cast<float>(theCfg.scriptTimeBudget));
+}
+
+void shutdown()
+{
+	// Worker threads are joined while the rest of the application is still alive
+	theTextureLoader.reset(nullptr);
+	FrameProfiler::dispose();
+	RenderingResources::dispose();
+}
+
+}